@@ -10,6 +10,7 @@
 
 #include "gameengine.h"
 #include "utils/mathlib.h"
+#include "settings.h"
 #include "renderer/vertextypes.h"
 #include "gameengine.h"
 #include "physics/motionstate.h"
@@ -668,19 +669,44 @@ void Engine::GameEngine::init()
 
 	m_pRenderSystem = new Renderer::RenderSystem(*this);
 
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Anims.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Anims_Addon.vdf");
+	// Map the archives into memory when we have the address-space for it
+	const bool mapArchives = sizeof(void*) >= 8;
 
 	//ZenConvert::zCModelAni ani("HUMANS-S_RUN.MAN", m_VdfsFileIndex);
-	
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Worlds.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Worlds_Addon.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Textures.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Meshes.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Meshes_Addon.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Textures_Addon.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/OpenZE.vdf");
-	m_VdfsFileIndex.loadVDF(BASE_DIR + "vdf/Anthera.mod");
+
+	// Catalogs of all archives are merged once and cached, until one of the archives changes
+	std::vector<std::string> archives = {
+		BASE_DIR + "vdf/Anims.vdf",
+		BASE_DIR + "vdf/Anims_Addon.vdf",
+		BASE_DIR + "vdf/Worlds.vdf",
+		BASE_DIR + "vdf/Worlds_Addon.vdf",
+		BASE_DIR + "vdf/Textures.vdf",
+		BASE_DIR + "vdf/Meshes.vdf",
+		BASE_DIR + "vdf/Meshes_Addon.vdf",
+		BASE_DIR + "vdf/Textures_Addon.vdf",
+		BASE_DIR + "vdf/OpenZE.vdf",
+		BASE_DIR + "vdf/Anthera.mod",
+	};
+
+	m_VdfsFileIndex.loadVDFsCached(archives, BASE_DIR + "vdf/index.cache", 0, mapArchives);
+
+	// Loose files override the archives, so changed assets can be tested without repacking
+	m_VdfsFileIndex.loadDirectory(BASE_DIR + "_work/data", VDFS::ARCHIVE_PHYSICAL_PRIORITY, mapArchives);
+
+	// Keep recently used files around, so meshes and textures shared between vobs are only read once
+	std::string cacheMegabytes;
+	if(m_pSettings->getArgument("vdfcache", cacheMegabytes))
+		m_VdfsFileIndex.setFileCacheBudget(static_cast<size_t>(strtoul(cacheMegabytes.c_str(), nullptr, 10)) * 1024 * 1024);
+
+	// Record which files the world needs, for repacking the archives in that order with vdftool
+	std::string traceFile;
+	const bool traceVdfs = m_pSettings->getArgument("vdftrace", traceFile);
+	if(traceVdfs)
+		m_VdfsFileIndex.startAccessTrace();
+
+	std::string statsFile;
+	const bool vdfStats = m_pSettings->getArgument("vdfstats", statsFile);
+	m_VdfsFileIndex.setRequestStatsEnabled(vdfStats);
 
 	//m_TestWorld = new ZenWorld(*this, "anthera_final1.zen", m_VdfsFileIndex);
 #ifndef NEW_WORLD
@@ -688,5 +714,15 @@ void Engine::GameEngine::init()
 #else
 	m_TestWorld = new ZenWorld(*this, "NewWorld.zen", m_VdfsFileIndex);
 #endif
+
+	if(traceVdfs)
+	{
+		m_VdfsFileIndex.stopAccessTrace();
+		if(m_VdfsFileIndex.saveAccessTrace(traceFile))
+			LogInfo() << "Wrote VDFS access-trace to: " << traceFile;
+	}
+
+	if(vdfStats && m_VdfsFileIndex.saveIoStats(statsFile))
+		LogInfo() << "Wrote VDFS I/O-stats to: " << statsFile;
 }
  
\ No newline at end of file
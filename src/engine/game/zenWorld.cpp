@@ -5,6 +5,10 @@
 #include "zenconvert/vob.h"
 #include "zenconvert/zCMesh.h"
 #include "vdfs/fileIndex.h"
+#include "vdfs/filePrefetcher.h"
+#include <set>
+#include <thread>
+#include <atomic>
 
 #include "zenconvert/zCProgMeshProto.h"
 #include "zenconvert/zenParser.h"
@@ -25,26 +29,62 @@
 
 using namespace Engine;
 
+namespace
+{
+	/**
+	 * @brief Name of the file holding the given texture, same naming as in Renderer::loadTexture
+	 */
+	std::string getTextureFile(const std::string& texture)
+	{
+		return texture.substr(0, texture.find_first_of('.')) + "-C.TEX";
+	}
+
+	/**
+	 * @brief Thread which gets asked to stop and is joined once this goes out of scope, also when that happens
+	 *		  through an exception
+	 */
+	struct ScopedWorker
+	{
+		std::atomic<bool> stop{false};
+		std::thread thread;
+
+		~ScopedWorker()
+		{
+			finish();
+		}
+
+		/**
+		 * @brief Asks the thread to stop and waits for it
+		 */
+		void finish()
+		{
+			stop = true;
+			if(thread.joinable())
+				thread.join();
+		}
+	};
+}
+
 ZenWorld::ZenWorld(::Engine::Engine& engine, const std::string & zenFile, VDFS::FileIndex & vdfs, float scale)
 {
 	m_pEngine = &engine;
 
 	m_WorldScale = scale;
 
-	// Load zen from vdfs
-	std::vector<uint8_t> data;
-	vdfs.getFileData(zenFile, data);
+	// Load zen from vdfs. Data only gets copied into storage if the archive isn't memory mapped.
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
 
 	// Try to load from disk if this isn't in a vdf-archive
-	if(data.empty())
+	if(!vdfs.getFileView(zenFile, view, &storage) || !view.size)
 	{
-		ZenConvert::ZenParser parser = ZenConvert::ZenParser(zenFile);
+		ZenConvert::ZenParser parser(zenFile);
 		loadWorld(engine, parser, vdfs, scale);
 	}
 	else
 	{
 		// Load from memory
-		ZenConvert::ZenParser parser = ZenConvert::ZenParser(data.data(), data.size());
+		ZenConvert::ZenParser parser(view.data, view.size);
 		loadWorld(engine, parser, vdfs, scale);
 	}
 }
@@ -68,11 +108,44 @@ void ZenWorld::loadWorld(::Engine::Engine& engine, ZenConvert::ZenParser& parser
 		return;
 	}
 
+	// Packing the world-mesh keeps the CPU busy for a while, get the disk going on the files of the vobs meanwhile
+	VDFS::FilePrefetcher prefetcher(vdfs);
+	std::vector<std::string> assets = collectWorldAssets(worldData, worldMesh, vdfs);
+	prefetcher.prefetch(assets);
+
+	// Textures of the vob-meshes are only known once those are read. Do that on the side, one mesh after another,
+	// so their textures get queued roughly in the order the vobs need them.
+	ScopedWorker meshTextures;
+	meshTextures.thread = std::thread([&]() {
+		std::set<std::string> known(assets.begin(), assets.end());
+
+		for(const std::string& file : assets)
+		{
+			if(meshTextures.stop.load(std::memory_order_relaxed))
+				return;
+
+			if(file.find(".MRM") == std::string::npos && file.find(".MDM") == std::string::npos && file.find(".MDL") == std::string::npos)
+				continue;
+
+			std::vector<std::string> textures;
+			for(std::string& t : collectMeshTextures(file, vdfs))
+			{
+				if(known.insert(t).second)
+					textures.push_back(std::move(t));
+			}
+
+			prefetcher.prefetch(textures);
+		}
+	});
+
 	if(worldMesh)
 		disectWorldMesh(worldMesh, engine, vdfs, scale);
 
 	parseWorldObjects(worldData, engine, vdfs, scale);
 
+	// Whatever wasn't found by now is of no use anymore
+	meshTextures.finish();
+
 #ifdef ZE_GAME
 	engine.renderSystemPtr()->getPagedVertexBuffer<Renderer::WorldVertex>().RebuildPages();
 	engine.renderSystemPtr()->getPagedVertexBuffer<Renderer::SkeletalVertex>().RebuildPages();
@@ -165,6 +238,112 @@ void ZenWorld::disectWorldMesh(ZenConvert::zCMesh* mesh, ::Engine::Engine& engin
 	}*/
 } 
 
+/**
+* @brief Collects the files needed for the world-mesh and the vobs, in the order they will be loaded
+*/
+std::vector<std::string> ZenWorld::collectWorldAssets(const ZenConvert::oCWorldData& data, const ZenConvert::zCMesh* worldMesh, const VDFS::FileIndex& vdfs)
+{
+	std::vector<std::string> files;
+	std::set<std::string> known;
+
+	auto add = [&](const std::string& file) {
+		if(vdfs.findFile(file) && known.insert(file).second)
+			files.push_back(file);
+	};
+
+	// Textures of the world-mesh, same naming as in Renderer::loadTexture
+	if(worldMesh)
+	{
+		for(const ZenConvert::zCMaterialData& m : worldMesh->getMaterials())
+		{
+			if(!m.texture.empty())
+				add(getTextureFile(m.texture));
+		}
+	}
+
+	// Meshes of the vobs, probed the same way as in spawnVob. Children first, like parseWorldObjects does.
+	std::function<void(const std::vector<ZenConvert::zCVobData>&)> fn = [&](const std::vector<ZenConvert::zCVobData>& vobs)
+	{
+		for(auto& v : vobs)
+		{
+			fn(v.childVobs);
+
+			if(v.visual.find(".3DS") == std::string::npos && v.visual.find(".ASC") == std::string::npos)
+				continue;
+
+			std::string base = v.visual.substr(0, v.visual.find("."));
+			for(const char* ext : {".MRM", ".MDM", ".MDL"})
+			{
+				if(vdfs.findFile(base + ext))
+				{
+					add(base + ext);
+					break;
+				}
+			}
+		}
+	};
+
+	fn(data.rootVobs);
+
+	return files;
+}
+
+/**
+* @brief Reads the materials of the given mesh of a vob and collects their textures
+*/
+std::vector<std::string> ZenWorld::collectMeshTextures(const std::string& meshFile, const VDFS::FileIndex& vdfs)
+{
+	std::vector<std::string> files;
+
+	// The mesh is only looked into here, so this doesn't count as request. Loading it for real comes later.
+	const VDFS::FileInfo* inf = vdfs.findFile(meshFile);
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
+	if(!inf || !vdfs.peekFileView(*inf, view, &storage))
+		return files;
+
+	auto addMaterials = [&](const ZenConvert::zCProgMeshProto& mesh) {
+		for(const ZenConvert::zCMaterialData& m : mesh.getMaterials())
+		{
+			if(!m.texture.empty())
+				files.push_back(getTextureFile(m.texture));
+		}
+	};
+
+	try
+	{
+		// Only the materials are read, the geometry is skipped
+		ZenConvert::ZenParser parser(view.data, view.size);
+
+		if(meshFile.find(".MRM") != std::string::npos)
+		{
+			ZenConvert::zCProgMeshProto mesh;
+			mesh.readObjectData(parser, true);
+			addMaterials(mesh);
+		}
+		else
+		{
+			ZenConvert::zCModelMeshLib lib;
+			if(meshFile.find(".MDM") != std::string::npos)
+				lib.loadMDM(parser, true);
+			else
+				lib.loadMDL(parser, true);
+
+			for(const ZenConvert::zCMeshSoftSkin& m : lib.getMeshes())
+				addMaterials(m.getMesh());
+
+			for(const ZenConvert::zCProgMeshProto& m : lib.getAttachments())
+				addMaterials(m);
+		}
+	}
+	catch(std::exception& e)
+	{
+		LogWarn() << "Failed to read the materials of " << meshFile << ": " << e.what();
+	}
+
+	return files;
+}
+
 /**
 * @brief Creates entities for the loaded oCWorld
 */
@@ -262,22 +441,25 @@ std::vector<ObjectHandle> ZenWorld::spawnVob(const Math::Matrix& worldMatrix, co
 
 		if(!pVisual)
 		{
-			// Strip .3DS-Part
-			std::string vname = visual.substr(0, visual.find("."));
+			// Strip .3DS-Part. The extension is swapped in place for each probe, so only this one string gets allocated.
+			std::string meshFile = visual.substr(0, visual.find(".")) + ".MRM";
+			size_t extStart = meshFile.size() - 3;
 
 			// Try to find the mesh of this
-			if(!m_pEngine->vdfsFileIndex().getFileByName(vname + ".MRM", nullptr)) // Try progmesh-proto
+			if(!m_pEngine->vdfsFileIndex().getFileByName(meshFile, nullptr)) // Try progmesh-proto
 			{
-				if(!m_pEngine->vdfsFileIndex().getFileByName(vname + ".MDM", nullptr)) // Try mesh lib
+				meshFile.replace(extStart, 3, "MDM");
+				if(!m_pEngine->vdfsFileIndex().getFileByName(meshFile, nullptr)) // Try mesh lib
 				{
-					if(!m_pEngine->vdfsFileIndex().getFileByName(vname + ".MDL", nullptr)) // Try mesh lib
+					meshFile.replace(extStart, 3, "MDL");
+					if(!m_pEngine->vdfsFileIndex().getFileByName(meshFile, nullptr)) // Try mesh lib
 					{
 						return handles;
 					}
 					else
 					{
 						// Found it, load the mesh-information
-						ZenConvert::zCModelMeshLib mesh(vname + ".MDL", m_pEngine->vdfsFileIndex());
+						ZenConvert::zCModelMeshLib mesh(meshFile, m_pEngine->vdfsFileIndex());
 
 						// Create some entities using this visual
 						ZenConvert::PackedSkeletalMesh packedMesh;
@@ -292,7 +474,7 @@ std::vector<ObjectHandle> ZenWorld::spawnVob(const Math::Matrix& worldMatrix, co
 				else
 				{
 					// Found it, load the mesh-information
-					ZenConvert::zCModelMeshLib mesh(vname + ".MDM", m_pEngine->vdfsFileIndex());
+					ZenConvert::zCModelMeshLib mesh(meshFile, m_pEngine->vdfsFileIndex());
 
 					// Create some entities using this visual
 					ZenConvert::PackedSkeletalMesh packedMesh;
@@ -307,7 +489,7 @@ std::vector<ObjectHandle> ZenWorld::spawnVob(const Math::Matrix& worldMatrix, co
 			else
 			{
 				// Found it, load the mesh-information
-				ZenConvert::zCProgMeshProto mesh(vname + ".MRM", m_pEngine->vdfsFileIndex());
+				ZenConvert::zCProgMeshProto mesh(meshFile, m_pEngine->vdfsFileIndex());
 
 				// Create some entities using this visual
 				ZenConvert::PackedMesh packedMesh;
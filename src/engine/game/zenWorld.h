@@ -62,6 +62,18 @@ namespace Engine
 		 */
 		void disectWorldMesh(ZenConvert::zCMesh* mesh, ::Engine::Engine& engine, VDFS::FileIndex & vdfs, float scale);
 
+		/**
+		 * @brief Collects the files needed for the textures of the world-mesh and the visuals of all vobs,
+		 *		  in the order they will be loaded
+		 */
+		static std::vector<std::string> collectWorldAssets(const ZenConvert::oCWorldData& data, const ZenConvert::zCMesh* worldMesh, const VDFS::FileIndex& vdfs);
+
+		/**
+		 * @brief Reads the materials of the given mesh of a vob and collects their textures. Only known once
+		 *		  the mesh was looked into, so these can't be part of collectWorldAssets.
+		 */
+		static std::vector<std::string> collectMeshTextures(const std::string& meshFile, const VDFS::FileIndex& vdfs);
+
 		/**
 		 * @brief Creates entities for the loaded oCWorld
 		 */
@@ -35,6 +35,19 @@ Engine::Settings::Settings(int argc, char *argv[])
     }
 }
 
+bool Engine::Settings::getArgument(const std::string& name, std::string& value) const
+{
+    auto it = m_Arguments.find(name);
+    if(it == m_Arguments.end())
+        return false;
+
+    value = it->second;
+    return true;
+}
+
 std::unordered_set<std::string> Engine::Settings::s_AvailableArguments =
-{ ""
+{ "",
+  "vdftrace", // File to write the order of all files requested from the VDFS while loading the world to
+  "vdfcache", // Megabytes of file-data the VDFS may keep in memory, for files requested more than once
+  "vdfstats", // File to write the I/O counters of the VDFS to as JSON, after the world was loaded
 };
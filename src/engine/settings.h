@@ -19,6 +19,12 @@ namespace Engine
          */
         Settings(int argc, char *argv[]);
 
+        /**
+         * @brief Fills value with the given argument, if it was passed on application start
+         * @return False, if the argument wasn't set
+         */
+        bool getArgument(const std::string& name, std::string& value) const;
+
     private:
         /**
          * @brief arguments passed to the game on startup
@@ -37,15 +37,16 @@ RAPI::RTexture* Renderer::loadTexture(const std::string& _name, const VDFS::File
 	std::string fileName = name.substr(0, name.find_first_of('.'));
 	fileName += "-C.TEX";
 
-	// Read data from vdfs
-	std::vector<uint8_t> textureData;
-	if(!fileIndex.getFileData(fileName, textureData))
+	// Read data from vdfs. Shared, so textures requested more than once can come from the file-cache.
+	VDFS::SharedFileData textureData = fileIndex.getSharedFileData(fileName);
+	if(!textureData)
 	{
 		tx = RAPI::REngine::ResourceCache->GetCachedObject<RAPI::RTexture>(name);
 
 		if(!tx)
 		{
-			if(!fileIndex.getFileData(DEFAULT_TEXTURE, textureData))
+			textureData = fileIndex.getSharedFileData(DEFAULT_TEXTURE);
+			if(!textureData)
 				return nullptr;
 		}
 		else
@@ -57,7 +58,7 @@ RAPI::RTexture* Renderer::loadTexture(const std::string& _name, const VDFS::File
 	// Convert to actual dds
 	std::vector<uint8_t> ddsData;
 	std::vector<uint8_t> rgba8data;
-	ZenConvert::convertZTEX2DDS(textureData, ddsData);
+	ZenConvert::convertZTEX2DDS(*textureData, ddsData);
 
 	tx = RAPI::REngine::ResourceCache->CreateResource<RAPI::RTexture>();
 
@@ -0,0 +1,414 @@
+#include "synthetic.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include "vdfs/fileIndex.h"
+#include "vdfs/archive_virtual.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <ctype.h>
+#include <stdlib.h>
+
+/**
+ * Benchmark of the archive-layer on generated archives, so changes to it can be compared without any game data.
+ * Every measurement runs a number of times and the fastest run is reported, which is the least disturbed one.
+ */
+
+namespace
+{
+	struct BenchOptions
+	{
+		VdfBench::SyntheticOptions synthetic;
+		uint32_t runs = 5;
+		uint32_t lookups = 1000000;
+		bool mapped = false;
+		bool cold = false;
+	};
+
+	/**
+	 * @brief Runs the given function options.runs times
+	 * @param prepare Called before each run, not counted into its time
+	 * @return Seconds of the fastest run, negative if any run failed
+	 */
+	double bestOf(uint32_t runs, const std::function<bool()>& fn, const std::function<void()>& prepare = nullptr)
+	{
+		double best = -1.0;
+		for(uint32_t i = 0; i < std::max(runs, 1u); i++)
+		{
+			if(prepare)
+				prepare();
+
+			auto start = std::chrono::high_resolution_clock::now();
+			if(!fn())
+				return -1.0;
+
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			if(best < 0.0 || seconds < best)
+				best = seconds;
+		}
+
+		return best;
+	}
+
+	void printRate(const char* what, double seconds, double count, const char* unit)
+	{
+		std::cout << "    " << what << ": " << seconds * 1000.0 << " ms, "
+			<< (seconds > 0.0 ? count / seconds : 0.0) << " " << unit << "/s" << std::endl;
+	}
+
+	void dropArchivesFromCache(const std::vector<VdfBench::SyntheticArchive>& archives)
+	{
+		for(const VdfBench::SyntheticArchive& a : archives)
+		{
+			FILE* f = fopen(a.file.c_str(), "rb");
+			if(!f)
+				continue;
+
+			Utils::System::dropFileCache(f);
+			fclose(f);
+		}
+	}
+
+	/**
+	 * @brief Parses the catalog of each archive, which is what loading an archive mostly consists of
+	 */
+	bool benchCatalog(const std::vector<VdfBench::SyntheticArchive>& archives, const BenchOptions& options)
+	{
+		uint64_t numEntries = 0;
+		for(const VdfBench::SyntheticArchive& a : archives)
+			numEntries += a.numFiles;
+
+		double seconds = bestOf(options.runs, [&]() {
+			for(const VdfBench::SyntheticArchive& a : archives)
+			{
+				VDFS::ArchiveVirtual archive;
+				if(!archive.openVDF(a.file, a.priority, options.mapped) || !archive.updateFileCatalog())
+					return false;
+			}
+
+			return true;
+		});
+
+		if(seconds < 0.0)
+			return false;
+
+		printRate("updateFileCatalog", seconds, static_cast<double>(numEntries), "files");
+		return true;
+	}
+
+	/**
+	 * @brief Puts the files of all archives into a fresh index, comparing priorities where names overlap
+	 */
+	bool benchInsertion(const std::vector<std::unique_ptr<VDFS::ArchiveVirtual>>& archives, uint64_t numFiles, const BenchOptions& options, VDFS::FileIndex& result)
+	{
+		size_t numAdded = 0;
+
+		double seconds = bestOf(options.runs, [&]() {
+			result.clearIndex();
+
+			numAdded = 0;
+			for(const std::unique_ptr<VDFS::ArchiveVirtual>& a : archives)
+				numAdded += a->insertFilesIntoIndex(result);
+
+			return true;
+		});
+
+		if(seconds < 0.0)
+			return false;
+
+		printRate("insertFilesIntoIndex", seconds, static_cast<double>(numFiles), "files");
+		std::cout << "        " << numFiles << " files offered, " << result.getKnownFiles().size() << " in the index, "
+			<< numAdded << " added or replaced" << std::endl;
+
+		return true;
+	}
+
+	/**
+	 * @brief Looks up known names in mixed case, plus some which don't exist, in random order
+	 */
+	bool benchLookup(const VDFS::FileIndex& index, const BenchOptions& options)
+	{
+		std::mt19937 rng(options.synthetic.seed);
+
+		const std::vector<VDFS::FileInfo>& files = index.getKnownFiles();
+		if(files.empty())
+			return false;
+
+		// One in ten lookups misses
+		std::vector<std::string> names;
+		for(const VDFS::FileInfo& inf : files)
+		{
+			std::string name = inf.fileName;
+			if(rng() & 1)
+				std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+			names.push_back(name);
+		}
+
+		size_t numMisses = files.size() / 9;
+		for(size_t i = 0; i < numMisses; i++)
+			names.push_back(VdfBench::getSyntheticName(static_cast<uint32_t>(i)) + "X");
+
+		std::shuffle(names.begin(), names.end(), rng);
+
+		size_t found = 0;
+		double seconds = bestOf(options.runs, [&]() {
+			found = 0;
+			for(uint32_t i = 0; i < options.lookups; i++)
+			{
+				if(index.findFile(names[i % names.size()]))
+					found++;
+			}
+
+			return true;
+		});
+
+		if(seconds < 0.0)
+			return false;
+
+		printRate("findFile", seconds, options.lookups, "lookups");
+		std::cout << "        " << (options.lookups ? seconds * 1e9 / options.lookups : 0.0) << " ns per lookup, "
+			<< found << " of " << options.lookups << " found" << std::endl;
+
+		return true;
+	}
+
+	/**
+	 * @brief Extracts all files of the index, once in the order of the index and once shuffled
+	 */
+	bool benchExtraction(const std::vector<VdfBench::SyntheticArchive>& archives, const BenchOptions& options)
+	{
+		VDFS::FileIndex index;
+		for(const VdfBench::SyntheticArchive& a : archives)
+		{
+			if(!index.loadVDF(a.file, a.priority, options.mapped))
+				return false;
+		}
+
+		std::vector<const VDFS::FileInfo*> files;
+		uint64_t totalBytes = 0;
+		for(const VDFS::FileInfo& inf : index.getKnownFiles())
+		{
+			files.push_back(&inf);
+			totalBytes += inf.fileSize;
+		}
+
+		std::vector<const VDFS::FileInfo*> shuffled = files;
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(options.synthetic.seed));
+
+		std::function<void()> prepare;
+		if(options.cold)
+			prepare = [&]() { dropArchivesFromCache(archives); };
+
+		std::vector<uint8_t> data;
+		auto extractAll = [&](const std::vector<const VDFS::FileInfo*>& order) {
+			return [&]() {
+				for(const VDFS::FileInfo* inf : order)
+				{
+					if(!index.getFileData(*inf, data))
+						return false;
+				}
+
+				return true;
+			};
+		};
+
+		double seconds = bestOf(options.runs, extractAll(files), prepare);
+		if(seconds < 0.0)
+			return false;
+
+		printRate("getFileData, index order", seconds, totalBytes / (1024.0 * 1024.0), "MB");
+		std::cout << "        " << (seconds > 0.0 ? files.size() / seconds : 0.0) << " files/s" << std::endl;
+
+		seconds = bestOf(options.runs, extractAll(shuffled), prepare);
+		if(seconds < 0.0)
+			return false;
+
+		printRate("getFileData, random order", seconds, totalBytes / (1024.0 * 1024.0), "MB");
+		std::cout << "        " << (seconds > 0.0 ? files.size() / seconds : 0.0) << " files/s" << std::endl;
+
+		return true;
+	}
+
+	void printUsage()
+	{
+		std::cerr << "Usage: vdfbench <workDirectory> [options]" << std::endl
+			<< "The work-directory gets created if needed. It may only hold archives of an earlier run." << std::endl
+			<< "Options:" << std::endl
+			<< "    -h, --help         Show this help" << std::endl
+			<< "    -archives <n>      Number of archives to generate (4)" << std::endl
+			<< "    -files <n>         Files per archive (20000)" << std::endl
+			<< "    -minsize <bytes>   Smallest file (256)" << std::endl
+			<< "    -maxsize <bytes>   Largest file (65536)" << std::endl
+			<< "    -depth <n>         Directory levels above each file (3)" << std::endl
+			<< "    -fanout <n>        Subdirectories per directory (6)" << std::endl
+			<< "    -overlap <0..1>    Fraction of names shared with the previous archive (0.25)" << std::endl
+			<< "    -seed <n>          Seed for sizes, priorities and orders (1)" << std::endl
+			<< "    -runs <n>          Runs per measurement, the fastest one is reported (5)" << std::endl
+			<< "    -lookups <n>       Names looked up per run (1000000)" << std::endl
+			<< "    -mapped            Memory map the archives" << std::endl
+			<< "    -cold              Drop the archives from the page cache before each extraction run" << std::endl;
+	}
+
+	bool isHelp(const std::string& arg)
+	{
+		return arg == "-h" || arg == "--help";
+	}
+
+	/**
+	 * @brief Checks that the work-directory can be written to without harm. It must not look like an option, and may
+	 *		  only hold archives written by an earlier run, which get overwritten.
+	 */
+	bool checkWorkDirectory(const std::string& directory)
+	{
+		if(directory.empty() || directory[0] == '-')
+		{
+			std::cerr << "Not a work-directory: " << directory << std::endl;
+			return false;
+		}
+
+		// Doesn't exist yet, gets created
+		std::vector<Utils::System::DirectoryEntry> entries;
+		if(!Utils::System::listDirectory(directory.c_str(), entries))
+			return true;
+
+		for(const Utils::System::DirectoryEntry& e : entries)
+		{
+			// Same names as generateArchives writes
+			bool ours = !e.isDirectory && e.name.size() > 13 && e.name.compare(0, 9, "SYNTHETIC") == 0
+				&& e.name.compare(e.name.size() - 4, 4, ".VDF") == 0
+				&& std::all_of(e.name.begin() + 9, e.name.end() - 4, [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; });
+
+			if(!ours)
+			{
+				std::cerr << "Work-directory " << directory << " holds files not written by vdfbench, like " << e.name << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Reads the options following the work-directory
+	 */
+	bool parseOptions(int argc, char* argv[], BenchOptions& options)
+	{
+		for(int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if(arg == "-mapped")
+			{
+				options.mapped = true;
+				continue;
+			}
+
+			if(arg == "-cold")
+			{
+				options.cold = true;
+				continue;
+			}
+
+			if(i + 1 >= argc)
+			{
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+
+			const char* value = argv[++i];
+			uint32_t n = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+
+			if(arg == "-archives") options.synthetic.numArchives = n;
+			else if(arg == "-files") options.synthetic.filesPerArchive = n;
+			else if(arg == "-minsize") options.synthetic.minFileSize = n;
+			else if(arg == "-maxsize") options.synthetic.maxFileSize = n;
+			else if(arg == "-depth") options.synthetic.directoryDepth = n;
+			else if(arg == "-fanout") options.synthetic.directoryFanout = n;
+			else if(arg == "-overlap") options.synthetic.overlap = static_cast<float>(atof(value));
+			else if(arg == "-seed") options.synthetic.seed = n;
+			else if(arg == "-runs") options.runs = n;
+			else if(arg == "-lookups") options.lookups = n;
+			else
+			{
+				std::cerr << "Unknown option: " << arg << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(isHelp(argv[i]))
+		{
+			printUsage();
+			return 0;
+		}
+	}
+
+	BenchOptions options;
+	if(argc < 2 || !parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	const std::string workDirectory = argv[1];
+	if(!checkWorkDirectory(workDirectory))
+		return 1;
+
+	const VdfBench::SyntheticOptions& s = options.synthetic;
+
+	std::cout << "Generating " << s.numArchives << " archives of " << s.filesPerArchive << " files, "
+		<< s.minFileSize << " to " << s.maxFileSize << " bytes, depth " << s.directoryDepth << "..." << std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<VdfBench::SyntheticArchive> archives;
+	if(!VdfBench::generateArchives(workDirectory, s, archives))
+		return 1;
+
+	uint64_t dataSize = 0, numFiles = 0;
+	for(const VdfBench::SyntheticArchive& a : archives)
+	{
+		dataSize += a.dataSize;
+		numFiles += a.numFiles;
+	}
+
+	std::cout << "    " << dataSize / (1024.0 * 1024.0) << " MB written in "
+		<< std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+
+	std::cout << (options.mapped ? "Memory mapped" : "Streamed") << ", best of " << options.runs << " runs:" << std::endl;
+
+	if(!benchCatalog(archives, options))
+		return 1;
+
+	// Insertion and lookup work on archives which are already open, so only the index is measured
+	std::vector<std::unique_ptr<VDFS::ArchiveVirtual>> loaded;
+	for(const VdfBench::SyntheticArchive& a : archives)
+	{
+		loaded.emplace_back(new VDFS::ArchiveVirtual);
+		if(!loaded.back()->loadVDF(a.file, a.priority, options.mapped))
+			return 1;
+	}
+
+	VDFS::FileIndex index;
+	if(!benchInsertion(loaded, numFiles, options, index) || !benchLookup(index, options))
+		return 1;
+
+	index.clearIndex();
+
+	if(!benchExtraction(archives, options))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include "synthetic.h"
+#include "utils/system.h"
+#include "vdfs/archive_writer.h"
+#include <random>
+#include <algorithm>
+#include <stdio.h>
+
+namespace
+{
+	/**
+	 * @brief Prefixes and extensions names are built from, roughly following what the game ships
+	 */
+	const char* const NAME_PREFIXES[] = {"IT", "HUM", "ORC", "NW", "OW", "DT", "CHESTBIG", "FIREPLACE", "EVT", "SVM"};
+	const char* const NAME_EXTENSIONS[] = {"TEX", "MRM", "MDL", "MDH", "MAN", "MMB", "WAV", "ZEN", "3DS", "ASC"};
+
+	/**
+	 * @brief Returns the directory of the given file, like "DIR2/DIR0/DIR5"
+	 */
+	std::string getDirectory(uint32_t id, const VdfBench::SyntheticOptions& options)
+	{
+		std::string dir;
+		uint32_t fanout = std::max(options.directoryFanout, 1u);
+		for(uint32_t level = 0; level < options.directoryDepth; level++)
+		{
+			if(!dir.empty())
+				dir += "/";
+
+			dir += "DIR" + std::to_string(id % fanout);
+			id /= fanout;
+		}
+
+		return dir;
+	}
+
+	/**
+	 * @brief Cheap, but not constant data, so compressing or comparing it means something
+	 */
+	void fillData(uint32_t id, uint32_t size, std::vector<uint8_t>& data)
+	{
+		data.resize(size);
+
+		uint32_t x = id * 2654435761u + 1;
+		for(uint32_t i = 0; i < size; i++)
+		{
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			data[i] = static_cast<uint8_t>(x & 0x3F);
+		}
+	}
+}
+
+/**
+ * @brief Returns the name of the synthetic file with the given id
+ */
+std::string VdfBench::getSyntheticName(uint32_t id)
+{
+	const size_t numPrefixes = sizeof(NAME_PREFIXES) / sizeof(NAME_PREFIXES[0]);
+	const size_t numExtensions = sizeof(NAME_EXTENSIONS) / sizeof(NAME_EXTENSIONS[0]);
+
+	char name[64];
+	snprintf(name, sizeof(name), "%s_%07u.%s", NAME_PREFIXES[id % numPrefixes], id, NAME_EXTENSIONS[(id / numPrefixes) % numExtensions]);
+	return name;
+}
+
+/**
+ * @brief Writes the synthetic archives into the given directory
+ */
+bool VdfBench::generateArchives(const std::string& directory, const SyntheticOptions& options, std::vector<SyntheticArchive>& archives)
+{
+	std::mt19937 rng(options.seed);
+
+	Utils::System::mkdir(directory.c_str());
+
+	// Shuffled priorities, so the index sees both files that win and files that lose
+	std::vector<uint32_t> priorities(options.numArchives);
+	for(uint32_t i = 0; i < options.numArchives; i++)
+		priorities[i] = i;
+
+	std::shuffle(priorities.begin(), priorities.end(), rng);
+
+	uint32_t shared = static_cast<uint32_t>(options.filesPerArchive * std::min(std::max(options.overlap, 0.0f), 1.0f));
+	uint32_t maxSize = std::max(options.maxFileSize, options.minFileSize);
+	std::uniform_int_distribution<uint32_t> sizeDist(options.minFileSize, maxSize);
+
+	archives.clear();
+	for(uint32_t a = 0; a < options.numArchives; a++)
+	{
+		SyntheticArchive archive;
+		archive.file = directory + "/SYNTHETIC" + std::to_string(a) + ".VDF";
+		archive.priority = priorities[a];
+		archive.numFiles = options.filesPerArchive;
+		archive.dataSize = 0;
+
+		// The first ids of this archive are the last ones of the previous archive
+		uint32_t firstId = a * (options.filesPerArchive - shared);
+
+		VDFS::ArchiveWriter writer;
+		for(uint32_t i = 0; i < options.filesPerArchive; i++)
+		{
+			uint32_t id = firstId + i;
+			uint32_t size = sizeDist(rng);
+			archive.dataSize += size;
+
+			std::string dir = getDirectory(id, options);
+			std::string path = dir.empty() ? getSyntheticName(id) : dir + "/" + getSyntheticName(id);
+
+			writer.addFile(path, size, [id, size](std::vector<uint8_t>& data) {
+				fillData(id, size, data);
+				return true;
+			});
+		}
+
+		if(!writer.writeVDF(archive.file, "Synthetic archive written by vdfbench"))
+			return false;
+
+		archives.push_back(archive);
+	}
+
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace VdfBench
+{
+	/**
+	 * @brief Shape of a set of generated archives
+	 */
+	struct SyntheticOptions
+	{
+		uint32_t numArchives = 4;
+		uint32_t filesPerArchive = 20000;
+		uint32_t minFileSize = 256;
+		uint32_t maxFileSize = 64 * 1024;
+		uint32_t directoryDepth = 3; // Levels of directories above each file
+		uint32_t directoryFanout = 6; // Subdirectories per directory
+		float overlap = 0.25f; // Fraction of the files of an archive which also exist in the previous one
+		uint32_t seed = 1;
+	};
+
+	/**
+	 * @brief A generated archive and the priority it should be loaded with
+	 */
+	struct SyntheticArchive
+	{
+		std::string file;
+		uint32_t priority;
+		uint32_t numFiles;
+		uint64_t dataSize;
+	};
+
+	/**
+	 * @brief Writes options.numArchives VDFs into the given directory, using ArchiveWriter. File names look like the ones
+	 *		  of the game ("IT_0001234.MRM"), so the name-hashes behave the same. Archives share some of their names
+	 *		  with their predecessor, and get priorities in shuffled order, so the index has to compare priorities.
+	 *		  The same options always give the same archives.
+	 * @return False, if any of the archives could not be written
+	 */
+	bool generateArchives(const std::string& directory, const SyntheticOptions& options, std::vector<SyntheticArchive>& archives);
+
+	/**
+	 * @brief Returns the name of the synthetic file with the given id, as generateArchives uses it
+	 */
+	std::string getSyntheticName(uint32_t id);
+}
@@ -0,0 +1,133 @@
+#include "commands.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include "vdfs/fileIndex.h"
+#include "vdfs/archive_virtual.h"
+#include "vdfs/batchReader.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+
+namespace
+{
+	/**
+	 * @brief Most data read as one batch, so the buffers stay reasonable for large archives
+	 */
+	const uint64_t MAX_BATCH_BYTES = 64 * 1024 * 1024;
+
+	/**
+	 * @brief Drops the archive from the page cache, so every run starts cold
+	 */
+	void dropArchiveFromCache(const std::string& file)
+	{
+		FILE* f = fopen(file.c_str(), "rb");
+		if(!f)
+			return;
+
+		Utils::System::dropFileCache(f);
+		fclose(f);
+	}
+
+	/**
+	 * @brief Extracts all files of the archive in batches of up to MAX_BATCH_BYTES through the given reader
+	 * @return Seconds it took, negative on failure
+	 */
+	double extractAll(const VDFS::ArchiveVirtual& archive, const std::vector<VDFS::FileInfo>& files, VDFS::BatchReader& reader, std::vector<uint8_t>& buffer)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		std::vector<const VDFS::FileInfo*> batch;
+		std::vector<uint8_t*> targets;
+		for(size_t first = 0; first < files.size();)
+		{
+			// Find out how many files fit
+			uint64_t size = 0;
+			size_t last = first;
+			while(last < files.size() && (last == first || size + files[last].fileSize <= MAX_BATCH_BYTES))
+				size += files[last++].fileSize;
+
+			if(buffer.size() < size)
+				buffer.resize(size);
+
+			batch.clear();
+			targets.clear();
+
+			uint64_t offset = 0;
+			for(size_t i = first; i < last; i++)
+			{
+				batch.push_back(&files[i]);
+				targets.push_back(buffer.data() + offset);
+				offset += files[i].fileSize;
+			}
+
+			if(!archive.extractFiles(batch, targets, reader))
+				return -1.0;
+
+			first = last;
+		}
+
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+int VdfTool::benchBatch(const Arguments& args)
+{
+	if(args.empty())
+	{
+		std::cerr << "Usage: bench-batch <input.vdf> [maxQueueDepth]" << std::endl;
+		return 1;
+	}
+
+	unsigned maxDepth = args.size() > 1 ? static_cast<unsigned>(strtoul(args[1].c_str(), nullptr, 10)) : 128;
+
+	VDFS::ArchiveVirtual archive;
+	if(!archive.loadVDF(args[0]))
+		return 1;
+
+	std::vector<VDFS::FileInfo> files;
+	uint64_t totalBytes = 0;
+	archive.listFiles([&](const VDFS::FileInfo& inf, const std::string&) {
+		files.push_back(inf);
+		totalBytes += inf.fileSize;
+	});
+
+	std::cout << files.size() << " files, " << totalBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+
+	// Allocate up front, so the first run doesn't pay for faulting in the buffer
+	std::vector<uint8_t> buffer(static_cast<size_t>(std::min(totalBytes, MAX_BATCH_BYTES)));
+
+	auto run = [&](const char* what, unsigned depth, bool ioUring) {
+		VDFS::BatchReader reader(depth, ioUring);
+		if(ioUring && !reader.isUsingIoUring())
+			return false;
+
+		dropArchiveFromCache(args[0]);
+
+		double seconds = extractAll(archive, files, reader, buffer);
+		if(seconds < 0.0)
+			return false;
+
+		std::cout << "    " << what << " depth " << reader.getQueueDepth() << ": " << seconds * 1000.0 << " ms, "
+			<< (seconds > 0.0 ? totalBytes / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s, "
+			<< (seconds > 0.0 ? files.size() / seconds : 0.0) << " files/s" << std::endl;
+
+		return true;
+	};
+
+	if(!run("pread   ", 1, false))
+		return 1;
+
+	for(unsigned depth = 1; depth <= maxDepth; depth *= 2)
+	{
+		if(!run("io_uring", depth, true))
+		{
+			std::cout << "io_uring is not available here" << std::endl;
+			break;
+		}
+	}
+
+	std::cout << "Note: Pages of the archive are dropped from the page cache before each run, if the OS allows it." << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace VdfTool
+{
+	/**
+	 * @brief Arguments passed to a command, without the program- and command-name
+	 */
+	typedef std::vector<std::string> Arguments;
+
+	/**
+	 * @brief Writes a new VDF containing the files of the given archives, with their data laid out in the order of an access-trace
+	 *		  Usage: repack <trace.txt> <output.vdf> <input.vdf>...
+	 */
+	int repack(const Arguments& args);
+
+	/**
+	 * @brief Converts a VDF into a compressed archive
+	 *		  Usage: compress <input.vdf> <output.cvdf> [blockSize]
+	 */
+	int compress(const Arguments& args);
+
+	/**
+	 * @brief Compares reading all files of a VDF with reading them from its compressed version, plus random ranges of them
+	 *		  Usage: bench-compressed <input.vdf> <compressed.cvdf> [rangeSize]
+	 */
+	int benchCompressed(const Arguments& args);
+
+	/**
+	 * @brief Measures extraction throughput of all files of a VDF with positional reads and through io_uring at increasing queue depths
+	 *		  Usage: bench-batch <input.vdf> [maxQueueDepth]
+	 */
+	int benchBatch(const Arguments& args);
+}
@@ -0,0 +1,141 @@
+#include "commands.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include "vdfs/fileIndex.h"
+#include "vdfs/archive_virtual.h"
+#include "vdfs/archive_compressed.h"
+#include "vdfs/archive_writer.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <stdlib.h>
+
+namespace
+{
+	/**
+	 * @brief Reads every file of the index once
+	 * @return Seconds it took, negative on failure
+	 */
+	double readAllFiles(const VDFS::FileIndex& index, uint64_t& bytes)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		bytes = 0;
+		std::vector<uint8_t> data;
+		for(const VDFS::FileInfo& inf : index.getKnownFiles())
+		{
+			if(!index.getFileData(inf, data))
+				return -1.0;
+
+			bytes += data.size();
+		}
+
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void printThroughput(const char* what, uint64_t bytes, double seconds)
+	{
+		std::cout << what << ": " << bytes / (1024.0 * 1024.0) << " MB in " << seconds * 1000.0 << " ms ("
+			<< (seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s)" << std::endl;
+	}
+}
+
+int VdfTool::compress(const Arguments& args)
+{
+	if(args.size() < 2)
+	{
+		std::cerr << "Usage: compress <input.vdf> <output.cvdf> [blockSize]" << std::endl;
+		return 1;
+	}
+
+	uint32_t blockSize = args.size() > 2 ? static_cast<uint32_t>(strtoul(args[2].c_str(), nullptr, 10)) : VDFS::CVDF_DEFAULT_BLOCK_SIZE;
+
+	VDFS::ArchiveVirtual archive;
+	if(!archive.loadVDF(args[0]))
+		return 1;
+
+	VDFS::ArchiveWriter writer;
+	archive.listFiles([&](const VDFS::FileInfo& inf, const std::string& path) {
+		writer.addFile(path, inf.fileSize, [inf](std::vector<uint8_t>& data) {
+			return inf.targetArchive->extractFile(inf, data);
+		});
+	});
+
+	if(!writer.writeCompressedVDF(args[1], archive.isGothic1(), blockSize))
+		return 1;
+
+	uint64_t inSize = 0, outSize = 0, mtime = 0;
+	Utils::System::getFileStats(args[0].c_str(), inSize, mtime);
+	Utils::System::getFileStats(args[1].c_str(), outSize, mtime);
+
+	std::cout << "Compressed " << args[0] << " (" << inSize << " bytes) to " << args[1] << " (" << outSize << " bytes, "
+		<< (inSize ? 100.0 * outSize / inSize : 0.0) << "%)" << std::endl;
+
+	return 0;
+}
+
+int VdfTool::benchCompressed(const Arguments& args)
+{
+	if(args.size() < 2)
+	{
+		std::cerr << "Usage: bench-compressed <input.vdf> <compressed.cvdf> [rangeSize]" << std::endl;
+		return 1;
+	}
+
+	uint32_t rangeSize = args.size() > 2 ? static_cast<uint32_t>(strtoul(args[2].c_str(), nullptr, 10)) : 4096;
+
+	// Both through the normal index, once streamed and once mapped
+	for(int mapped = 0; mapped < 2; mapped++)
+	{
+		VDFS::FileIndex plain, compressed;
+		if(!plain.loadVDF(args[0], 0, mapped != 0) || !compressed.loadVDF(args[1], 0, mapped != 0))
+			return 1;
+
+		std::cout << (mapped ? "Memory mapped" : "Streamed") << ":" << std::endl;
+
+		uint64_t bytes = 0;
+		double seconds = readAllFiles(plain, bytes);
+		if(seconds < 0.0)
+			return 1;
+
+		printThroughput("    Uncompressed, all files", bytes, seconds);
+
+		seconds = readAllFiles(compressed, bytes);
+		if(seconds < 0.0)
+			return 1;
+
+		printThroughput("    Compressed, all files  ", bytes, seconds);
+
+		// Random ranges only decompress the blocks they touch
+		const std::vector<VDFS::FileInfo>& files = compressed.getKnownFiles();
+		std::vector<uint8_t> target(rangeSize);
+		std::mt19937 rng(42);
+		uint64_t rangeBytes = 0;
+		size_t numRanges = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for(size_t i = 0; i < files.size() * 4; i++)
+		{
+			const VDFS::FileInfo& inf = files[rng() % files.size()];
+			if(inf.fileSize < rangeSize)
+				continue;
+
+			uint32_t offset = rng() % (inf.fileSize - rangeSize + 1);
+			const VDFS::ArchiveCompressed* a = static_cast<const VDFS::ArchiveCompressed*>(inf.targetArchive);
+			if(!a->extractRange(inf, offset, rangeSize, target.data()))
+				return 1;
+
+			rangeBytes += rangeSize;
+			numRanges++;
+		}
+
+		seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		printThroughput("    Compressed, ranges     ", rangeBytes, seconds);
+		std::cout << "        " << numRanges << " ranges of " << rangeSize << " bytes, "
+			<< (numRanges ? seconds * 1e6 / numRanges : 0.0) << " us each" << std::endl;
+	}
+
+	std::cout << "Note: Drop the page cache before running this to measure cold loads." << std::endl;
+
+	return 0;
+}
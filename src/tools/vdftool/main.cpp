@@ -0,0 +1,54 @@
+#include "utils/logger.h"
+#include "commands.h"
+
+#include <iostream>
+#include <string>
+#include <functional>
+#include <map>
+
+namespace
+{
+	/**
+	 * @brief Available commands and their usage
+	 */
+	struct Command
+	{
+		std::function<int(const VdfTool::Arguments&)> run;
+		const char* usage;
+	};
+
+	const std::map<std::string, Command> s_Commands =
+	{
+		{"repack", {VdfTool::repack, "repack <trace.txt> <output.vdf> <input.vdf>..."}},
+		{"compress", {VdfTool::compress, "compress <input.vdf> <output.cvdf> [blockSize]"}},
+		{"bench-compressed", {VdfTool::benchCompressed, "bench-compressed <input.vdf> <compressed.cvdf> [rangeSize]"}},
+		{"bench-batch", {VdfTool::benchBatch, "bench-batch <input.vdf> [maxQueueDepth]"}},
+	};
+
+	void printUsage()
+	{
+		std::cerr << "Usage: vdftool <command> [arguments]" << std::endl << "Commands:" << std::endl;
+		for(auto& c : s_Commands)
+			std::cerr << "    " << c.second.usage << std::endl;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	auto it = s_Commands.find(argv[1]);
+	if(it == s_Commands.end())
+	{
+		std::cerr << "Unknown command: " << argv[1] << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	VdfTool::Arguments args(argv + 2, argv + argc);
+	return it->second.run(args);
+}
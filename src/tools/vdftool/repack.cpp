@@ -0,0 +1,106 @@
+#include "commands.h"
+#include "utils/logger.h"
+#include "vdfs/fileIndex.h"
+#include "vdfs/archive_virtual.h"
+#include "vdfs/archive_writer.h"
+#include <iostream>
+#include <memory>
+#include <map>
+#include <algorithm>
+
+/**
+ * The archives shipped with the game are sorted by directory, so loading a world jumps all over them.
+ * This takes an access-trace recorded by VDFS::FileIndex and writes all files of the given archives into
+ * a single new one, with the data of the traced files in the order they were requested. Everything that
+ * wasn't requested follows in its original order. Loading the world again then mostly reads front to back.
+ */
+
+int VdfTool::repack(const Arguments& args)
+{
+	if(args.size() < 3)
+	{
+		std::cerr << "Usage: repack <trace.txt> <output.vdf> <input.vdf>..." << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> trace;
+	if(!VDFS::FileIndex::loadAccessTrace(args[0], trace))
+		return 1;
+
+	// Merge the inputs the same way the engine does, so only the files that would actually be used end up in the output
+	VDFS::FileIndex index;
+	std::vector<std::unique_ptr<VDFS::ArchiveVirtual>> archives;
+	for(size_t i = 2; i < args.size(); i++)
+	{
+		archives.emplace_back(new VDFS::ArchiveVirtual);
+		if(!archives.back()->loadVDF(args[i]))
+		{
+			LogError() << "Failed to load VDF-Archive: " << args[i];
+			return 1;
+		}
+
+		archives.back()->insertFilesIntoIndex(index);
+	}
+
+	// Find the path inside its archive for every file that made it into the index
+	struct RepackFile
+	{
+		VDFS::FileInfo info;
+		std::string path;
+	};
+
+	std::vector<RepackFile> files;
+	for(auto& a : archives)
+	{
+		a->listFiles([&](const VDFS::FileInfo& inf, const std::string& path) {
+			const VDFS::FileInfo* indexed = index.findFile(inf.fileName);
+			if(indexed && indexed->targetArchive == inf.targetArchive && indexed->archiveOffset == inf.archiveOffset)
+				files.push_back({inf, path});
+		});
+	}
+
+	std::map<std::pair<const VDFS::Archive*, uint32_t>, size_t> fileByLocation;
+	for(size_t i = 0; i < files.size(); i++)
+		fileByLocation[std::make_pair(files[i].info.targetArchive, files[i].info.archiveOffset)] = i;
+
+	// Traced files go first, in the order they were requested. Sorting is stable, so the rest keeps its order.
+	std::vector<size_t> tracePosition(files.size(), trace.size());
+	for(size_t t = 0; t < trace.size(); t++)
+	{
+		const VDFS::FileInfo* inf = index.findFile(trace[t]);
+		if(!inf)
+			continue;
+
+		auto it = fileByLocation.find(std::make_pair(static_cast<const VDFS::Archive*>(inf->targetArchive), inf->archiveOffset));
+		if(it != fileByLocation.end())
+			tracePosition[it->second] = std::min(tracePosition[it->second], t);
+	}
+
+	std::vector<size_t> order(files.size());
+	for(size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return tracePosition[a] < tracePosition[b];
+	});
+
+	VDFS::ArchiveWriter writer;
+	size_t numTraced = 0;
+	for(size_t i : order)
+	{
+		const RepackFile& f = files[i];
+		writer.addFile(f.path, f.info.fileSize, [&f](std::vector<uint8_t>& data) {
+			return f.info.targetArchive->extractFile(f.info, data);
+		});
+
+		if(tracePosition[i] < trace.size())
+			numTraced++;
+	}
+
+	if(!writer.writeVDF(args[1], "Repacked by vdftool", archives.front()->isGothic1()))
+		return 1;
+
+	LogInfo() << "Wrote " << files.size() << " files to " << args[1] << ", " << numTraced << " of them in trace order";
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+#include "zenconvert/zenParser.h"
+#include "zenconvert/oCWorld.h"
+#include "utils/logger.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Reads the vob-tree of a world-ZEN once with a single thread and once with multiple ones, and checks that both
+ * give the same vobs in the same order. Also reports how long each of them took.
+ */
+
+namespace
+{
+	struct CheckOptions
+	{
+		uint32_t runs = 3;
+		size_t threads = 0;
+		bool propertyStrings = false;
+	};
+
+	/**
+	 * @brief Compares two values bit by bit, so NaNs read the same way count as equal
+	 */
+	template<typename T>
+	bool sameBits(const T& a, const T& b)
+	{
+		return memcmp(&a, &b, sizeof(T)) == 0;
+	}
+
+	bool sameFloat3(const Math::float3& a, const Math::float3& b)
+	{
+		return sameBits(a.x, b.x) && sameBits(a.y, b.y) && sameBits(a.z, b.z);
+	}
+
+	/**
+	 * @brief Compares everything readObjectData fills in, and the children of both
+	 * @return Path to the first difference, empty if there is none
+	 */
+	std::string compareVobs(const ZenConvert::zCVobData& a, const ZenConvert::zCVobData& b, const std::string& path)
+	{
+		std::string here = path + "/" + (a.vobName.empty() ? a.objectClass : a.vobName);
+
+		bool same = a.objectClass == b.objectClass
+			&& a.properties == b.properties
+			&& a.vobName == b.vobName
+			&& a.visual == b.visual
+			&& a.presetName == b.presetName
+			&& sameFloat3(a.position, b.position)
+			&& sameFloat3(a.bbox[0], b.bbox[0])
+			&& sameFloat3(a.bbox[1], b.bbox[1])
+			&& sameBits(a.rotationMatrix3x3, b.rotationMatrix3x3)
+			&& a.showVisual == b.showVisual
+			&& a.visualCamAlign == b.visualCamAlign
+			&& a.visualAniMode == b.visualAniMode
+			&& sameBits(a.visualAniModeStrength, b.visualAniModeStrength)
+			&& sameBits(a.vobFarClipScale, b.vobFarClipScale)
+			&& a.cdStatic == b.cdStatic
+			&& a.cdDyn == b.cdDyn
+			&& a.staticVob == b.staticVob
+			&& a.dynamicShadow == b.dynamicShadow
+			&& a.zBias == b.zBias
+			&& a.isAmbient == b.isAmbient
+			&& a.childVobs.size() == b.childVobs.size();
+
+		if(!same)
+			return here;
+
+		for(size_t i = 0; i < a.childVobs.size(); i++)
+		{
+			std::string diff = compareVobs(a.childVobs[i], b.childVobs[i], here);
+			if(!diff.empty())
+				return diff;
+		}
+
+		return std::string();
+	}
+
+	/**
+	 * @brief Moves the parser to the count of root-vobs in the vob-tree of the world, the same walk
+	 *		  as oCWorld::readObjectData does
+	 * @return False, if the world has no vob-tree
+	 */
+	bool findVobTree(ZenConvert::ZenParser& parser)
+	{
+		ZenConvert::ZenParser::ChunkHeader header;
+		parser.readChunkStart(header);
+
+		if(header.classname != "oCWorld:zCWorld")
+			throw std::runtime_error("Expected oCWorld:zCWorld-Chunk not found!");
+
+		while(!parser.readChunkEnd())
+		{
+			parser.readChunkStart(header);
+
+			if(header.name == "VobTree")
+				return true;
+
+			if(header.name == "MeshAndBsp")
+			{
+				parser.skipWorldMesh();
+				parser.readChunkEnd();
+			}
+			else
+			{
+				parser.skipChunk();
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Reads the vob-tree the parser is at the given number of times. The seek of the parser is restored afterwards.
+	 * @return Seconds of the fastest run
+	 */
+	double readBestOf(ZenConvert::ZenParser& parser, uint32_t numRootVobs, size_t numThreads, uint32_t runs, std::vector<ZenConvert::zCVobData>& result)
+	{
+		size_t start = parser.getSeek();
+
+		double best = -1.0;
+		for(uint32_t i = 0; i < std::max(runs, 1u); i++)
+		{
+			result.clear();
+			parser.setSeek(start);
+
+			auto begin = std::chrono::high_resolution_clock::now();
+			ZenConvert::oCWorld::readVobTrees(parser, numRootVobs, result, numThreads);
+
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+			if(best < 0.0 || seconds < best)
+				best = seconds;
+		}
+
+		parser.setSeek(start);
+		return best;
+	}
+
+	void printUsage()
+	{
+		std::cerr << "Usage: vobtreecheck <world.zen> [options]" << std::endl
+			<< "Options:" << std::endl
+			<< "    -threads <n>       Threads for the parallel read, 0 for one per core (0)" << std::endl
+			<< "    -runs <n>          Runs per read, the fastest one is reported (3)" << std::endl
+			<< "    -strings           Also fill the property text-map of every vob" << std::endl;
+	}
+
+	/**
+	 * @brief Reads the options following the ZEN-file
+	 */
+	bool parseOptions(int argc, char* argv[], CheckOptions& options)
+	{
+		for(int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if(arg == "-strings")
+			{
+				options.propertyStrings = true;
+				continue;
+			}
+
+			if(i + 1 >= argc)
+			{
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+
+			uint32_t n = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+
+			if(arg == "-threads") options.threads = n;
+			else if(arg == "-runs") options.runs = n;
+			else
+			{
+				std::cerr << "Unknown option: " << arg << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	CheckOptions options;
+	if(argc < 2 || !parseOptions(argc, argv, options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	try
+	{
+		ZenConvert::ZenParser parser(argv[1]);
+		parser.setReadPropertyStrings(options.propertyStrings);
+		parser.readHeader();
+
+		if(!findVobTree(parser))
+		{
+			std::cerr << "World has no vob-tree" << std::endl;
+			return 1;
+		}
+
+		uint32_t numRootVobs;
+		parser.getImpl()->readEntry("", &numRootVobs, sizeof(numRootVobs), ZenConvert::ParserImpl::ZVT_INT);
+
+		size_t numThreads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+		std::cout << numRootVobs << " root-vobs, reading with 1 and " << numThreads << " threads" << std::endl;
+		if(numRootVobs < ZenConvert::oCWorld::MIN_PARALLEL_ROOT_VOBS || numThreads < 2)
+			std::cout << "    Note: too few root-vobs or threads, both reads are serial" << std::endl;
+
+		std::vector<ZenConvert::zCVobData> serial, parallel;
+		double serialSeconds = readBestOf(parser, numRootVobs, 1, options.runs, serial);
+		double parallelSeconds = readBestOf(parser, numRootVobs, numThreads, options.runs, parallel);
+
+		std::cout << "    serial: " << serialSeconds * 1000.0 << " ms" << std::endl
+			<< "    parallel: " << parallelSeconds * 1000.0 << " ms" << std::endl;
+
+		if(serial.size() != parallel.size())
+		{
+			std::cerr << "Different number of root-vobs: " << serial.size() << " serial, " << parallel.size() << " parallel" << std::endl;
+			return 1;
+		}
+
+		for(size_t i = 0; i < serial.size(); i++)
+		{
+			std::string diff = compareVobs(serial[i], parallel[i], "");
+			if(!diff.empty())
+			{
+				std::cerr << "Vob-trees differ at root-vob " << i << ": " << diff << std::endl;
+				return 1;
+			}
+		}
+
+		std::cout << "Vob-trees are the same" << std::endl;
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << "Failed to read " << argv[1] << ": " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
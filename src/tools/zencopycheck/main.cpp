@@ -0,0 +1,522 @@
+#include "zenconvert/zenParser.h"
+#include "zenconvert/zCMesh.h"
+#include "zenconvert/zCProgMeshProto.h"
+#include "vdfs/fileIndex.h"
+#include "vdfs/archive_writer.h"
+#include "utils/system.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Regression check for loading worlds without copying their data. A generated world .ZEN and the .MRMs of its vobs
+ * are put into a VDF and loaded the way ZenWorld does, once from the memory mapped archive and once from the
+ * archive read into memory. While loading, all allocations are counted, which is where copies of the file-data
+ * would show up.
+ */
+
+namespace
+{
+	/**
+	 * @brief Bytes allocated while counting is enabled, and the largest single allocation
+	 */
+	std::atomic<bool> s_CountAllocations(false);
+	std::atomic<uint64_t> s_BytesAllocated(0);
+	std::atomic<uint64_t> s_LargestAllocation(0);
+
+	const char* WORLD_NAME = "ZENCOPYCHECK.ZEN";
+	const uint32_t NUM_MATERIALS = 16;
+	const uint32_t NUM_VERTICES = 1024;
+
+	/**
+	 * @brief Root-vobs of the world, each with a visual of its own and one child without any.
+	 *		  Stays below oCWorld::MIN_PARALLEL_ROOT_VOBS, the threads would only add noise to the counts.
+	 */
+	const uint32_t NUM_VOBS = 8;
+	const uint32_t NUM_MRM_MATERIALS = 4;
+	const uint32_t NUM_MRM_VERTICES = 256;
+
+	// Chunk-IDs, same as in zCMesh.cpp
+	const uint16_t MSID_MESH = 0xB000;
+	const uint16_t MSID_BBOX3D = 0xB010;
+	const uint16_t MSID_MATLIST = 0xB020;
+	const uint16_t MSID_LIGHTMAPLIST = 0xB025;
+	const uint16_t MSID_VERTLIST = 0xB030;
+	const uint16_t MSID_MESH_END = 0xB060;
+
+	// Chunk-IDs, same as in zCProgMeshProto.cpp. The padding-chunk isn't known there, so it gets skipped.
+	const uint16_t MSID_PROGMESH = 0xB100;
+	const uint16_t MSID_PROGMESH_PADDING = 0xB1F0;
+	const uint16_t MSID_PROGMESH_END = 0xB1FF;
+
+	/**
+	 * @brief Size of the chunks the readers skip. Makes the files much larger than anything the readers keep,
+	 *		  so any copy of them stands out.
+	 */
+	const uint32_t PADDING_SIZE = 4 * 1024 * 1024;
+	const uint32_t MRM_PADDING_SIZE = 512 * 1024;
+
+	template<typename T>
+	void put(std::vector<uint8_t>& out, const T& value)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	void putLine(std::vector<uint8_t>& out, const std::string& line)
+	{
+		out.insert(out.end(), line.begin(), line.end());
+		out.push_back('\n');
+	}
+
+	/**
+	 * @brief Appends a chunk with the given ID, filled by fn
+	 */
+	template<typename F>
+	void putChunk(std::vector<uint8_t>& out, uint16_t id, F fn)
+	{
+		put(out, id);
+
+		size_t lengthPos = out.size();
+		put(out, uint32_t(0));
+
+		fn(out);
+
+		uint32_t length = static_cast<uint32_t>(out.size() - lengthPos - sizeof(uint32_t));
+		memcpy(&out[lengthPos], &length, sizeof(length));
+	}
+
+	/**
+	 * @brief Appends the header of an archive in the given format
+	 */
+	void putArchiveHeader(std::vector<uint8_t>& out, const std::string& format, uint32_t numObjects)
+	{
+		putLine(out, "ZenGin Archive");
+		putLine(out, "ver 1");
+		putLine(out, "zCArchiverGeneric");
+		putLine(out, format);
+		putLine(out, "saveGame 0");
+		putLine(out, "date 1.1.2002 0:00:00");
+		putLine(out, "user zencopycheck");
+		putLine(out, "END");
+		putLine(out, "objects " + std::to_string(numObjects));
+		putLine(out, "END");
+	}
+
+	/**
+	 * @brief Appends a zCMaterial the way the BINARY archiver stores it, see zCMaterial::PROPERTIES.
+	 *		  Strings end at a newline, which also skips the following whitespace, so no value starts with one.
+	 */
+	void putMaterial(std::vector<uint8_t>& out, uint32_t index)
+	{
+		std::string name = "MATERIAL_" + std::to_string(index);
+
+		putLine(out, name);
+		put(out, uint32_t(0)); // Chunk-size
+		put(out, uint16_t(0)); // Version
+		put(out, index); // Object-index
+		putLine(out, "zCMaterial");
+		putLine(out, "%");
+
+		putLine(out, name); // MaterialName
+		put(out, uint8_t(1)); // MaterialGroup
+		put(out, uint32_t(0xFF808080)); // Color
+		put(out, 60.0f); // SmoothAngle
+		putLine(out, "TEXTURE_" + std::to_string(index) + ".TGA"); // Texture
+		putLine(out, "128 128"); // TextureScale
+		put(out, 0.0f); // TextureAniFPS
+		put(out, uint8_t(0)); // TextureAniMapMode
+		putLine(out, "0 0"); // TextureAniMapDir
+		put(out, uint8_t(0)); // NoCollisionDetection
+		put(out, uint8_t(0)); // NoLightmap
+		put(out, uint8_t(0)); // LoadDontCollapse
+		putLine(out, "DETAIL"); // DetailObject
+		put(out, 1.0f); // DetailTextureScale
+		put(out, uint8_t(0)); // ForceOccluder
+		put(out, uint8_t(0)); // EnvironmentMapping
+		put(out, 1.0f); // EnvironmentalMappingStrength
+		put(out, uint8_t(0)); // WaveMode
+		put(out, uint8_t(0)); // WaveSpeed
+		put(out, 30.0f); // WaveMaxAmplitude
+		put(out, 100.0f); // WaveGridSize
+		put(out, uint8_t(0)); // IgnoreSun
+		put(out, uint8_t(1)); // AlphaFunc
+		put(out, 2.0f); // DefaultMapping
+		put(out, 2.0f);
+	}
+
+	/**
+	 * @brief Appends the chunks of a mesh with materials, vertices and a large chunk zCMesh skips.
+	 *		  Same as a .MSH, and as the world-mesh inside a .ZEN.
+	 */
+	void putMesh(std::vector<uint8_t>& out)
+	{
+		putChunk(out, MSID_MESH, [](std::vector<uint8_t>& c) {
+			put(c, uint16_t(9));
+
+			ZenConvert::zDate date = {};
+			date.year = 2002;
+			date.month = 1;
+			date.day = 1;
+			put(c, date);
+
+			putLine(c, "SYNTHETIC");
+		});
+
+		putChunk(out, MSID_BBOX3D, [](std::vector<uint8_t>& c) {
+			float bbox[] = {-1.0f, -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f};
+			for(float f : bbox)
+				put(c, f);
+		});
+
+		putChunk(out, MSID_MATLIST, [](std::vector<uint8_t>& c) {
+			putArchiveHeader(c, "BINARY", NUM_MATERIALS);
+
+			put(c, NUM_MATERIALS);
+			for(uint32_t i = 0; i < NUM_MATERIALS; i++)
+				putMaterial(c, i);
+		});
+
+		putChunk(out, MSID_LIGHTMAPLIST, [](std::vector<uint8_t>& c) {
+			c.resize(c.size() + PADDING_SIZE, 0xCD);
+		});
+
+		putChunk(out, MSID_VERTLIST, [](std::vector<uint8_t>& c) {
+			put(c, NUM_VERTICES);
+			for(uint32_t i = 0; i < NUM_VERTICES * 3; i++)
+				put(c, static_cast<float>(i));
+		});
+
+		putChunk(out, MSID_MESH_END, [](std::vector<uint8_t>&) {});
+	}
+
+	/**
+	 * @brief Creates a .MRM with one submesh per material, the positions in its data-pool and a large chunk
+	 *		  zCProgMeshProto skips
+	 */
+	std::vector<uint8_t> generateProgMesh()
+	{
+		std::vector<uint8_t> out;
+
+		putChunk(out, MSID_PROGMESH, [](std::vector<uint8_t>& c) {
+			put(c, uint16_t(0x0905));
+
+			// Data-pool, only holding the positions
+			put(c, static_cast<uint32_t>(NUM_MRM_VERTICES * 3 * sizeof(float)));
+			for(uint32_t i = 0; i < NUM_MRM_VERTICES * 3; i++)
+				put(c, static_cast<float>(i));
+
+			put(c, static_cast<uint8_t>(NUM_MRM_MATERIALS));
+
+			// Offset and size of positions and normals
+			put(c, uint32_t(0));
+			put(c, NUM_MRM_VERTICES);
+			put(c, uint32_t(0));
+			put(c, uint32_t(0));
+
+			// Offsets of the 10 lists of each submesh, all empty
+			for(uint32_t i = 0; i < NUM_MRM_MATERIALS * 20; i++)
+				put(c, uint32_t(0));
+
+			// The material-list has no count, there is one for each submesh
+			putArchiveHeader(c, "BINARY", NUM_MRM_MATERIALS);
+			for(uint32_t i = 0; i < NUM_MRM_MATERIALS; i++)
+				putMaterial(c, i);
+
+			put(c, uint8_t(0)); // Alphatest
+			for(int i = 0; i < 6; i++)
+				put(c, 0.0f); // Bounding-box
+		});
+
+		putChunk(out, MSID_PROGMESH_PADDING, [](std::vector<uint8_t>& c) {
+			c.resize(c.size() + MRM_PADDING_SIZE, 0xCD);
+		});
+
+		putChunk(out, MSID_PROGMESH_END, [](std::vector<uint8_t>&) {});
+
+		return out;
+	}
+
+	/**
+	 * @brief Appends a zCVob the way the ASCII archiver stores it, see zCVob::PROPERTIES
+	 */
+	void putVob(std::vector<uint8_t>& out, const std::string& indent, uint32_t objectIndex, const std::string& visual)
+	{
+		// Identity-matrix as the hex-dump of its floats
+		std::string rotation;
+		for(int i = 0; i < 9; i++)
+		{
+			float f = (i % 4) == 0 ? 1.0f : 0.0f;
+			const uint8_t* p = reinterpret_cast<const uint8_t*>(&f);
+			for(size_t b = 0; b < sizeof(f); b++)
+			{
+				char hex[3];
+				snprintf(hex, sizeof(hex), "%02x", p[b]);
+				rotation += hex;
+			}
+		}
+
+		putLine(out, indent + "[% zCVob 52224 " + std::to_string(objectIndex) + "]");
+		putLine(out, indent + "\tpack=int:0");
+		putLine(out, indent + "\tpresetName=string:");
+		putLine(out, indent + "\tbbox3DWS=rawFloat:-1 -1 -1 1 1 1 ");
+		putLine(out, indent + "\ttrafoOSToWSRot=raw:" + rotation);
+		putLine(out, indent + "\ttrafoOSToWSPos=vec3:0 0 0");
+		putLine(out, indent + "\tvobName=string:VOB_" + std::to_string(objectIndex));
+		putLine(out, indent + "\tvisual=string:" + visual);
+		putLine(out, indent + "\tshowVisual=bool:1");
+		putLine(out, indent + "\tvisualCamAlign=byte:0");
+		putLine(out, indent + "\tvisualAniMode=byte:0");
+		putLine(out, indent + "\tvisualAniModeStrength=float:0");
+		putLine(out, indent + "\tvobFarClipZScale=float:1");
+		putLine(out, indent + "\tcdStatic=bool:0");
+		putLine(out, indent + "\tcdDyn=bool:0");
+		putLine(out, indent + "\tstaticVob=bool:1");
+		putLine(out, indent + "\tdynShadow=byte:0");
+		putLine(out, indent + "\tzbias=int:0");
+		putLine(out, indent + "\tisAmbient=bool:0");
+		putLine(out, indent + "[]");
+	}
+
+	/**
+	 * @brief Creates an ASCII world .ZEN. The world-mesh is stored binary inside of it, like the game does,
+	 *		  followed by the vob-tree.
+	 */
+	std::vector<uint8_t> generateWorld()
+	{
+		std::vector<uint8_t> out;
+
+		putArchiveHeader(out, "ASCII", 2 * NUM_VOBS + 1);
+		putLine(out, "");
+
+		putLine(out, "[% oCWorld:zCWorld 64513 0]");
+
+		putLine(out, "\t[MeshAndBsp % 0 0]");
+		{
+			// The parser skips whitespace after the chunk-header, so the version must not start with any
+			ZenConvert::BinaryFileInfo fileInfo;
+			fileInfo.version = 0x04090000;
+			fileInfo.size = 0;
+
+			size_t fileInfoPos = out.size();
+			put(out, fileInfo);
+
+			putMesh(out);
+
+			fileInfo.size = static_cast<uint32_t>(out.size() - fileInfoPos - sizeof(fileInfo));
+			memcpy(&out[fileInfoPos], &fileInfo, sizeof(fileInfo));
+		}
+		putLine(out, "");
+		putLine(out, "\t[]");
+
+		putLine(out, "\t[VobTree % 0 0]");
+		putLine(out, "\t\tchilds0=int:" + std::to_string(NUM_VOBS));
+
+		uint32_t objectIndex = 1;
+		for(uint32_t i = 0; i < NUM_VOBS; i++)
+		{
+			putVob(out, "\t\t", objectIndex++, "MESH_" + std::to_string(i) + ".3DS");
+			putLine(out, "\t\tchilds1=int:1");
+
+			putVob(out, "\t\t\t", objectIndex++, "");
+			putLine(out, "\t\t\tchilds2=int:0");
+		}
+
+		putLine(out, "\t[]");
+		putLine(out, "\t[EndMarker % 0 0]");
+		putLine(out, "\t[]");
+		putLine(out, "[]");
+
+		return out;
+	}
+
+	/**
+	 * @brief Loads the .MRMs of the given vobs and their children, the way ZenWorld looks them up
+	 * @return Whether all of them were read correctly
+	 */
+	bool loadVobMeshes(const std::vector<ZenConvert::zCVobData>& vobs, const VDFS::FileIndex& index, uint32_t& numLoaded)
+	{
+		bool ok = true;
+		for(const ZenConvert::zCVobData& v : vobs)
+		{
+			if(v.visual.find(".3DS") != std::string::npos)
+			{
+				ZenConvert::zCProgMeshProto mesh(v.visual.substr(0, v.visual.find(".")) + ".MRM", index);
+				numLoaded++;
+
+				if(mesh.getMaterials().size() != NUM_MRM_MATERIALS || mesh.getVertices().size() != NUM_MRM_VERTICES
+					|| mesh.getMaterials().back().texture != "TEXTURE_" + std::to_string(NUM_MRM_MATERIALS - 1) + ".TGA")
+				{
+					std::cerr << "    Mesh of " << v.vobName << " was not read correctly" << std::endl;
+					ok = false;
+				}
+			}
+
+			ok = loadVobMeshes(v.childVobs, index, numLoaded) && ok;
+		}
+
+		return ok;
+	}
+
+	/**
+	 * @brief Loads the world and the meshes of its vobs from the given archive and checks what was copied on the way
+	 * @param totalSize Size of all files in the archive
+	 * @param maxCopied Bytes the archive may have copied out of the files
+	 */
+	bool checkLoad(const std::string& vdf, bool mapped, uint64_t totalSize, uint64_t maxCopied)
+	{
+		VDFS::FileIndex index;
+		if(!index.loadVDF(vdf, 0, mapped))
+		{
+			std::cerr << "Failed to load " << vdf << std::endl;
+			return false;
+		}
+
+		// Only count what loading the world does, not the catalog
+		index.resetIoStats();
+
+		s_BytesAllocated = 0;
+		s_LargestAllocation = 0;
+		s_CountAllocations = true;
+
+		bool ok = true;
+		try
+		{
+			// Same as ZenWorld: The world stays in storage while the vob-meshes are loaded
+			std::vector<uint8_t> storage;
+			VDFS::FileView view = {};
+			if(!index.getFileView(WORLD_NAME, view, &storage))
+				throw std::runtime_error("World not found");
+
+			ZenConvert::ZenParser parser(view.data, view.size);
+			parser.readHeader();
+
+			ZenConvert::oCWorldData world = parser.readWorld();
+			ZenConvert::zCMesh* worldMesh = parser.getWorldMesh();
+
+			if(!worldMesh || worldMesh->getMaterials().size() != NUM_MATERIALS || worldMesh->getVertices().size() != NUM_VERTICES
+				|| worldMesh->getMaterials().back().texture != "TEXTURE_" + std::to_string(NUM_MATERIALS - 1) + ".TGA")
+			{
+				std::cerr << "    World-mesh was not read correctly" << std::endl;
+				ok = false;
+			}
+
+			uint32_t numLoaded = 0;
+			ok = loadVobMeshes(world.rootVobs, index, numLoaded) && ok;
+
+			if(world.rootVobs.size() != NUM_VOBS || numLoaded != NUM_VOBS)
+			{
+				std::cerr << "    Vob-tree was not read correctly" << std::endl;
+				ok = false;
+			}
+		}
+		catch(std::exception& e)
+		{
+			std::cerr << "    Failed to load the world: " << e.what() << std::endl;
+			ok = false;
+		}
+		s_CountAllocations = false;
+
+		std::vector<std::pair<std::string, VDFS::ArchiveIoStats>> stats = index.getArchiveIoStats();
+		uint64_t copied = stats.empty() ? 0 : stats[0].second.bytesRead;
+		uint64_t viewed = stats.empty() ? 0 : stats[0].second.mappedBytes;
+
+		std::cout << (mapped ? "Mapped" : "Unmapped") << " archive:" << std::endl
+			<< "    " << copied << " bytes copied from the archive, " << viewed << " bytes viewed" << std::endl
+			<< "    " << s_BytesAllocated << " bytes allocated, largest allocation " << s_LargestAllocation << " bytes" << std::endl;
+
+		if(copied > maxCopied)
+		{
+			std::cerr << "    Copied more than " << maxCopied << " bytes from the archive" << std::endl;
+			ok = false;
+		}
+
+		// Whatever the world keeps is far smaller than the files, so a copy of any of them can't hide
+		uint64_t maxAllocated = maxCopied + totalSize / 2;
+		if(s_BytesAllocated > maxAllocated)
+		{
+			std::cerr << "    Allocated more than " << maxAllocated << " bytes, file-data was copied" << std::endl;
+			ok = false;
+		}
+
+		return ok;
+	}
+}
+
+void* operator new(size_t size)
+{
+	if(s_CountAllocations.load(std::memory_order_relaxed))
+	{
+		s_BytesAllocated.fetch_add(size, std::memory_order_relaxed);
+
+		uint64_t largest = s_LargestAllocation.load(std::memory_order_relaxed);
+		while(size > largest && !s_LargestAllocation.compare_exchange_weak(largest, size, std::memory_order_relaxed));
+	}
+
+	void* p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage: zencopycheck <workDirectory>" << std::endl;
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	Utils::System::mkdir(directory.c_str());
+
+	std::vector<uint8_t> world = generateWorld();
+	std::vector<uint8_t> progMesh = generateProgMesh();
+	uint64_t totalSize = world.size() + NUM_VOBS * progMesh.size();
+
+	std::string vdf = directory + "/ZENCOPYCHECK.VDF";
+	VDFS::ArchiveWriter writer;
+	writer.addFile(std::string("WORLDS/") + WORLD_NAME, static_cast<uint32_t>(world.size()), [&](std::vector<uint8_t>& data) {
+		data = world;
+		return true;
+	});
+
+	for(uint32_t i = 0; i < NUM_VOBS; i++)
+	{
+		writer.addFile("MESHES/MESH_" + std::to_string(i) + ".MRM", static_cast<uint32_t>(progMesh.size()), [&](std::vector<uint8_t>& data) {
+			data = progMesh;
+			return true;
+		});
+	}
+
+	if(!writer.writeVDF(vdf, "Archive written by zencopycheck"))
+	{
+		std::cerr << "Failed to write " << vdf << std::endl;
+		return 1;
+	}
+
+	std::cout << WORLD_NAME << ": " << world.size() << " bytes, " << NUM_VOBS << " meshes of " << progMesh.size() << " bytes" << std::endl;
+
+	// Mapped, nothing may be copied. Otherwise exactly one copy of each file out of the archive is expected.
+	bool ok = checkLoad(vdf, true, totalSize, 0);
+	ok = checkLoad(vdf, false, totalSize, totalSize) && ok;
+
+	std::cout << (ok ? "No unexpected copies" : "Unexpected copies found") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -1,15 +1,175 @@
 #pragma once
 
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
 
 namespace Utils
 {
     class System
     {
     public:
+        /**
+         * @brief Single entry of a directory listing
+         */
+        struct DirectoryEntry
+        {
+            std::string name;
+            bool isDirectory;
+            uint64_t size;
+        };
+
         static void mkdir(const char *path)
         {
             ::mkdir(path, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
         }
+
+        /**
+         * @brief Maps the given file read-only into memory
+         * @return Pointer to the mapped data, nullptr on failure or if the file is empty
+         */
+        static const void* mapFile(const char *path, size_t& size)
+        {
+            size = 0;
+
+            int fd = ::open(path, O_RDONLY);
+            if(fd < 0)
+                return nullptr;
+
+            struct stat st;
+            if(::fstat(fd, &st) != 0 || st.st_size <= 0)
+            {
+                ::close(fd);
+                return nullptr;
+            }
+
+            void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+            // The mapping stays valid after closing the descriptor
+            ::close(fd);
+
+            if(data == MAP_FAILED)
+                return nullptr;
+
+            size = static_cast<size_t>(st.st_size);
+            return data;
+        }
+
+        /**
+         * @brief Reads size bytes at the given offset of the file, without using or moving the streams position.
+         *        Safe to call from multiple threads on the same stream.
+         */
+        static bool readAt(FILE *stream, uint64_t offset, void *target, size_t size)
+        {
+            int fd = fileno(stream);
+            uint8_t* dst = reinterpret_cast<uint8_t*>(target);
+
+            // pread may return less than requested, keep going until everything is there
+            while(size > 0)
+            {
+                ssize_t r = ::pread(fd, dst, size, static_cast<off_t>(offset));
+                if(r <= 0)
+                    return false;
+
+                dst += r;
+                offset += static_cast<uint64_t>(r);
+                size -= static_cast<size_t>(r);
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Retrieves size and last modification time (in nanoseconds) of the given file
+         * @return False, if the file does not exist
+         */
+        static bool getFileStats(const char *path, uint64_t& size, uint64_t& mtime)
+        {
+            struct stat st;
+            if(::stat(path, &st) != 0)
+                return false;
+
+            size = static_cast<uint64_t>(st.st_size);
+            mtime = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+            return true;
+        }
+
+        /**
+         * @brief Lists files and subdirectories of the given directory, without "." and ".."
+         * @return False, if the directory could not be opened
+         */
+        static bool listDirectory(const char *path, std::vector<DirectoryEntry>& entries)
+        {
+            DIR* dir = ::opendir(path);
+            if(!dir)
+                return false;
+
+            while(struct dirent* e = ::readdir(dir))
+            {
+                if(strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                    continue;
+
+                // d_type isn't reliable on every filesystem, stat gives us the size anyways
+                struct stat st;
+                if(::fstatat(::dirfd(dir), e->d_name, &st, 0) != 0)
+                    continue;
+
+                DirectoryEntry entry;
+                entry.name = e->d_name;
+                entry.isDirectory = S_ISDIR(st.st_mode);
+                entry.size = static_cast<uint64_t>(st.st_size);
+                entries.push_back(entry);
+            }
+
+            ::closedir(dir);
+            return true;
+        }
+
+        /**
+         * @brief Unmaps memory previously returned by mapFile
+         */
+        static void unmapFile(const void *data, size_t size)
+        {
+            if(data)
+                ::munmap(const_cast<void*>(data), size);
+        }
+
+        /**
+         * @brief Asks the kernel to drop the cached pages of the given file, so following reads have to go to the disk again.
+         *        Only clean pages are dropped.
+         */
+        static void dropFileCache(FILE *stream)
+        {
+            ::posix_fadvise(fileno(stream), 0, 0, POSIX_FADV_DONTNEED);
+        }
+
+        /**
+         * @brief Asks the kernel to start reading the given range of the file in the background. Returns right away.
+         */
+        static void prefetchFileRange(FILE *stream, uint64_t offset, uint64_t size)
+        {
+            ::posix_fadvise(fileno(stream), static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+        }
+
+        /**
+         * @brief Asks the kernel to start paging in the given range of mapped memory. Returns right away.
+         */
+        static void prefetchMemory(const void *data, size_t size)
+        {
+            // madvise wants the start aligned to a page
+            const uintptr_t pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+            uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+            uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+
+            ::madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+        }
     };
 }
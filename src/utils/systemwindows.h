@@ -1,11 +1,27 @@
 #pragma once
 #include <Windows.h>
+#include <io.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
 
 namespace Utils
 {
     class System
     {
     public:
+		/**
+		 * @brief Single entry of a directory listing
+		 */
+		struct DirectoryEntry
+		{
+			std::string name;
+			bool isDirectory;
+			uint64_t size;
+		};
+
 		/**
 		 * @brief Creates a directory on the systems file structure
 		 */
@@ -13,6 +29,143 @@ namespace Utils
         {
 			CreateDirectory(path, nullptr);
         }
+
+		/**
+		 * @brief Maps the given file read-only into memory
+		 * @return Pointer to the mapped data, nullptr on failure or if the file is empty
+		 */
+		static const void* mapFile(const char *path, size_t& size)
+		{
+			size = 0;
+
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if(file == INVALID_HANDLE_VALUE)
+				return nullptr;
+
+			LARGE_INTEGER fileSize;
+			if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+			{
+				CloseHandle(file);
+				return nullptr;
+			}
+
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			CloseHandle(file);
+
+			if(!mapping)
+				return nullptr;
+
+			// The view keeps the mapping alive on its own
+			const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+
+			if(!data)
+				return nullptr;
+
+			size = static_cast<size_t>(fileSize.QuadPart);
+			return data;
+		}
+
+		/**
+		 * @brief Reads size bytes at the given offset of the file, without using the streams position.
+		 *		  Safe to call from multiple threads on the same stream.
+		 */
+		static bool readAt(FILE *stream, uint64_t offset, void *target, size_t size)
+		{
+			HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(stream)));
+			uint8_t* dst = reinterpret_cast<uint8_t*>(target);
+
+			while(size > 0)
+			{
+				// Offset given through the overlapped-structure makes this a positional read
+				OVERLAPPED ov = {};
+				ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+				ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+				DWORD toRead = size > 0x7FFFFFFF ? 0x7FFFFFFF : static_cast<DWORD>(size);
+				DWORD r = 0;
+				if(!ReadFile(file, dst, toRead, &r, &ov) || r == 0)
+					return false;
+
+				dst += r;
+				offset += r;
+				size -= r;
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Retrieves size and last modification time (as FILETIME) of the given file
+		 * @return False, if the file does not exist
+		 */
+		static bool getFileStats(const char *path, uint64_t& size, uint64_t& mtime)
+		{
+			WIN32_FILE_ATTRIBUTE_DATA attr;
+			if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attr))
+				return false;
+
+			size = (static_cast<uint64_t>(attr.nFileSizeHigh) << 32) | attr.nFileSizeLow;
+			mtime = (static_cast<uint64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32) | attr.ftLastWriteTime.dwLowDateTime;
+			return true;
+		}
+
+		/**
+		 * @brief Lists files and subdirectories of the given directory, without "." and ".."
+		 * @return False, if the directory could not be opened
+		 */
+		static bool listDirectory(const char *path, std::vector<DirectoryEntry>& entries)
+		{
+			WIN32_FIND_DATAA data;
+			HANDLE find = FindFirstFileA((std::string(path) + "\\*").c_str(), &data);
+			if(find == INVALID_HANDLE_VALUE)
+				return false;
+
+			do
+			{
+				if(strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+					continue;
+
+				DirectoryEntry entry;
+				entry.name = data.cFileName;
+				entry.isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+				entry.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+				entries.push_back(entry);
+			}while(FindNextFileA(find, &data));
+
+			FindClose(find);
+			return true;
+		}
+
+		/**
+		 * @brief Unmaps memory previously returned by mapFile
+		 */
+		static void unmapFile(const void *data, size_t)
+		{
+			if(data)
+				UnmapViewOfFile(data);
+		}
+
+		/**
+		 * @brief Not supported on Windows, the cache can't be dropped for a single file
+		 */
+		static void dropFileCache(FILE *)
+		{
+		}
+
+		/**
+		 * @brief Not supported on Windows, files get read when they are needed
+		 */
+		static void prefetchFileRange(FILE *, uint64_t, uint64_t)
+		{
+		}
+
+		/**
+		 * @brief Not supported on Windows, mapped memory gets paged in when it is touched
+		 */
+		static void prefetchMemory(const void *, size_t)
+		{
+		}
     };
 }
 
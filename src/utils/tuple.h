@@ -46,6 +46,15 @@ namespace Utils
 		tf::_internal_for_each(t, f, tf::gen_seq<sizeof...(Ts)>());
 	}
 
+	/**
+	* @brief Calls lambda-function f for each element in the constant tuple t
+	*/
+	template<typename... Ts, typename F>
+	void for_each_in_tuple(const std::tuple<Ts...>& t, F f)
+	{
+		tf::_internal_for_each(t, f, tf::gen_seq<sizeof...(Ts)>());
+	}
+
 	/**
 	* Example:
 	* auto t = std::make_tuple(1, 2, "test", 4.0f);
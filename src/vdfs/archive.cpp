@@ -0,0 +1,97 @@
+#include "archive.h"
+#include "fileIndex.h"
+#include <chrono>
+
+using namespace VDFS;
+
+Archive::Archive() :
+	m_ArchivePriority(0),
+	m_BytesRead(0),
+	m_NumReads(0),
+	m_SeekDistance(0),
+	m_ReadNanoseconds(0),
+	m_LastReadEnd(0),
+	m_MappedBytes(0),
+	m_NumViews(0)
+{
+}
+
+/**
+ * @brief Returns the I/O counters of this archive
+ */
+ArchiveIoStats Archive::getIoStats() const
+{
+	ArchiveIoStats s;
+	s.bytesRead = m_BytesRead.load(std::memory_order_relaxed);
+	s.numReads = m_NumReads.load(std::memory_order_relaxed);
+	s.seekDistance = m_SeekDistance.load(std::memory_order_relaxed);
+	s.readNanoseconds = m_ReadNanoseconds.load(std::memory_order_relaxed);
+	s.mappedBytes = m_MappedBytes.load(std::memory_order_relaxed);
+	s.numViews = m_NumViews.load(std::memory_order_relaxed);
+
+	return s;
+}
+
+void Archive::resetIoStats()
+{
+	m_BytesRead = 0;
+	m_NumReads = 0;
+	m_SeekDistance = 0;
+	m_ReadNanoseconds = 0;
+	m_LastReadEnd = 0;
+	m_MappedBytes = 0;
+	m_NumViews = 0;
+}
+
+/**
+ * @brief Counts a read of size bytes at the given offset
+ */
+void Archive::recordRead(uint64_t offset, uint64_t size, bool seekable) const
+{
+	m_BytesRead.fetch_add(size, std::memory_order_relaxed);
+	m_NumReads.fetch_add(1, std::memory_order_relaxed);
+
+	if(!seekable)
+		return;
+
+	// With multiple threads reading, this is the distance to whichever read finished being counted last
+	uint64_t lastEnd = m_LastReadEnd.exchange(offset + size, std::memory_order_relaxed);
+	m_SeekDistance.fetch_add(offset > lastEnd ? offset - lastEnd : lastEnd - offset, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Counts a view of size bytes handed out by getFileView
+ */
+void Archive::recordView(uint64_t size) const
+{
+	m_MappedBytes.fetch_add(size, std::memory_order_relaxed);
+	m_NumViews.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+uint64_t Archive::getTimestamp()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Adds the time spent waiting for one or more reads
+ */
+void Archive::recordReadTime(uint64_t nanoseconds) const
+{
+	m_ReadNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Extracts the files one by one
+ */
+bool Archive::extractFiles(const std::vector<const FileInfo*>& files, const std::vector<uint8_t*>& targets, BatchReader&) const
+{
+	bool allRead = true;
+	for(size_t i = 0; i < files.size(); i++)
+		allRead = extractRange(*files[i], 0, files[i]->fileSize, targets[i]) && allRead;
+
+	return allRead;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace VDFS
+{
+	struct FileInfo;
+	class FileIndex;
+	class BatchReader;
+
+	/**
+	 * @brief Read-only view into the data of a single file. Only valid as long as the archive it points into is loaded.
+	 */
+	struct FileView
+	{
+		const uint8_t* data;
+		size_t size;
+	};
+
+	/**
+	 * @brief I/O done by an archive since it was loaded, or since its stats were last reset
+	 */
+	struct ArchiveIoStats
+	{
+		uint64_t bytesRead;
+		uint64_t numReads;
+		uint64_t seekDistance; // Sum of the distances between the end of one read and the start of the next one
+		uint64_t readNanoseconds; // Time spent waiting for reads, summed up over all threads
+		uint64_t mappedBytes; // Bytes handed out as views, without being read or copied
+		uint64_t numViews;
+	};
+
+	/**
+	 * @brief Common interface of everything files can be loaded from. FileInfos registered in the index point to one of these.
+	 */
+	class Archive
+	{
+	public:
+		Archive();
+		virtual ~Archive() {}
+
+		/**
+		 * @brief Puts all files into the index, if the priority is right
+		 * @return number of files actually added to the index
+		 */
+		virtual size_t insertFilesIntoIndex(FileIndex& index) = 0;
+
+		/**
+		 * @brief Fills a vector with the data of a file. Safe to call from multiple threads at once.
+		 */
+		virtual bool extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const = 0;
+
+		/**
+		 * @brief Reads size bytes of the file, starting at the given offset inside of it. Safe to call from multiple threads at once.
+		 * @return False, if the range is out of bounds or could not be read
+		 */
+		virtual bool extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const = 0;
+
+		/**
+		 * @brief Extracts multiple files of this archive as one batch. targets[i] must have room for files[i]->fileSize bytes.
+		 *		  Archives which support it submit the reads through the given reader, the others extract the files one by one.
+		 * @return False, if any of the files could not be read
+		 */
+		virtual bool extractFiles(const std::vector<const FileInfo*>& files, const std::vector<uint8_t*>& targets, BatchReader& reader) const;
+
+		/**
+		 * @brief Points the given view directly to the data of the file, without copying it.
+		 * @return False, if the file can't be viewed this way
+		 */
+		virtual bool getFileView(const FileInfo& inf, FileView& view) const = 0;
+
+		/**
+		 * @brief Hints the OS to start reading the file in the background, so a following extraction doesn't have to wait
+		 *		  for the disk. Returns right away. Does nothing for archives which can't give such hints.
+		 */
+		virtual void prefetch(const FileInfo&) const {}
+
+		/**
+		 * @brief Returns the path this archive was loaded from
+		 */
+		const std::string& getFilePath() const { return m_FilePath; }
+
+		/**
+		 * @brief Returns the priority of the files of this archive
+		 */
+		uint32_t getPriority() const { return m_ArchivePriority; }
+
+		/**
+		 * @brief Returns the I/O counters of this archive. Safe to call while reads are running.
+		 */
+		ArchiveIoStats getIoStats() const;
+		void resetIoStats();
+
+	protected:
+		/**
+		 * @brief Counts a read of size bytes at the given offset. Files of an archive without a common address-space
+		 *		  pass seekable = false, so no seek distance is added for them.
+		 */
+		void recordRead(uint64_t offset, uint64_t size, bool seekable = true) const;
+
+		/**
+		 * @brief Adds the time spent waiting for one or more reads
+		 */
+		void recordReadTime(uint64_t nanoseconds) const;
+
+		/**
+		 * @brief Counts a view of size bytes handed out by getFileView
+		 */
+		void recordView(uint64_t size) const;
+
+		/**
+		 * @brief Monotonic time in nanoseconds, for measuring reads
+		 */
+		static uint64_t getTimestamp();
+
+		/**
+		 * @brief Priority for files of this archive
+		 */
+		uint32_t m_ArchivePriority;
+
+		/**
+		 * @brief Path this archive was loaded from
+		 */
+		std::string m_FilePath;
+
+	private:
+		/**
+		 * @brief I/O counters, see getIoStats. m_LastReadEnd is where the previous read stopped.
+		 */
+		mutable std::atomic<uint64_t> m_BytesRead;
+		mutable std::atomic<uint64_t> m_NumReads;
+		mutable std::atomic<uint64_t> m_SeekDistance;
+		mutable std::atomic<uint64_t> m_ReadNanoseconds;
+		mutable std::atomic<uint64_t> m_LastReadEnd;
+		mutable std::atomic<uint64_t> m_MappedBytes;
+		mutable std::atomic<uint64_t> m_NumViews;
+	};
+}
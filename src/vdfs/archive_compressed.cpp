@@ -0,0 +1,412 @@
+#include "archive_compressed.h"
+#include "fileIndex.h"
+#include "lz4block.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include <string.h>
+#include <algorithm>
+
+/**
+ * Quick format rundown:
+ *
+ * Each file starts with a CompressedVdfHeader, directly followed by the compressed blocks of all files.
+ * Every file is split into blocks of Header.BlockSize bytes (the last one may be smaller), which are LZ4-compressed
+ * on their own. Blocks which wouldn't get smaller are stored as they are.
+ *
+ * The catalog is placed at Header.CatalogOffset, after all blocks, and consists out of Header.NumFiles entries of
+ * the type CompressedVdfFile, Header.NumBlocks entries of CompressedVdfBlock and the path-blob holding the paths of
+ * all files inside the archive.
+ *
+ * Since the block table knows where each block starts, reading a range of a file only has to decompress the blocks
+ * overlapping that range.
+ */
+
+using namespace VDFS;
+
+ArchiveCompressed::ArchiveCompressed() :
+	m_pStream(nullptr),
+	m_pMappedData(nullptr),
+	m_MappedSize(0)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+}
+
+ArchiveCompressed::~ArchiveCompressed()
+{
+	closeArchive();
+}
+
+/**
+ * @brief Closes the stream or unmaps the archive
+ */
+void ArchiveCompressed::closeArchive()
+{
+	if(m_pStream)
+		fclose(m_pStream);
+
+	Utils::System::unmapFile(m_pMappedData, m_MappedSize);
+
+	m_pStream = nullptr;
+	m_pMappedData = nullptr;
+	m_MappedSize = 0;
+}
+
+/**
+ * @brief Checks whether the given file starts with the signature of a compressed archive
+ */
+bool ArchiveCompressed::isCompressedArchive(const std::string& file)
+{
+	FILE* f = fopen(file.c_str(), "rb");
+	if(!f)
+		return false;
+
+	char signature[sizeof(CompressedVdfHeader::Signature)];
+	bool r = fread(signature, sizeof(signature), 1, f) == 1
+		&& memcmp(signature, CVDF_SIGNATURE, strlen(CVDF_SIGNATURE)) == 0;
+
+	fclose(f);
+	return r;
+}
+
+/**
+ * @brief Loads the given compressed archive and its catalog
+ */
+bool ArchiveCompressed::loadArchive(const std::string& file, uint32_t priority, bool memoryMapped)
+{
+	if(m_pStream || m_pMappedData)
+		closeArchive();
+
+	if(memoryMapped)
+	{
+		m_pMappedData = reinterpret_cast<const uint8_t*>(Utils::System::mapFile(file.c_str(), m_MappedSize));
+		if(!m_pMappedData)
+		{
+			LogError() << "Failed to map file into memory: " << file;
+			return false;
+		}
+	}
+	else
+	{
+		m_pStream = fopen(file.c_str(), "rb");
+		if(!m_pStream)
+		{
+			LogError() << "Failed to open file: " << file;
+			return false;
+		}
+	}
+
+	if(!readData(0, sizeof(m_Header), reinterpret_cast<uint8_t*>(&m_Header))
+		|| memcmp(m_Header.Signature, CVDF_SIGNATURE, strlen(CVDF_SIGNATURE)) != 0)
+	{
+		LogError() << "Not a compressed VDF-Archive: " << file;
+		closeArchive();
+		return false;
+	}
+
+	if(m_Header.Version != CVDF_VERSION || m_Header.BlockSize == 0)
+	{
+		LogError() << "Unsupported compressed VDF-Archive version " << m_Header.Version << ": " << file;
+		closeArchive();
+		return false;
+	}
+
+	uint64_t fileSize = m_MappedSize;
+	uint64_t mtime;
+	if(!m_pMappedData && !Utils::System::getFileStats(file.c_str(), fileSize, mtime))
+	{
+		LogError() << "Failed to get size of file: " << file;
+		closeArchive();
+		return false;
+	}
+
+	uint64_t blocksOffset = m_Header.CatalogOffset + sizeof(CompressedVdfFile) * static_cast<uint64_t>(m_Header.NumFiles);
+	uint64_t pathsOffset = blocksOffset + sizeof(CompressedVdfBlock) * static_cast<uint64_t>(m_Header.NumBlocks);
+
+	// Don't allocate for a catalog the file can't hold
+	if(m_Header.CatalogOffset > fileSize || pathsOffset + m_Header.PathBlobSize > fileSize)
+	{
+		LogError() << "Catalog of compressed VDF-Archive reaches past the end of the file: " << file;
+		closeArchive();
+		return false;
+	}
+
+	// Read the catalog
+	m_Files.resize(m_Header.NumFiles);
+	m_Blocks.resize(m_Header.NumBlocks);
+	m_Paths.resize(m_Header.PathBlobSize);
+
+	bool ok = readData(m_Header.CatalogOffset, m_Files.size() * sizeof(CompressedVdfFile), reinterpret_cast<uint8_t*>(m_Files.data()))
+		&& readData(blocksOffset, m_Blocks.size() * sizeof(CompressedVdfBlock), reinterpret_cast<uint8_t*>(m_Blocks.data()))
+		&& readData(pathsOffset, m_Paths.size(), reinterpret_cast<uint8_t*>(&m_Paths[0]));
+
+	// Make sure nothing in the catalog points outside of it
+	for(size_t i = 0; i < m_Files.size() && ok; i++)
+	{
+		const CompressedVdfFile& f = m_Files[i];
+		uint64_t numBlocks = (static_cast<uint64_t>(f.Size) + m_Header.BlockSize - 1) / m_Header.BlockSize;
+
+		ok = f.FirstBlock + numBlocks <= m_Blocks.size()
+			&& static_cast<uint64_t>(f.PathOffset) + f.PathLength <= m_Paths.size()
+			&& f.NameLength <= f.PathLength;
+	}
+
+	// ...and no block outside of the file
+	for(size_t i = 0; i < m_Blocks.size() && ok; i++)
+	{
+		const CompressedVdfBlock& b = m_Blocks[i];
+		ok = b.Offset <= fileSize && (b.Size & ~CVDF_BLOCK_STORED) <= fileSize - b.Offset;
+	}
+
+	if(!ok)
+	{
+		LogError() << "Failed to read catalog of compressed VDF-Archive: " << file;
+		m_Files.clear();
+		m_Blocks.clear();
+		m_Paths.clear();
+		closeArchive();
+		return false;
+	}
+
+	m_ArchivePriority = priority;
+	m_FilePath = file;
+
+	return true;
+}
+
+/**
+ * @brief Reads size bytes starting at the given archive offset into target
+ */
+bool ArchiveCompressed::readData(uint64_t offset, size_t size, uint8_t* target) const
+{
+	if(size == 0)
+		return true;
+
+	if(m_pMappedData)
+	{
+		if(offset > m_MappedSize || size > m_MappedSize - offset)
+			return false;
+
+		uint64_t start = getTimestamp();
+		memcpy(target, m_pMappedData + offset, size);
+
+		recordRead(offset, size);
+		recordReadTime(getTimestamp() - start);
+		return true;
+	}
+
+	if(!m_pStream)
+		return false;
+
+	uint64_t start = getTimestamp();
+	bool ok = Utils::System::readAt(m_pStream, offset, target, size);
+
+	recordRead(offset, size);
+	recordReadTime(getTimestamp() - start);
+	return ok;
+}
+
+/**
+ * @brief Puts all files into the index, if the priority is right
+ */
+size_t ArchiveCompressed::insertFilesIntoIndex(FileIndex& index)
+{
+	size_t r = 0;
+
+	listFiles([&](const FileInfo& f, const std::string& path){
+		// Directory is everything up to the name
+		if(index.addFile(f, std::string_view(path).substr(0, path.size() - f.fileName.size())))
+			r++;
+	});
+
+	return r;
+}
+
+/**
+ * @brief Calls the callback for every file in the archive, with the path of the file inside the archive
+ */
+void ArchiveCompressed::listFiles(std::function<void(const FileInfo&, const std::string&)> callback) const
+{
+	for(size_t i = 0; i < m_Files.size(); i++)
+	{
+		const CompressedVdfFile& e = m_Files[i];
+		std::string path = m_Paths.substr(e.PathOffset, e.PathLength);
+
+		FileInfo f;
+		f.fileName = path.substr(path.size() - e.NameLength);
+		f.fileSize = e.Size;
+		f.targetArchive = const_cast<ArchiveCompressed*>(this);
+		f.archiveOffset = static_cast<uint32_t>(i);
+		f.priority = m_ArchivePriority;
+
+		callback(f, path);
+	}
+}
+
+/**
+ * @brief Returns the entry of the given file, nullptr if it doesn't belong to this archive
+ */
+const CompressedVdfFile* ArchiveCompressed::getFileEntry(const FileInfo& inf) const
+{
+	if(inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+	{
+		LogWarn() << "Trying to extract file from archive other than the files target archive! Aborting extraction";
+		return nullptr;
+	}
+
+	return &m_Files[inf.archiveOffset];
+}
+
+/**
+ * @brief Decompresses a single block of a file into target
+ */
+bool ArchiveCompressed::readBlock(uint32_t block, uint32_t uncompressedSize, uint8_t* target, std::vector<uint8_t>& compressed) const
+{
+	const CompressedVdfBlock& b = m_Blocks[block];
+	uint32_t size = b.Size & ~CVDF_BLOCK_STORED;
+
+	if(b.Size & CVDF_BLOCK_STORED)
+		return size == uncompressedSize && readData(b.Offset, size, target);
+
+	// Decompress straight out of the mapping if we can
+	if(m_pMappedData)
+	{
+		if(b.Offset > m_MappedSize || size > m_MappedSize - b.Offset)
+			return false;
+
+		// Can't tell page faults apart from decompressing here, so only the bytes are counted
+		recordRead(b.Offset, size);
+		return LZ4::decompress(m_pMappedData + b.Offset, size, target, uncompressedSize);
+	}
+
+	compressed.resize(size);
+	return readData(b.Offset, size, compressed.data())
+		&& LZ4::decompress(compressed.data(), size, target, uncompressedSize);
+}
+
+/**
+ * @brief Decompresses the whole file
+ */
+bool ArchiveCompressed::extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const
+{
+	const CompressedVdfFile* e = getFileEntry(inf);
+	if(!e)
+		return false;
+
+	fileData.resize(e->Size);
+
+	if(!extractRange(inf, 0, e->Size, fileData.data()))
+	{
+		LogError() << "Error while reading compressed VDFS-file " << inf.fileName;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Decompresses only the blocks needed for the given range of the file
+ */
+bool ArchiveCompressed::extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const
+{
+	const CompressedVdfFile* e = getFileEntry(inf);
+	if(!e || offset > e->Size || size > e->Size - offset)
+		return false;
+
+	const uint32_t blockSize = m_Header.BlockSize;
+	std::vector<uint8_t> compressed;
+	std::vector<uint8_t> partial;
+
+	uint32_t pos = offset;
+	const uint32_t end = offset + size;
+	while(pos < end)
+	{
+		uint32_t blockInFile = pos / blockSize;
+		uint32_t blockStart = blockInFile * blockSize;
+		uint32_t blockLength = std::min(blockSize, e->Size - blockStart);
+		uint32_t inBlock = pos - blockStart;
+		uint32_t toCopy = std::min(blockLength - inBlock, end - pos);
+
+		// Whole blocks go straight to the target, others need to be decompressed somewhere else first
+		if(inBlock == 0 && toCopy == blockLength)
+		{
+			if(!readBlock(e->FirstBlock + blockInFile, blockLength, target + (pos - offset), compressed))
+				return false;
+		}
+		else
+		{
+			partial.resize(blockLength);
+			if(!readBlock(e->FirstBlock + blockInFile, blockLength, partial.data(), compressed))
+				return false;
+
+			memcpy(target + (pos - offset), partial.data() + inBlock, toCopy);
+		}
+
+		pos += toCopy;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Hints the OS to read the blocks of the file in the background
+ */
+void ArchiveCompressed::prefetch(const FileInfo& inf) const
+{
+	if(inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+		return;
+
+	const CompressedVdfFile& e = m_Files[inf.archiveOffset];
+	uint64_t numBlocks = (static_cast<uint64_t>(e.Size) + m_Header.BlockSize - 1) / m_Header.BlockSize;
+	if(numBlocks == 0)
+		return;
+
+	// Blocks of a file are written one after another
+	const CompressedVdfBlock& last = m_Blocks[e.FirstBlock + numBlocks - 1];
+	uint64_t start = m_Blocks[e.FirstBlock].Offset;
+	uint64_t end = last.Offset + (last.Size & ~CVDF_BLOCK_STORED);
+	if(end < start)
+		return;
+
+	if(m_pMappedData)
+	{
+		if(end <= m_MappedSize)
+			Utils::System::prefetchMemory(m_pMappedData + start, static_cast<size_t>(end - start));
+	}
+	else if(m_pStream)
+		Utils::System::prefetchFileRange(m_pStream, start, end - start);
+}
+
+/**
+ * @brief Only works for files whose blocks are all stored uncompressed inside a mapped archive
+ */
+bool ArchiveCompressed::getFileView(const FileInfo& inf, FileView& view) const
+{
+	if(!m_pMappedData || inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+		return false;
+
+	const CompressedVdfFile& e = m_Files[inf.archiveOffset];
+	uint64_t numBlocks = (static_cast<uint64_t>(e.Size) + m_Header.BlockSize - 1) / m_Header.BlockSize;
+	if(numBlocks == 0)
+		return false;
+
+	// Stored blocks of a file follow each other without gaps, so they can be viewed as one
+	uint64_t start = m_Blocks[e.FirstBlock].Offset;
+	uint64_t expected = start;
+	for(uint64_t i = 0; i < numBlocks; i++)
+	{
+		const CompressedVdfBlock& b = m_Blocks[e.FirstBlock + i];
+		if(!(b.Size & CVDF_BLOCK_STORED) || b.Offset != expected)
+			return false;
+
+		expected += b.Size & ~CVDF_BLOCK_STORED;
+	}
+
+	if(expected > m_MappedSize || expected - start != e.Size)
+		return false;
+
+	view.data = m_pMappedData + start;
+	view.size = e.Size;
+	recordView(view.size);
+
+	return true;
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdio.h>
+#include "archive.h"
+
+namespace VDFS
+{
+	// These files are read straight into the structs, no packing
+#pragma pack(push, 1)
+
+	const char* const CVDF_SIGNATURE = "OpenZE-CVDF\x1A";
+	const uint32_t CVDF_VERSION = 1;
+	const uint32_t CVDF_DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	// Header flags
+	const uint32_t CVDF_FLAG_GOTHIC1 = 1; // Converted from an archive with the Gothic 1 signature
+
+	// Set in CompressedVdfBlock::Size if the block didn't compress and is stored as it is
+	const uint32_t CVDF_BLOCK_STORED = 0x80000000;
+
+	/**
+	 * @brief Header of a compressed VDF-Archive
+	 */
+	struct CompressedVdfHeader
+	{
+		char Signature[16];
+		uint32_t Version;
+		uint32_t Flags;
+		uint32_t BlockSize; // Uncompressed size of every block, except for the last one of each file
+		uint32_t NumFiles;
+		uint32_t NumBlocks;
+		uint32_t PathBlobSize;
+		uint64_t CatalogOffset; // Files, then blocks, then the path-blob
+	};
+
+	/**
+	 * @brief Single file inside the compressed archive. Its blocks are listed contiguously in the block table.
+	 */
+	struct CompressedVdfFile
+	{
+		uint32_t Size;
+		uint32_t FirstBlock;
+		uint32_t PathOffset;
+		uint16_t PathLength;
+		uint16_t NameLength; // The name is the end of the path
+	};
+
+	/**
+	 * @brief LZ4-compressed block of file data
+	 */
+	struct CompressedVdfBlock
+	{
+		uint64_t Offset;
+		uint32_t Size; // May be bitmasked by CVDF_BLOCK_STORED
+	};
+#pragma pack(pop)
+
+	/**
+	 * @brief VDF-Archive with its file data split into LZ4-compressed blocks. Single files and ranges of them
+	 *		  can be decompressed on their own. Written by ArchiveWriter::writeCompressedVDF.
+	 */
+	class ArchiveCompressed : public Archive
+	{
+	public:
+		ArchiveCompressed();
+		~ArchiveCompressed();
+
+		/**
+		 * @brief Checks whether the given file starts with the signature of a compressed archive
+		 */
+		static bool isCompressedArchive(const std::string& file);
+
+		/**
+		 * @brief Loads the given compressed archive and its catalog
+		 * @param memoryMapped Whether to map the whole archive into memory instead of reading blocks through a stream
+		 */
+		bool loadArchive(const std::string& file, uint32_t priority = 0, bool memoryMapped = false);
+
+		/**
+		 * @brief Puts all files into the index, if the priority is right
+		 * @return number of files actually added to the index
+		 */
+		size_t insertFilesIntoIndex(FileIndex& index) override;
+
+		/**
+		 * @brief Calls the callback for every file in the archive, with the path of the file inside the archive
+		 */
+		void listFiles(std::function<void(const FileInfo&, const std::string&)> callback) const;
+
+		/**
+		 * @brief Decompresses the whole file. Safe to call from multiple threads at once.
+		 */
+		bool extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const override;
+
+		/**
+		 * @brief Decompresses only the blocks needed for the given range of the file. Safe to call from multiple threads at once.
+		 * @return False, if the range is out of bounds or the data is corrupt
+		 */
+		bool extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const override;
+
+		/**
+		 * @brief Hints the OS to read the blocks of the file in the background
+		 */
+		void prefetch(const FileInfo& inf) const override;
+
+		/**
+		 * @brief Only works for files whose blocks are all stored uncompressed inside a mapped archive
+		 */
+		bool getFileView(const FileInfo& inf, FileView& view) const override;
+
+		/**
+		 * @brief Returns whether the archive was converted from one built for Gothic 1
+		 */
+		bool isGothic1() const { return (m_Header.Flags & CVDF_FLAG_GOTHIC1) != 0; }
+
+		/**
+		 * @brief Uncompressed size of the blocks of this archive
+		 */
+		uint32_t getBlockSize() const { return m_Header.BlockSize; }
+
+	private:
+		/**
+		 * @brief Reads size bytes starting at the given archive offset into target
+		 */
+		bool readData(uint64_t offset, size_t size, uint8_t* target) const;
+
+		/**
+		 * @brief Decompresses a single block of a file into target
+		 * @param compressed Scratch-buffer for the compressed data
+		 */
+		bool readBlock(uint32_t block, uint32_t uncompressedSize, uint8_t* target, std::vector<uint8_t>& compressed) const;
+
+		/**
+		 * @brief Returns the entry of the given file, nullptr if it doesn't belong to this archive
+		 */
+		const CompressedVdfFile* getFileEntry(const FileInfo& inf) const;
+
+		/**
+		 * @brief Closes the stream or unmaps the archive
+		 */
+		void closeArchive();
+
+		/**
+		 * @brief File-Stream for this archive
+		 */
+		FILE* m_pStream;
+
+		/**
+		 * @brief Mapped archive-data, if loaded as memory mapped file
+		 */
+		const uint8_t* m_pMappedData;
+		size_t m_MappedSize;
+
+		/**
+		 * @brief Header and catalog of the loaded archive. FileInfo::archiveOffset is the index into m_Files.
+		 */
+		CompressedVdfHeader m_Header;
+		std::vector<CompressedVdfFile> m_Files;
+		std::vector<CompressedVdfBlock> m_Blocks;
+		std::string m_Paths;
+	};
+}
@@ -0,0 +1,244 @@
+#include "archive_physical.h"
+#include "fileIndex.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace VDFS;
+
+ArchivePhysical::ArchivePhysical() :
+	m_MemoryMapped(false)
+{
+}
+
+ArchivePhysical::~ArchivePhysical()
+{
+	for(size_t i = 0; i < m_MappedFiles.size(); i++)
+		Utils::System::unmapFile(m_MappedFiles[i], m_MappedSizes[i]);
+}
+
+/**
+ * @brief Scans the given directory and all its subdirectories for files
+ */
+bool ArchivePhysical::loadDirectory(const std::string& directory, uint32_t priority, bool memoryMapped)
+{
+	m_Files.clear();
+	if(!scanDirectory(directory, ""))
+		return false;
+
+	m_FilePath = directory;
+	m_ArchivePriority = priority;
+	m_MemoryMapped = memoryMapped;
+
+	m_MappedFiles.assign(m_Files.size(), nullptr);
+	m_MappedSizes.assign(m_Files.size(), 0);
+
+	return true;
+}
+
+/**
+ * @brief Adds all files of the given directory, and recurses into its subdirectories
+ */
+bool ArchivePhysical::scanDirectory(const std::string& directory, const std::string& relative)
+{
+	std::vector<Utils::System::DirectoryEntry> entries;
+	if(!Utils::System::listDirectory(directory.c_str(), entries))
+		return false;
+
+	// Listing order depends on the filesystem. Sort, so duplicate names always resolve the same way.
+	std::sort(entries.begin(), entries.end(), [](const Utils::System::DirectoryEntry& a, const Utils::System::DirectoryEntry& b) {
+		return a.name < b.name;
+	});
+
+	for(const auto& e : entries)
+	{
+		std::string path = directory + "/" + e.name;
+
+		if(e.isDirectory)
+		{
+			if(!scanDirectory(path, relative.empty() ? e.name : relative + "/" + e.name))
+				LogWarn() << "Failed to open directory: " << path;
+
+			continue;
+		}
+
+		// Same limit as inside the VDFs
+		if(e.size > 0xFFFFFFFF)
+		{
+			LogWarn() << "File too large, skipping: " << path;
+			continue;
+		}
+
+		PhysicalFile f;
+		f.name = e.name;
+		f.path = path;
+		f.directory = relative;
+		f.size = static_cast<uint32_t>(e.size);
+		m_Files.push_back(f);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Puts all files into the index, if the priority is right
+ */
+size_t ArchivePhysical::insertFilesIntoIndex(FileIndex& index)
+{
+	size_t r = 0;
+
+	for(size_t i = 0; i < m_Files.size(); i++)
+	{
+		FileInfo f;
+		f.fileName = m_Files[i].name;
+		f.fileSize = m_Files[i].size;
+		f.targetArchive = this;
+		f.archiveOffset = static_cast<uint32_t>(i);
+		f.priority = m_ArchivePriority;
+
+		if(index.addFile(f, m_Files[i].directory))
+			r++;
+	}
+
+	return r;
+}
+
+/**
+ * @brief Reads the file from disk in a single read
+ */
+bool ArchivePhysical::extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const
+{
+	if(inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+	{
+		LogWarn() << "Trying to extract file from archive other than the files target archive! Aborting extraction";
+		return false;
+	}
+
+	const PhysicalFile& pf = m_Files[inf.archiveOffset];
+
+	FILE* f = fopen(pf.path.c_str(), "rb");
+	if(!f)
+	{
+		LogError() << "Failed to open file: " << pf.path;
+		return false;
+	}
+
+	// Size is known from the scan, so no need to ask the filesystem again
+	fileData.resize(pf.size);
+
+	uint64_t start = getTimestamp();
+	bool ok = pf.size == 0 || Utils::System::readAt(f, 0, fileData.data(), pf.size);
+	fclose(f);
+
+	recordRead(0, pf.size, false);
+	recordReadTime(getTimestamp() - start);
+
+	if(!ok)
+	{
+		LogError() << "Error while reading file " << pf.path;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Reads only the given range of the file
+ */
+bool ArchivePhysical::extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const
+{
+	if(inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+	{
+		LogWarn() << "Trying to extract file from archive other than the files target archive! Aborting extraction";
+		return false;
+	}
+
+	const PhysicalFile& pf = m_Files[inf.archiveOffset];
+	if(offset > pf.size || size > pf.size - offset)
+		return false;
+
+	if(size == 0)
+		return true;
+
+	// Already mapped? Then there is no need to go to the disk
+	{
+		std::lock_guard<std::mutex> guard(m_MappingMutex);
+
+		const uint8_t* mapped = m_MappedFiles[inf.archiveOffset];
+		if(mapped && static_cast<size_t>(offset) + size <= m_MappedSizes[inf.archiveOffset])
+		{
+			memcpy(target, mapped + offset, size);
+			recordRead(offset, size, false);
+			return true;
+		}
+	}
+
+	FILE* f = fopen(pf.path.c_str(), "rb");
+	if(!f)
+	{
+		LogError() << "Failed to open file: " << pf.path;
+		return false;
+	}
+
+	uint64_t start = getTimestamp();
+	bool ok = Utils::System::readAt(f, offset, target, size);
+	fclose(f);
+
+	recordRead(offset, size, false);
+	recordReadTime(getTimestamp() - start);
+
+	if(!ok)
+		LogError() << "Error while reading file " << pf.path;
+
+	return ok;
+}
+
+/**
+ * @brief Hints the OS to read the file in the background
+ */
+void ArchivePhysical::prefetch(const FileInfo& inf) const
+{
+	if(inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+		return;
+
+	const PhysicalFile& pf = m_Files[inf.archiveOffset];
+	if(pf.size == 0)
+		return;
+
+	// The page cache belongs to the file, not to the descriptor, so the hint outlives closing it again
+	FILE* f = fopen(pf.path.c_str(), "rb");
+	if(!f)
+		return;
+
+	Utils::System::prefetchFileRange(f, 0, pf.size);
+	fclose(f);
+}
+
+/**
+ * @brief Maps the file into memory and points the view there
+ */
+bool ArchivePhysical::getFileView(const FileInfo& inf, FileView& view) const
+{
+	if(!m_MemoryMapped || inf.targetArchive != this || inf.archiveOffset >= m_Files.size())
+		return false;
+
+	std::lock_guard<std::mutex> guard(m_MappingMutex);
+
+	size_t idx = inf.archiveOffset;
+	if(!m_MappedFiles[idx])
+	{
+		m_MappedFiles[idx] = reinterpret_cast<const uint8_t*>(Utils::System::mapFile(m_Files[idx].path.c_str(), m_MappedSizes[idx]));
+
+		// Empty files can't be mapped, let the caller read them instead
+		if(!m_MappedFiles[idx])
+			return false;
+	}
+
+	view.data = m_MappedFiles[idx];
+	view.size = m_MappedSizes[idx];
+	recordView(view.size);
+
+	return true;
+}
@@ -1,10 +1,93 @@
 #pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include "archive.h"
 
 namespace VDFS
 {
-	class ArchivePhysical
+	/**
+	 * @brief Priority of loose files. Higher than anything loaded from VDF-archives, so they always override those.
+	 */
+	const uint32_t ARCHIVE_PHYSICAL_PRIORITY = 0xFFFFFFFF;
+
+	/**
+	 * @brief Archive made from the loose files of a directory on disk, usually used to override files
+	 *		  of the VDF-archives without repacking them. The directory tree is only scanned once when loading.
+	 */
+	class ArchivePhysical : public Archive
 	{
 	public:
-		ArchivePhysical(){}
+		ArchivePhysical();
+		~ArchivePhysical();
+
+		/**
+		 * @brief Scans the given directory and all its subdirectories for files
+		 * @param memoryMapped Map files into memory the first time they are viewed, instead of reading them
+		 */
+		bool loadDirectory(const std::string& directory, uint32_t priority = ARCHIVE_PHYSICAL_PRIORITY, bool memoryMapped = false);
+
+		/**
+		 * @brief Puts all files into the index, if the priority is right
+		 * @return number of files actually added to the index
+		 */
+		size_t insertFilesIntoIndex(FileIndex& index) override;
+
+		/**
+		 * @brief Reads the file from disk in a single read. Safe to call from multiple threads at once.
+		 */
+		bool extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const override;
+
+		/**
+		 * @brief Reads only the given range of the file, from its mapping if it was viewed before. Safe to call from multiple threads at once.
+		 */
+		bool extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const override;
+
+		/**
+		 * @brief Hints the OS to read the file in the background
+		 */
+		void prefetch(const FileInfo& inf) const override;
+
+		/**
+		 * @brief Maps the file into memory and points the view there. The mapping is kept until the archive is destroyed.
+		 * @return False, if this archive was not loaded memory mapped or the file could not be mapped
+		 */
+		bool getFileView(const FileInfo& inf, FileView& view) const override;
+
+	private:
+		/**
+		 * @brief A single file found while scanning the directory
+		 */
+		struct PhysicalFile
+		{
+			std::string name;
+			std::string path;
+			std::string directory; // Relative to the scanned directory
+			uint32_t size;
+		};
+
+		/**
+		 * @brief Adds all files of the given directory, and recurses into its subdirectories
+		 * @param relative Path of the directory relative to the one passed to loadDirectory
+		 * @return False, if the directory could not be opened
+		 */
+		bool scanDirectory(const std::string& directory, const std::string& relative);
+
+		/**
+		 * @brief Files found while scanning. FileInfo::archiveOffset holds the index into this.
+		 */
+		std::vector<PhysicalFile> m_Files;
+
+		/**
+		 * @brief Files mapped through getFileView, same order as m_Files
+		 */
+		mutable std::vector<const uint8_t*> m_MappedFiles;
+		mutable std::vector<size_t> m_MappedSizes;
+		mutable std::mutex m_MappingMutex;
+
+		/**
+		 * @brief Whether getFileView may map files
+		 */
+		bool m_MemoryMapped;
 	};
-}
\ No newline at end of file
+}
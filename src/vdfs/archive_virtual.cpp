@@ -1,12 +1,15 @@
 #include "archive_virtual.h"
 #include "utils/logger.h"
 #include "fileIndex.h"
+#include "batchReader.h"
 #include <stack>
 #include <functional>
 #include <string.h>
 #include "utils/system.h"
 #include <locale>
 #include <algorithm>
+#include <thread>
+#include <atomic>
 
 /**
  * Quick format rundown:
@@ -21,49 +24,98 @@
 
 using namespace VDFS;
 
-const char* VDF_SIGNATURE_G1 = "PSVDSC_V2.00\r\n\r\n";
-const char* VDF_SIGNATURE_G2 = "PSVDSC_V2.00\n\r\n\r";
-
 ArchiveVirtual::ArchiveVirtual() : 
 	m_pStream(nullptr),
-	m_ArchivePriority(0)
+	m_pMappedData(nullptr),
+	m_MappedSize(0)
 {
 }
 
 ArchiveVirtual::~ArchiveVirtual()
+{
+	closeArchive();
+}
+
+/**
+ * @brief Closes the stream or unmaps the archive
+ */
+void ArchiveVirtual::closeArchive()
 {
 	if(m_pStream)
 		fclose(m_pStream);
+
+	Utils::System::unmapFile(m_pMappedData, m_MappedSize);
+
+	m_pStream = nullptr;
+	m_pMappedData = nullptr;
+	m_MappedSize = 0;
 }
 
 /**
 * @brief Loads the given VDFS-File and initializes the index
 */
-bool ArchiveVirtual::loadVDF(const std::string& file, uint32_t priority)
+bool ArchiveVirtual::loadVDF(const std::string& file, uint32_t priority, bool memoryMapped)
 {
-	if(m_pStream)
+	if(!openVDF(file, priority, memoryMapped))
+		return false;
+
+	// Create list of all files we have here
+	updateFileCatalog();
+
+	return true;
+}
+
+/**
+ * @brief Opens the given VDFS-File and verifies its header, without reading the file catalog
+ */
+bool ArchiveVirtual::openVDF(const std::string& file, uint32_t priority, bool memoryMapped)
+{
+	if(m_pStream || m_pMappedData)
 	{
 		LogWarn() << "Cannot re-use a virtual archive!";
 		return false;
 	}
 
-	// Open the archive
-	m_pStream = fopen(file.c_str(), "rb");
-
-	if(!m_pStream)
+	if(memoryMapped)
 	{
-		LogError() << "Failed to open file for reading: " << file;
-		return false;
+		// Map the whole archive, files are then served straight from memory
+		m_pMappedData = reinterpret_cast<const uint8_t*>(Utils::System::mapFile(file.c_str(), m_MappedSize));
+
+		if(!m_pMappedData)
+		{
+			LogError() << "Failed to map file into memory: " << file;
+			return false;
+		}
+
+		if(m_MappedSize < sizeof(m_VdfHeader))
+		{
+			LogError() << "VDFS-File '" << file << "' is too small to contain a header";
+			closeArchive();
+			return false;
+		}
+
+		memcpy(&m_VdfHeader, m_pMappedData, sizeof(m_VdfHeader));
 	}
+	else
+	{
+		// Open the archive
+		m_pStream = fopen(file.c_str(), "rb");
 
-	// Read and verify header
-	fread(&m_VdfHeader, sizeof(m_VdfHeader), 1, m_pStream);
+		if(!m_pStream)
+		{
+			LogError() << "Failed to open file for reading: " << file;
+			return false;
+		}
+
+		// Read header
+		fread(&m_VdfHeader, sizeof(m_VdfHeader), 1, m_pStream);
+	}
 
 	// Verify header version
 	if(m_VdfHeader.Version != 0x50)
 	{
 		LogError() << "VDFS-File '" << file << "' has an invalid header-version of: 0x" << std::hex << m_VdfHeader.Version;
-		fclose(m_pStream); m_pStream = nullptr;
+		closeArchive();
 		return false;
 	}
 
@@ -75,16 +127,14 @@ bool ArchiveVirtual::loadVDF(const std::string& file, uint32_t priority)
 	else
 	{
 		LogError() << "Unknown VDF-Archive signature on file '" << file << "'";
-		fclose(m_pStream); m_pStream = nullptr;
+		closeArchive();
 		return false;
 	}
 
 	// Assign priority
 	// TODO: Use file data as a base, if priority was set to 0!
 	m_ArchivePriority = priority;
-
-	// Create list of all files we have here
-	updateFileCatalog();
+	m_FilePath = file;
 
 	return true;
 }
@@ -94,20 +144,17 @@ bool ArchiveVirtual::loadVDF(const std::string& file, uint32_t priority)
 */
 bool ArchiveVirtual::updateFileCatalog()
 {
-	if(!m_pStream)
+	if(!m_pStream && !m_pMappedData)
 	{
 		LogError() << "VDF-File not initialized!";
 		return false;
 	}
 
-	// Skip to file catalog
-	fseek(m_pStream, sizeof(VdfHeader), SEEK_SET);
-
 	// Allocate memory for the catalog
 	m_EntryCatalog.resize(m_VdfHeader.NumEntries);
 
-	// Read catalog
-	if(m_VdfHeader.NumEntries != fread(m_EntryCatalog.data(), sizeof(VdfEntryInfo), m_VdfHeader.NumEntries, m_pStream))
+	// Read catalog, which is placed right after the header
+	if(!readData(sizeof(VdfHeader), sizeof(VdfEntryInfo) * m_VdfHeader.NumEntries, reinterpret_cast<uint8_t*>(m_EntryCatalog.data())))
 	{
 		LogError() << "Failed to read VDFS-Root catalog";
 		m_EntryCatalog.clear();
@@ -175,49 +222,30 @@ bool ArchiveVirtual::updateFileCatalog()
 /** 
  * @brief Extracts the vdfs to disc
  */
-bool ArchiveVirtual::extractArchiveToDisk(const std::string& baseDirectory)
+bool ArchiveVirtual::extractArchiveToDisk(const std::string& baseDirectory, unsigned numThreads)
 {
+	// Archives opened from an index-cache don't have their catalog yet
+	if(m_EntryCatalog.empty() && !updateFileCatalog())
+		return false;
+
 	Utils::System::mkdir(baseDirectory.c_str());
 
-	// List all folders and files to console
-	std::function<void(int, const std::string&)> f = [&](int idx, const std::string& path) {
-		auto& e = m_EntryCatalog[idx];
+	if(m_EntryCatalog.empty())
+		return true;
 
-		// List files in directory
+	// Build the directory skeleton up front, parents before children, so the workers only have to write files
+	std::vector<std::pair<uint32_t, std::string>> files;
+	std::function<void(int, const std::string&)> f = [&](int idx, const std::string& path) {
 		do
 		{
-			LogInfo() << "Entry: " << path << "/" << m_EntryCatalog[idx].Name;
-
 			std::string np = path + "/" + m_EntryCatalog[idx].Name;
-			std::string fullPath = baseDirectory + "/" + np;
 			if(m_EntryCatalog[idx].Type & VDF_ENTRY_DIR)
-			{			
-				Utils::System::mkdir(fullPath.c_str());
-
+			{
+				Utils::System::mkdir((baseDirectory + np).c_str());
 				f(m_EntryCatalog[idx].JumpTo, np);
-				LogInfo() << "Entry: " << fullPath;
 			}
 			else
-			{
-				// Get data into memory
-				std::vector<uint8_t> data;
-				extractFile(idx, data);
-
-				// Write back to disc
-				FILE* f = fopen(fullPath.c_str(), "wb");
-
-				if(f)
-				{
-					// Write data to disk
-					if(1 == fwrite(data.data(), sizeof(uint8_t) * data.size(), 1, f))
-					{
-						fclose(f);
-					}else
-						LogError() << "Failed to write file: " << fullPath;
-				}
-				else
-					LogError() << "Failed to open file for writing: " << fullPath;
-			}
+				files.emplace_back(idx, baseDirectory + np);
 
 			idx++;
 		}while(!(m_EntryCatalog[idx-1].Type & VDF_ENTRY_LAST));
@@ -225,24 +253,84 @@ bool ArchiveVirtual::extractArchiveToDisk(const std::string& baseDirectory)
 
 	f(0, "");
 
-	return true;
+	// Go through the archive front to back, so reads from the different workers stay close together
+	std::sort(files.begin(), files.end(), [&](const std::pair<uint32_t, std::string>& a, const std::pair<uint32_t, std::string>& b) {
+		return m_EntryCatalog[a.first].JumpTo < m_EntryCatalog[b.first].JumpTo;
+	});
+
+	if(numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	numThreads = static_cast<unsigned>(std::min<size_t>(numThreads, files.size()));
+
+	std::atomic<size_t> nextFile(0);
+	std::atomic<size_t> numFailed(0);
+
+	auto worker = [&]() {
+		std::vector<uint8_t> buffer(EXTRACT_BUFFER_SIZE);
+
+		for(size_t i = nextFile++; i < files.size(); i = nextFile++)
+		{
+			const VdfEntryInfo& e = m_EntryCatalog[files[i].first];
+			const std::string& fullPath = files[i].second;
+
+			FILE* out = fopen(fullPath.c_str(), "wb");
+			if(!out)
+			{
+				LogError() << "Failed to open file for writing: " << fullPath;
+				numFailed++;
+				continue;
+			}
+
+			// We only write whole chunks, no need for the stream to buffer them again
+			setvbuf(out, nullptr, _IONBF, 0);
+
+			bool ok = true;
+			for(uint32_t pos = 0; pos < e.Size && ok;)
+			{
+				uint32_t n = std::min(static_cast<uint32_t>(buffer.size()), e.Size - pos);
+
+				ok = readData(e.JumpTo + pos, n, buffer.data())
+					&& fwrite(buffer.data(), 1, n, out) == n;
+
+				pos += n;
+			}
+
+			ok = fclose(out) == 0 && ok;
+			if(!ok)
+			{
+				LogError() << "Failed to write file: " << fullPath;
+				numFailed++;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(unsigned i = 1; i < numThreads; i++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for(std::thread& t : threads)
+		t.join();
+
+	LogInfo() << "Extracted " << files.size() - numFailed << " of " << files.size() << " files from " << m_FilePath << " to " << baseDirectory;
+
+	return numFailed == 0;
 }
 
 /**
  * @brief Fills a vector with the data of a file
  */
-bool ArchiveVirtual::extractFile(size_t idx, std::vector<uint8_t>& fileData)
+bool ArchiveVirtual::extractFile(size_t idx, std::vector<uint8_t>& fileData) const
 { 
 	auto& e = m_EntryCatalog[idx];
 
 	// Allocate data for the file
 	fileData.resize(e.Size);
-	
-	// Jump to our file
-	fseek(m_pStream, e.JumpTo, SEEK_SET);
 
 	// Read from virtual archive
-	if(1 != fread(fileData.data(), e.Size, 1, m_pStream))
+	if(!readData(e.JumpTo, e.Size, fileData.data()))
 	{
 		LogError() << "Error while reading VDFS-file " << e.Name;
 		return false;
@@ -254,7 +342,7 @@ bool ArchiveVirtual::extractFile(size_t idx, std::vector<uint8_t>& fileData)
 /**
  * @brief Fills a vector with the data of a file
  */
-bool ArchiveVirtual::extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData)
+bool ArchiveVirtual::extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const
 {
 	if(inf.targetArchive != this)
 	{
@@ -265,11 +353,8 @@ bool ArchiveVirtual::extractFile(const FileInfo& inf, std::vector<uint8_t>& file
 	// Allocate data for the file
 	fileData.resize(inf.fileSize);
 
-	// Jump to our file
-	fseek(m_pStream, inf.archiveOffset, SEEK_SET);
-
 	// Read from virtual archive
-	if(1 != fread(fileData.data(), inf.fileSize, 1, m_pStream))
+	if(!readData(inf.archiveOffset, inf.fileSize, fileData.data()))
 	{
 		LogError() << "Error while reading VDFS-file " << inf.fileName;
 		return false;
@@ -278,6 +363,131 @@ bool ArchiveVirtual::extractFile(const FileInfo& inf, std::vector<uint8_t>& file
 	return true;
 }
 
+/**
+ * @brief Extracts multiple files at once, as one batch of reads
+ */
+bool ArchiveVirtual::extractFiles(const std::vector<const FileInfo*>& files, const std::vector<uint8_t*>& targets, BatchReader& reader) const
+{
+	if(m_pMappedData)
+		return Archive::extractFiles(files, targets, reader);
+
+	std::vector<BatchRead> reads(files.size());
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		if(files[i]->targetArchive != this)
+		{
+			LogWarn() << "Trying to extract file from archive other than the files target archive! Aborting extraction";
+			return false;
+		}
+
+		reads[i].offset = files[i]->archiveOffset;
+		reads[i].size = files[i]->fileSize;
+		reads[i].target = targets[i];
+	}
+
+	uint64_t start = getTimestamp();
+	bool ok = reader.read(m_pStream, reads);
+
+	for(const BatchRead& r : reads)
+		recordRead(r.offset, r.size);
+
+	recordReadTime(getTimestamp() - start);
+
+	if(ok)
+		return true;
+
+	for(size_t i = 0; i < reads.size(); i++)
+	{
+		if(!reads[i].success)
+			LogError() << "Error while reading VDFS-file " << files[i]->fileName;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Hints the OS to read the file in the background
+ */
+void ArchiveVirtual::prefetch(const FileInfo& inf) const
+{
+	if(inf.targetArchive != this || inf.fileSize == 0)
+		return;
+
+	if(m_pMappedData)
+	{
+		if(static_cast<size_t>(inf.archiveOffset) + inf.fileSize <= m_MappedSize)
+			Utils::System::prefetchMemory(m_pMappedData + inf.archiveOffset, inf.fileSize);
+	}
+	else if(m_pStream)
+		Utils::System::prefetchFileRange(m_pStream, inf.archiveOffset, inf.fileSize);
+}
+
+/**
+ * @brief Reads only the given range of the file
+ */
+bool ArchiveVirtual::extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const
+{
+	if(inf.targetArchive != this)
+	{
+		LogWarn() << "Trying to extract file from archive other than the files target archive! Aborting extraction";
+		return false;
+	}
+
+	if(offset > inf.fileSize || size > inf.fileSize - offset)
+		return false;
+
+	return size == 0 || readData(inf.archiveOffset + offset, size, target);
+}
+
+/**
+ * @brief Points the given view directly to the data of the file inside the mapped archive
+ */
+bool ArchiveVirtual::getFileView(const FileInfo& inf, FileView& view) const
+{
+	if(!m_pMappedData || inf.targetArchive != this)
+		return false;
+
+	if(static_cast<size_t>(inf.archiveOffset) + inf.fileSize > m_MappedSize)
+	{
+		LogError() << "VDFS-file " << inf.fileName << " is out of the archives bounds";
+		return false;
+	}
+
+	view.data = m_pMappedData + inf.archiveOffset;
+	view.size = inf.fileSize;
+	recordView(view.size);
+
+	return true;
+}
+
+/**
+ * @brief Reads size bytes starting at the given archive offset into target
+ */
+bool ArchiveVirtual::readData(uint32_t offset, uint32_t size, uint8_t* target) const
+{
+	if(m_pMappedData)
+	{
+		if(static_cast<size_t>(offset) + size > m_MappedSize)
+			return false;
+
+		// Page faults make up the time here
+		uint64_t start = getTimestamp();
+		memcpy(target, m_pMappedData + offset, size);
+
+		recordRead(offset, size);
+		recordReadTime(getTimestamp() - start);
+		return true;
+	}
+
+	// Positional read, so multiple threads can extract from this archive at the same time
+	uint64_t start = getTimestamp();
+	bool ok = Utils::System::readAt(m_pStream, offset, target, size);
+
+	recordRead(offset, size);
+	recordReadTime(getTimestamp() - start);
+	return ok;
+}
+
 /**
 * @brief Puts all files into the index, if the priority is right
 */
@@ -286,8 +496,22 @@ size_t ArchiveVirtual::insertFilesIntoIndex(FileIndex& index)
 	size_t r = 0;
 
 	// Put all files of this into the index
-	iterateFiles([&](int idx, const std::string& path){
-		auto e = m_EntryCatalog[idx];
+	listFiles([&](const FileInfo& f, const std::string& path){
+		// Directory is everything up to the name
+		if(index.addFile(f, std::string_view(path).substr(0, path.size() - f.fileName.size())))
+			r++;
+	});
+
+	return r;
+}
+
+/**
+* @brief Calls the callback for every file in the archive, with the path of the file inside the archive
+*/
+bool ArchiveVirtual::listFiles(std::function<void(const FileInfo&, const std::string&)> callback)
+{
+	return iterateFiles([&](int idx, const std::string& path){
+		auto& e = m_EntryCatalog[idx];
 		FileInfo f;
 
 		// Enter file properties
@@ -297,18 +521,22 @@ size_t ArchiveVirtual::insertFilesIntoIndex(FileIndex& index)
 		f.targetArchive = this;
 		f.priority = m_ArchivePriority;
 
-		// Add to index
-		if(index.addFile(f))
-			r++;
+		callback(f, path);
 	});
-
-	return r;
 }
 /**
 * @brief Lists every file with its path and calls a callback containing the file information
 */
 bool ArchiveVirtual::iterateFiles(std::function<void(int, const std::string&)> callback)
 {
+	// Archives opened from an index-cache don't have their catalog yet
+	if(m_EntryCatalog.empty() && !updateFileCatalog())
+		return false;
+
+	// Nothing to iterate
+	if(m_EntryCatalog.empty())
+		return true;
+
 	// Iterate over all files and build their paths during iteration
 	std::function<void(int, const std::string&)> f = [&](int idx, const std::string& path) {
 		auto& e = m_EntryCatalog[idx];
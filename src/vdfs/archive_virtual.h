@@ -2,10 +2,10 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include "archive.h"
 
 namespace VDFS
 {
-	struct FileInfo;
 
 	// These files are written on 32-bit, no packing
 #pragma pack(push, 1)
@@ -16,6 +16,13 @@ namespace VDFS
 	const uint32_t VDF_ENTRY_DIR = 0x80000000; // Directory
 	const uint32_t VDF_ENTRY_LAST = 0x40000000; // Last file in the archive seems to have this set
 
+	// Header signatures, depending on the game-version the archive was built with
+	const char* const VDF_SIGNATURE_G1 = "PSVDSC_V2.00\r\n\r\n";
+	const char* const VDF_SIGNATURE_G2 = "PSVDSC_V2.00\n\r\n\r";
+
+	// Size of the buffer each worker of extractArchiveToDisk streams files through
+	const uint32_t EXTRACT_BUFFER_SIZE = 4 * 1024 * 1024;
+
 	/**
 	* @brief Timestamp-bitfield for vdfs-files
 	*/
@@ -57,8 +64,7 @@ namespace VDFS
 	};
 #pragma pack(pop)
 
-	class FileIndex;
-	class ArchiveVirtual
+	class ArchiveVirtual : public Archive
 	{
 	public:
 		ArchiveVirtual();
@@ -66,8 +72,16 @@ namespace VDFS
 
 		/**
 		 * @brief Loads the given VDFS-File and initializes the index
+		 * @param memoryMapped Whether to map the whole archive into memory instead of reading files through a stream
+		 */
+		bool loadVDF(const std::string& file, uint32_t priority = 0, bool memoryMapped = false);
+
+		/**
+		 * @brief Opens the given VDFS-File and verifies its header, without reading the file catalog.
+		 *		  Files can be extracted using FileInfos from an other source, like an index-cache.
+		 *		  The catalog will be read on demand.
 		 */
-		bool loadVDF(const std::string& file, uint32_t priority = 0);
+		bool openVDF(const std::string& file, uint32_t priority = 0, bool memoryMapped = false);
 
 		/**
 		 * @brief Updates the file catalog of this archive.
@@ -79,21 +93,72 @@ namespace VDFS
 		 * @brief Puts all files into the index, if the priority is right
 		 * @return number of files actually added to the index
 		 */
-		size_t insertFilesIntoIndex(FileIndex& index);
+		size_t insertFilesIntoIndex(FileIndex& index) override;
+
+		/**
+		 * @brief Calls the callback for every file in the archive, with the path of the file inside the archive.
+		 *		  The FileInfo is the same that insertFilesIntoIndex would put into an index.
+		 */
+		bool listFiles(std::function<void(const FileInfo&, const std::string&)> callback);
+
+		/**
+		 * @brief Returns whether this archive was built for Gothic 1
+		 */
+		bool isGothic1() const { return m_ArchiveVersion == AV_Gothic1; }
 
 		/** 
-		 * @brief Extracts the vdfs to disc
+		 * @brief Extracts the vdfs to disc. All directories are created first, then the files are streamed out
+		 *		  by a pool of workers, each reading through one reusable buffer.
+		 * @param numThreads Number of workers, 0 to use one per hardware-thread
+		 * @return False, if any of the files could not be written
+		 */
+		bool extractArchiveToDisk(const std::string& baseDirectory, unsigned numThreads = 0);
+
+		/**
+		 * @brief Fills a vector with the data of a file. Safe to call from multiple threads at once.
+		 */
+		bool extractFile(size_t idx, std::vector<uint8_t>& fileData) const;
+		bool extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData) const override;
+
+		/**
+		 * @brief Reads only the given range of the file. Safe to call from multiple threads at once.
+		 */
+		bool extractRange(const FileInfo& inf, uint32_t offset, uint32_t size, uint8_t* target) const override;
+
+		/**
+		 * @brief Extracts multiple files at once. Unless the archive is mapped, all reads are submitted as one batch
+		 *		  through the reader, which uses io_uring where available.
 		 */
-		bool extractArchiveToDisk(const std::string& baseDirectory);
+		bool extractFiles(const std::vector<const FileInfo*>& files, const std::vector<uint8_t*>& targets, BatchReader& reader) const override;
 
 		/**
-		 * @brief Fills a vector with the data of a file
+		 * @brief Hints the OS to read the file in the background, either into the page cache or the mapping
 		 */
-		bool extractFile(size_t idx, std::vector<uint8_t>& fileData);
-		bool extractFile(const FileInfo& inf, std::vector<uint8_t>& fileData);
+		void prefetch(const FileInfo& inf) const override;
+
+		/**
+		 * @brief Points the given view directly to the data of the file inside the mapped archive. 
+		 * @return False, if this archive is not memory mapped or the file is out of bounds
+		 */
+		bool getFileView(const FileInfo& inf, FileView& view) const override;
+
+		/**
+		 * @brief Returns whether this archive was loaded as memory mapped file
+		 */
+		bool isMemoryMapped() const { return m_pMappedData != nullptr; }
 
 	protected:
 
+		/**
+		 * @brief Reads size bytes starting at the given archive offset into target
+		 */
+		bool readData(uint32_t offset, uint32_t size, uint8_t* target) const;
+
+		/**
+		 * @brief Closes the stream or unmaps the archive
+		 */
+		void closeArchive();
+
 		/**
 		 * @brief Lists every file with its path and calls a callback containing the file information
 		 */
@@ -104,6 +169,12 @@ namespace VDFS
 		 */
 		FILE* m_pStream;
 
+		/**
+		 * @brief Mapped archive-data, if loaded as memory mapped file
+		 */
+		const uint8_t* m_pMappedData;
+		size_t m_MappedSize;
+
 		/**
 		 * @brief Game-Version this is from
 		 */
@@ -122,13 +193,5 @@ namespace VDFS
 		 * @brief File catalog of files of this archive
 		 */
 		std::vector<VdfEntryInfo> m_EntryCatalog;
-
-		/**
-		 * @brief Priority for files of this archive
-		 */
-		uint32_t m_ArchivePriority;
 	};
-
-	// TODO: Make an archive-type for physical as well. Then use virtual functions to simplyfy access
-	typedef ArchiveVirtual Archive;
 }
\ No newline at end of file
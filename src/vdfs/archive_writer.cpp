@@ -0,0 +1,370 @@
+#include "archive_writer.h"
+#include "archive_virtual.h"
+#include "archive_compressed.h"
+#include "lz4block.h"
+#include "utils/logger.h"
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <map>
+#include <deque>
+#include <set>
+#include <algorithm>
+
+using namespace VDFS;
+
+namespace
+{
+	/**
+	 * @brief Directory inside the catalog that is being built
+	 */
+	struct CatalogDir
+	{
+		std::map<std::string, size_t> dirs; // Name -> index into the list of all directories
+		std::map<std::string, size_t> files; // Name -> index into the list of pending files
+	};
+
+	/**
+	 * @brief Fills the fixed size name-field of a catalog-entry, padded with spaces like the original tools do
+	 */
+	void setEntryName(VdfEntryInfo& e, const std::string& name)
+	{
+		memset(e.Name, ' ', sizeof(e.Name));
+		memcpy(e.Name, name.data(), std::min(name.size(), sizeof(e.Name)));
+	}
+
+	/**
+	 * @brief Current time in the format used by the header
+	 */
+	VdfTime currentVdfTime()
+	{
+		time_t now = time(nullptr);
+		tm* t = localtime(&now);
+
+		// Same layout as a DOS-timestamp
+		VdfTime v = {};
+		if(t)
+		{
+			v.Seconds = t->tm_sec / 2;
+			v.Minutes = t->tm_min;
+			v.Hour = t->tm_hour;
+			v.Day = t->tm_mday;
+			v.Month = t->tm_mon + 1;
+			v.Year = t->tm_year - 80;
+		}
+
+		return v;
+	}
+}
+
+/**
+ * @brief Adds a file to the archive
+ */
+void ArchiveWriter::addFile(const std::string& path, uint32_t size, DataSource source)
+{
+	PendingFile f;
+	f.size = size;
+	f.source = source;
+
+	// Split into directories and the actual file name
+	std::string part;
+	for(char c : path)
+	{
+		if(c == '/' || c == '\\')
+		{
+			if(!part.empty())
+				f.path.push_back(part);
+
+			part.clear();
+		}
+		else
+			part += c;
+	}
+
+	if(!part.empty())
+		f.path.push_back(part);
+
+	m_Files.push_back(f);
+}
+
+/**
+ * @brief Writes the archive, pulling the data of each file from its source in order
+ */
+bool ArchiveWriter::writeVDF(const std::string& file, const std::string& comment, bool gothic1)
+{
+	// Build the directory tree
+	std::vector<CatalogDir> dirs(1);
+	for(size_t i = 0; i < m_Files.size(); i++)
+	{
+		const PendingFile& f = m_Files[i];
+		if(f.path.empty())
+		{
+			LogError() << "File without a name can't be written to a VDF";
+			return false;
+		}
+
+		// The reader needs at least one trailing space or 0 after each name
+		for(const std::string& part : f.path)
+		{
+			if(part.size() >= sizeof(VdfEntryInfo::Name))
+			{
+				LogError() << "Name too long for a VDF: " << part;
+				return false;
+			}
+		}
+
+		size_t dir = 0;
+		for(size_t p = 0; p + 1 < f.path.size(); p++)
+		{
+			auto it = dirs[dir].dirs.find(f.path[p]);
+			if(it == dirs[dir].dirs.end())
+			{
+				it = dirs[dir].dirs.emplace(f.path[p], dirs.size()).first;
+				dirs.emplace_back();
+			}
+
+			dir = it->second;
+		}
+
+		// Only the first file of a name makes it into the archive
+		dirs[dir].files.emplace(f.path.back(), i);
+	}
+
+	// Each directory lists its entries in one contiguous block of the catalog. Assign blocks breadth first.
+	std::vector<uint32_t> blockStart(dirs.size(), 0);
+	uint32_t numEntries = 0;
+	std::deque<size_t> queue(1, 0);
+	while(!queue.empty())
+	{
+		size_t d = queue.front();
+		queue.pop_front();
+
+		blockStart[d] = numEntries;
+		numEntries += static_cast<uint32_t>(dirs[d].dirs.size() + dirs[d].files.size());
+
+		for(auto& sub : dirs[d].dirs)
+			queue.push_back(sub.second);
+	}
+
+	// File data starts right after the catalog, in the order the files were added
+	uint64_t dataStart = sizeof(VdfHeader) + static_cast<uint64_t>(numEntries) * sizeof(VdfEntryInfo);
+	std::vector<uint32_t> dataOffset(m_Files.size(), 0);
+	std::vector<bool> inCatalog(m_Files.size(), false);
+	for(const CatalogDir& d : dirs)
+		for(auto& f : d.files)
+			inCatalog[f.second] = true;
+
+	uint64_t pos = dataStart;
+	for(size_t i = 0; i < m_Files.size(); i++)
+	{
+		if(!inCatalog[i])
+			continue;
+
+		dataOffset[i] = static_cast<uint32_t>(pos);
+		pos += m_Files[i].size;
+	}
+
+	if(pos > 0xFFFFFFFF)
+	{
+		LogError() << "Archive too large for the VDF-format: " << file;
+		return false;
+	}
+
+	// Fill the catalog
+	std::vector<VdfEntryInfo> catalog(numEntries);
+	uint32_t numFiles = 0;
+	for(size_t d = 0; d < dirs.size(); d++)
+	{
+		uint32_t idx = blockStart[d];
+
+		for(auto& sub : dirs[d].dirs)
+		{
+			VdfEntryInfo& e = catalog[idx++];
+			setEntryName(e, sub.first);
+			e.JumpTo = blockStart[sub.second];
+			e.Size = 0;
+			e.Type = VDF_ENTRY_DIR;
+			e.Attributes = 0x20;
+		}
+
+		for(auto& f : dirs[d].files)
+		{
+			VdfEntryInfo& e = catalog[idx++];
+			setEntryName(e, f.first);
+			e.JumpTo = dataOffset[f.second];
+			e.Size = m_Files[f.second].size;
+			e.Type = 0;
+			e.Attributes = 0x20;
+			numFiles++;
+		}
+
+		// Mark the end of the block
+		if(idx != blockStart[d])
+			catalog[idx - 1].Type |= VDF_ENTRY_LAST;
+	}
+
+	VdfHeader header;
+	memset(header.Comment, 0x1A, sizeof(header.Comment));
+	memcpy(header.Comment, comment.data(), std::min(comment.size(), sizeof(header.Comment)));
+	memcpy(header.Signature, gothic1 ? VDF_SIGNATURE_G1 : VDF_SIGNATURE_G2, sizeof(header.Signature));
+	header.NumEntries = numEntries;
+	header.NumFiles = numFiles;
+	header.Timestamp = currentVdfTime();
+	header.DataSize = static_cast<uint32_t>(pos - dataStart);
+	header.RootCatOffset = sizeof(VdfHeader);
+	header.Version = 0x50;
+
+	FILE* f = fopen(file.c_str(), "wb");
+	if(!f)
+	{
+		LogError() << "Failed to open file for writing: " << file;
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& (catalog.empty() || fwrite(catalog.data(), sizeof(VdfEntryInfo), catalog.size(), f) == catalog.size());
+
+	// Stream the data
+	std::vector<uint8_t> data;
+	for(size_t i = 0; i < m_Files.size() && ok; i++)
+	{
+		if(!inCatalog[i])
+			continue;
+
+		data.clear();
+		if(!m_Files[i].source(data) || data.size() != m_Files[i].size)
+		{
+			LogError() << "Failed to get data for file: " << m_Files[i].path.back();
+			ok = false;
+			break;
+		}
+
+		ok = data.empty() || fwrite(data.data(), 1, data.size(), f) == data.size();
+	}
+
+	ok = fclose(f) == 0 && ok;
+
+	if(!ok)
+		LogError() << "Failed to write VDF-Archive: " << file;
+
+	return ok;
+}
+
+/**
+ * @brief Writes a compressed archive, readable through ArchiveCompressed
+ */
+bool ArchiveWriter::writeCompressedVDF(const std::string& file, bool gothic1, uint32_t blockSize)
+{
+	if(blockSize == 0 || blockSize >= CVDF_BLOCK_STORED)
+	{
+		LogError() << "Invalid block size: " << blockSize;
+		return false;
+	}
+
+	FILE* f = fopen(file.c_str(), "wb");
+	if(!f)
+	{
+		LogError() << "Failed to open file for writing: " << file;
+		return false;
+	}
+
+	// Header is written again once the catalog-position is known
+	CompressedVdfHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.Signature, CVDF_SIGNATURE, strlen(CVDF_SIGNATURE));
+	header.Version = CVDF_VERSION;
+	header.Flags = gothic1 ? CVDF_FLAG_GOTHIC1 : 0;
+	header.BlockSize = blockSize;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	uint64_t pos = sizeof(header);
+
+	std::vector<CompressedVdfFile> files;
+	std::vector<CompressedVdfBlock> blocks;
+	std::string paths;
+	std::set<std::string> written;
+
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> compressed(LZ4::compressBound(blockSize));
+	for(size_t i = 0; i < m_Files.size() && ok; i++)
+	{
+		const PendingFile& pf = m_Files[i];
+
+		std::string path;
+		for(const std::string& part : pf.path)
+			path += (path.empty() ? "" : "/") + part;
+
+		// Only the first file of a path makes it into the archive, same as with writeVDF
+		if(path.empty() || !written.insert(path).second)
+			continue;
+
+		if(path.size() > 0xFFFF)
+		{
+			LogError() << "Path too long: " << path;
+			ok = false;
+			break;
+		}
+
+		data.clear();
+		if(!pf.source(data) || data.size() != pf.size)
+		{
+			LogError() << "Failed to get data for file: " << path;
+			ok = false;
+			break;
+		}
+
+		CompressedVdfFile e;
+		e.Size = pf.size;
+		e.FirstBlock = static_cast<uint32_t>(blocks.size());
+		e.PathOffset = static_cast<uint32_t>(paths.size());
+		e.PathLength = static_cast<uint16_t>(path.size());
+		e.NameLength = static_cast<uint16_t>(pf.path.back().size());
+		files.push_back(e);
+		paths += path;
+
+		for(size_t offset = 0; offset < data.size() && ok; offset += blockSize)
+		{
+			size_t length = std::min<size_t>(blockSize, data.size() - offset);
+			size_t size = LZ4::compress(data.data() + offset, length, compressed.data(), compressed.size());
+
+			CompressedVdfBlock b;
+			b.Offset = pos;
+
+			// Keep the block as it is, if compressing didn't help
+			if(size == 0 || size >= length)
+			{
+				b.Size = static_cast<uint32_t>(length) | CVDF_BLOCK_STORED;
+				ok = fwrite(data.data() + offset, 1, length, f) == length;
+				pos += length;
+			}
+			else
+			{
+				b.Size = static_cast<uint32_t>(size);
+				ok = fwrite(compressed.data(), 1, size, f) == size;
+				pos += size;
+			}
+
+			blocks.push_back(b);
+		}
+	}
+
+	// Catalog goes to the end
+	header.NumFiles = static_cast<uint32_t>(files.size());
+	header.NumBlocks = static_cast<uint32_t>(blocks.size());
+	header.PathBlobSize = static_cast<uint32_t>(paths.size());
+	header.CatalogOffset = pos;
+
+	ok = ok
+		&& (files.empty() || fwrite(files.data(), sizeof(CompressedVdfFile), files.size(), f) == files.size())
+		&& (blocks.empty() || fwrite(blocks.data(), sizeof(CompressedVdfBlock), blocks.size(), f) == blocks.size())
+		&& fwrite(paths.data(), 1, paths.size(), f) == paths.size()
+		&& fseek(f, 0, SEEK_SET) == 0
+		&& fwrite(&header, sizeof(header), 1, f) == 1;
+
+	ok = fclose(f) == 0 && ok;
+
+	if(!ok)
+		LogError() << "Failed to write compressed VDF-Archive: " << file;
+
+	return ok;
+}
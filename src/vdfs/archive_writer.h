@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+#include "archive_compressed.h"
+
+namespace VDFS
+{
+	/**
+	 * @brief Builds a new VDF-Archive. File data is laid out in the order the files were added,
+	 *		  independent of the directory structure in the catalog.
+	 */
+	class ArchiveWriter
+	{
+	public:
+		/**
+		 * @brief Fills the given vector with the data of a file, when it is about to be written
+		 */
+		typedef std::function<bool(std::vector<uint8_t>&)> DataSource;
+
+		/**
+		 * @brief Adds a file to the archive
+		 * @param path Path inside the archive, using '/' or '\' as separator. Only the name is used for lookups later.
+		 * @param size Size of the data the source will deliver
+		 */
+		void addFile(const std::string& path, uint32_t size, DataSource source);
+
+		/**
+		 * @brief Writes the archive, pulling the data of each file from its source in order.
+		 *		  The file is written front to back in one go.
+		 * @param gothic1 Whether to use the signature of Gothic 1 instead of Gothic 2
+		 */
+		bool writeVDF(const std::string& file, const std::string& comment, bool gothic1 = false);
+
+		/**
+		 * @brief Writes a compressed archive, readable through ArchiveCompressed. Each file gets split into
+		 *		  blocks of blockSize bytes, which are compressed on their own.
+		 * @param gothic1 Whether the files are meant for Gothic 1
+		 */
+		bool writeCompressedVDF(const std::string& file, bool gothic1 = false, uint32_t blockSize = CVDF_DEFAULT_BLOCK_SIZE);
+
+	private:
+		/**
+		 * @brief File waiting to be written
+		 */
+		struct PendingFile
+		{
+			std::vector<std::string> path;
+			uint32_t size;
+			DataSource source;
+		};
+
+		/**
+		 * @brief Files in the order their data gets written
+		 */
+		std::vector<PendingFile> m_Files;
+	};
+}
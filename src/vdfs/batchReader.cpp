@@ -0,0 +1,363 @@
+#include "batchReader.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define VDFS_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef VDFS_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+/**
+ * Quick rundown of how the io_uring path works:
+ *
+ * There is no dependency on liburing, the rings are set up using the raw syscalls. The kernel shares two rings with us:
+ * We put read-requests (SQEs) into the submission ring and tell the kernel about them using io_uring_enter, which
+ * also waits for at least one of them to complete. Completions (CQEs) come back in the completion ring, carrying the
+ * slot of the request they belong to. Reads which came back short get submitted again for the remaining bytes.
+ *
+ * Only queueDepth requests are in flight at any time, so both rings can never overflow.
+ */
+
+using namespace VDFS;
+
+#ifdef VDFS_HAVE_IO_URING
+struct BatchReader::Ring
+{
+	int fd;
+	unsigned entries;
+
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	io_uring_sqe* sqes;
+	size_t sqesSize;
+
+	unsigned* sqTail;
+	unsigned* sqMask;
+	unsigned* sqArray;
+	unsigned* cqHead;
+	unsigned* cqTail;
+	unsigned* cqMask;
+	io_uring_cqe* cqes;
+};
+#else
+struct BatchReader::Ring
+{
+};
+#endif
+
+BatchReader::BatchReader(unsigned queueDepth, bool allowIoUring) :
+	m_Ring(nullptr),
+	m_RingSetupDone(false),
+	m_AllowIoUring(allowIoUring),
+	m_QueueDepth(std::max(queueDepth, 1u))
+{
+}
+
+BatchReader::~BatchReader()
+{
+	destroyRing();
+}
+
+/**
+ * @brief Returns whether the reads go through io_uring
+ */
+bool BatchReader::isUsingIoUring()
+{
+	setupRing();
+	return m_Ring != nullptr;
+}
+
+/**
+ * @brief Performs all reads of the batch on the given stream, in any order
+ */
+bool BatchReader::read(FILE* stream, std::vector<BatchRead>& reads)
+{
+	for(BatchRead& r : reads)
+		r.success = false;
+
+	setupRing();
+
+	if(m_Ring && !readRing(stream, reads))
+	{
+		// Kernel stopped taking requests, do the rest without it
+		LogWarn() << "io_uring failed, falling back to positional reads";
+		destroyRing();
+	}
+
+	if(!m_Ring)
+		return readSequential(stream, reads);
+
+	bool allRead = true;
+	for(const BatchRead& r : reads)
+		allRead = allRead && r.success;
+
+	return allRead;
+}
+
+/**
+ * @brief Reads one after another, using positional reads
+ */
+bool BatchReader::readSequential(FILE* stream, std::vector<BatchRead>& reads)
+{
+	bool allRead = true;
+	for(BatchRead& r : reads)
+	{
+		if(!r.success)
+			r.success = r.size == 0 || Utils::System::readAt(stream, r.offset, r.target, r.size);
+
+		allRead = allRead && r.success;
+	}
+
+	return allRead;
+}
+
+#ifdef VDFS_HAVE_IO_URING
+/**
+ * @brief Sets up the ring, if allowed and not done yet
+ */
+void BatchReader::setupRing()
+{
+	if(m_RingSetupDone || !m_AllowIoUring)
+		return;
+
+	m_RingSetupDone = true;
+
+	io_uring_params p;
+	memset(&p, 0, sizeof(p));
+
+	int fd = static_cast<int>(syscall(__NR_io_uring_setup, m_QueueDepth, &p));
+	if(fd < 0)
+	{
+		// Old kernel, or blocked inside of a container. Nothing to worry about, and the same for every reader.
+		static std::atomic<bool> s_Logged(false);
+		if(!s_Logged.exchange(true))
+			LogInfo() << "io_uring not available, using positional reads";
+
+		return;
+	}
+
+	Ring* r = new Ring;
+	memset(r, 0, sizeof(Ring));
+	r->fd = fd;
+	r->entries = p.sq_entries;
+
+	r->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+	// Newer kernels put both rings into the same mapping
+	const bool singleMapping = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if(singleMapping)
+		r->sqRingSize = r->cqRingSize = std::max(r->sqRingSize, r->cqRingSize);
+
+	r->sqRing = mmap(nullptr, r->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	r->cqRing = singleMapping ? r->sqRing : mmap(nullptr, r->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+	r->sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, r->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if(r->sqRing == MAP_FAILED || r->cqRing == MAP_FAILED || sqes == MAP_FAILED)
+	{
+		LogWarn() << "Failed to map io_uring, using positional reads";
+
+		if(sqes != MAP_FAILED)
+			munmap(sqes, r->sqesSize);
+
+		if(!singleMapping && r->cqRing != MAP_FAILED)
+			munmap(r->cqRing, r->cqRingSize);
+
+		if(r->sqRing != MAP_FAILED)
+			munmap(r->sqRing, r->sqRingSize);
+
+		close(fd);
+		delete r;
+		return;
+	}
+
+	uint8_t* sq = reinterpret_cast<uint8_t*>(r->sqRing);
+	uint8_t* cq = reinterpret_cast<uint8_t*>(r->cqRing);
+
+	r->sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+	r->sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+	r->sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+	r->sqes = reinterpret_cast<io_uring_sqe*>(sqes);
+
+	r->cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+	r->cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+	r->cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+	r->cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+	// The kernel may round the number of entries up, but never down
+	m_QueueDepth = std::min(m_QueueDepth, r->entries);
+	m_Ring = r;
+}
+
+/**
+ * @brief Tears the ring down again
+ */
+void BatchReader::destroyRing()
+{
+	if(!m_Ring)
+		return;
+
+	munmap(m_Ring->sqes, m_Ring->sqesSize);
+
+	if(m_Ring->cqRing != m_Ring->sqRing)
+		munmap(m_Ring->cqRing, m_Ring->cqRingSize);
+
+	munmap(m_Ring->sqRing, m_Ring->sqRingSize);
+	close(m_Ring->fd);
+
+	delete m_Ring;
+	m_Ring = nullptr;
+}
+
+/**
+ * @brief Reads through io_uring
+ */
+bool BatchReader::readRing(FILE* stream, std::vector<BatchRead>& reads)
+{
+	const int fd = fileno(stream);
+
+	// A slot per request in flight. The iovec has to stay where it is until the read completes.
+	struct Slot
+	{
+		size_t read;
+		uint32_t done;
+		iovec iov;
+	};
+
+	std::vector<Slot> slots(m_QueueDepth);
+	std::vector<unsigned> freeSlots;
+	for(unsigned i = 0; i < m_QueueDepth; i++)
+		freeSlots.push_back(m_QueueDepth - 1 - i);
+
+	// Puts the remaining part of the read of the given slot into the submission ring
+	auto queue = [&](unsigned slot) {
+		Slot& s = slots[slot];
+		BatchRead& br = reads[s.read];
+
+		unsigned tail = *m_Ring->sqTail;
+		unsigned idx = tail & *m_Ring->sqMask;
+
+		s.iov.iov_base = br.target + s.done;
+		s.iov.iov_len = br.size - s.done;
+
+		io_uring_sqe* sqe = &m_Ring->sqes[idx];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = fd;
+		sqe->off = br.offset + s.done;
+		sqe->addr = reinterpret_cast<uint64_t>(&s.iov);
+		sqe->len = 1;
+		sqe->user_data = slot;
+
+		m_Ring->sqArray[idx] = idx;
+
+		// Make the entry visible to the kernel before moving the tail
+		__atomic_store_n(m_Ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+	};
+
+	size_t next = 0;
+	unsigned toSubmit = 0;
+	unsigned inFlight = 0;
+
+	while(next < reads.size() || inFlight > 0)
+	{
+		// Fill up the queue
+		while(!freeSlots.empty() && next < reads.size())
+		{
+			if(reads[next].size == 0)
+			{
+				reads[next++].success = true;
+				continue;
+			}
+
+			unsigned slot = freeSlots.back();
+			freeSlots.pop_back();
+
+			slots[slot].read = next++;
+			slots[slot].done = 0;
+
+			queue(slot);
+			toSubmit++;
+			inFlight++;
+		}
+
+		if(inFlight == 0)
+			break;
+
+		// Submit and wait for at least one of them
+		int r = static_cast<int>(syscall(__NR_io_uring_enter, m_Ring->fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+		if(r < 0)
+		{
+			if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+				continue;
+
+			return false;
+		}
+
+		toSubmit -= std::min(toSubmit, static_cast<unsigned>(r));
+
+		// Collect what's done
+		unsigned head = *m_Ring->cqHead;
+		while(head != __atomic_load_n(m_Ring->cqTail, __ATOMIC_ACQUIRE))
+		{
+			const io_uring_cqe& cqe = m_Ring->cqes[head & *m_Ring->cqMask];
+			unsigned slot = static_cast<unsigned>(cqe.user_data);
+			int res = cqe.res;
+			head++;
+
+			Slot& s = slots[slot];
+			BatchRead& br = reads[s.read];
+
+			if(res > 0)
+				s.done += static_cast<uint32_t>(res);
+
+			// Short read or interrupted, go again for the rest
+			if((res > 0 && s.done < br.size) || res == -EAGAIN || res == -EINTR)
+			{
+				queue(slot);
+				toSubmit++;
+				continue;
+			}
+
+			br.success = res > 0;
+			inFlight--;
+			freeSlots.push_back(slot);
+		}
+
+		__atomic_store_n(m_Ring->cqHead, head, __ATOMIC_RELEASE);
+	}
+
+	return true;
+}
+#else
+void BatchReader::setupRing()
+{
+	m_RingSetupDone = true;
+}
+
+void BatchReader::destroyRing()
+{
+}
+
+bool BatchReader::readRing(FILE*, std::vector<BatchRead>&)
+{
+	return false;
+}
+#endif
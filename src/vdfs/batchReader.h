@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace VDFS
+{
+	const unsigned BATCH_READER_DEFAULT_QUEUE_DEPTH = 32;
+
+	/**
+	 * @brief Single read of a batch
+	 */
+	struct BatchRead
+	{
+		uint64_t offset;
+		uint32_t size;
+		uint8_t* target;
+		bool success; // Set once the batch is done
+	};
+
+	/**
+	 * @brief Reads many ranges of a file as one batch. On Linux, the reads are handed to the kernel through io_uring,
+	 *		  keeping up to queueDepth of them in flight at once, so fast drives can work on them in parallel.
+	 *		  Elsewhere, or if io_uring is not available, they are done one after another using positional reads.
+	 *		  One reader must only be used by one thread at a time.
+	 */
+	class BatchReader
+	{
+	public:
+		/**
+		 * @param allowIoUring Whether io_uring may be used. The ring is only set up on the first batch.
+		 */
+		BatchReader(unsigned queueDepth = BATCH_READER_DEFAULT_QUEUE_DEPTH, bool allowIoUring = true);
+		~BatchReader();
+
+		/**
+		 * @brief Performs all reads of the batch on the given stream, in any order
+		 * @return False, if any of the reads failed. Check BatchRead::success to find out which one.
+		 */
+		bool read(FILE* stream, std::vector<BatchRead>& reads);
+
+		/**
+		 * @brief Returns whether the reads go through io_uring. Sets up the ring, if that wasn't done yet.
+		 */
+		bool isUsingIoUring();
+
+		/**
+		 * @brief Maximum number of reads in flight at once
+		 */
+		unsigned getQueueDepth() const { return m_QueueDepth; }
+
+	private:
+		BatchReader(const BatchReader&) = delete;
+		BatchReader& operator=(const BatchReader&) = delete;
+
+		/**
+		 * @brief Reads one after another, using positional reads
+		 */
+		bool readSequential(FILE* stream, std::vector<BatchRead>& reads);
+
+		/**
+		 * @brief Reads through io_uring
+		 * @return False, if the ring stopped working. Reads which didn't complete are left unsuccessful then.
+		 */
+		bool readRing(FILE* stream, std::vector<BatchRead>& reads);
+
+		/**
+		 * @brief Sets up the ring, if allowed and not done yet
+		 */
+		void setupRing();
+
+		/**
+		 * @brief Tears the ring down again
+		 */
+		void destroyRing();
+
+		/**
+		 * @brief Submission- and completion-rings, nullptr if io_uring isn't used
+		 */
+		struct Ring;
+		Ring* m_Ring;
+		bool m_RingSetupDone;
+		bool m_AllowIoUring;
+
+		unsigned m_QueueDepth;
+	};
+}
@@ -0,0 +1,165 @@
+#include "fileCache.h"
+
+using namespace VDFS;
+
+FileCache::FileCache() :
+	m_Budget(0),
+	m_BytesCached(0)
+{
+	resetStats();
+}
+
+/**
+ * @brief Sets how many bytes of file-data may be kept
+ */
+void FileCache::setBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	m_Budget = bytes;
+	evict(bytes);
+}
+
+/**
+ * @brief Returns the cached data for the given key, or loads it using the loader
+ */
+SharedFileData FileCache::get(const std::string& key, const Loader& loader)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	auto it = m_Entries.find(key);
+	if(it != m_Entries.end())
+	{
+		m_Stats.hits++;
+
+		// Mark as most recently used
+		m_LRU.splice(m_LRU.begin(), m_LRU, it->second.lru);
+		return it->second.data;
+	}
+
+	// Someone else is already reading this file, wait for them
+	auto loading = m_Loading.find(key);
+	if(loading != m_Loading.end())
+	{
+		m_Stats.coalesced++;
+
+		std::shared_future<SharedFileData> f = loading->second;
+		lock.unlock();
+
+		return f.get();
+	}
+
+	m_Stats.misses++;
+
+	std::promise<SharedFileData> promise;
+	m_Loading[key] = promise.get_future().share();
+	lock.unlock();
+
+	// Read without holding the lock, so other files can be served meanwhile
+	SharedFileData r;
+	try
+	{
+		std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>();
+		if(loader(*data))
+			r = data;
+	}
+	catch(...)
+	{
+		// Whoever waits for this gets the same exception, and the next request tries again
+		lock.lock();
+		m_Loading.erase(key);
+		lock.unlock();
+
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+
+	lock.lock();
+	m_Loading.erase(key);
+
+	// Files larger than the whole budget are handed out, but not kept
+	size_t budget = m_Budget;
+	if(r && r->size() <= budget)
+	{
+		m_LRU.push_front(key);
+
+		Entry e;
+		e.data = r;
+		e.lru = m_LRU.begin();
+		m_Entries[key] = e;
+
+		m_BytesCached += r->size();
+		evict(budget);
+	}
+
+	lock.unlock();
+
+	promise.set_value(r);
+	return r;
+}
+
+/**
+ * @brief Evicts the least recently used files until the budget is met
+ */
+void FileCache::evict(size_t budget)
+{
+	while(m_BytesCached > budget && !m_LRU.empty())
+	{
+		auto it = m_Entries.find(m_LRU.back());
+
+		m_BytesCached -= it->second.data->size();
+		m_Entries.erase(it);
+		m_LRU.pop_back();
+
+		m_Stats.evictions++;
+	}
+}
+
+/**
+ * @brief Drops the given key from the cache, if it is in there
+ */
+void FileCache::remove(const std::string& key)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	auto it = m_Entries.find(key);
+	if(it == m_Entries.end())
+		return;
+
+	m_BytesCached -= it->second.data->size();
+	m_LRU.erase(it->second.lru);
+	m_Entries.erase(it);
+}
+
+/**
+ * @brief Drops all cached files
+ */
+void FileCache::clear()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	m_Entries.clear();
+	m_LRU.clear();
+	m_BytesCached = 0;
+}
+
+/**
+ * @brief Returns the current counters
+ */
+FileCache::Stats FileCache::getStats() const
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	Stats s = m_Stats;
+	s.bytesCached = m_BytesCached;
+	s.numFiles = m_Entries.size();
+
+	return s;
+}
+
+void FileCache::resetStats()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	m_Stats = Stats();
+}
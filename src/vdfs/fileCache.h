@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace VDFS
+{
+	/**
+	 * @brief Immutable file-data, shared between everyone who requested the file
+	 */
+	typedef std::shared_ptr<const std::vector<uint8_t>> SharedFileData;
+
+	/**
+	 * @brief Keeps the data of recently used files in memory, up to a budget of bytes. The least recently used
+	 *		  files get evicted first. Buffers handed out stay valid after eviction, as long as someone holds them.
+	 */
+	class FileCache
+	{
+	public:
+		/**
+		 * @brief Reads the data of a file, on a miss
+		 */
+		typedef std::function<bool(std::vector<uint8_t>&)> Loader;
+
+		/**
+		 * @brief Counters since the cache was created or the stats were last reset
+		 */
+		struct Stats
+		{
+			uint64_t hits;
+			uint64_t misses;
+			uint64_t evictions;
+			uint64_t coalesced; // Requests which waited for a read already in flight, instead of starting their own
+			size_t bytesCached;
+			size_t numFiles;
+		};
+
+		FileCache();
+
+		/**
+		 * @brief Sets how many bytes of file-data may be kept. Evicts files right away if needed. 0 disables the cache.
+		 */
+		void setBudget(size_t bytes);
+		size_t getBudget() const { return m_Budget.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief Returns the cached data for the given key, or loads it using the loader.
+		 *		  If the same key is already being loaded on another thread, waits for that instead of loading it twice.
+		 *		  An exception thrown by the loader is passed on to the caller and to everyone waiting.
+		 * @return nullptr, if the loader failed
+		 */
+		SharedFileData get(const std::string& key, const Loader& loader);
+
+		/**
+		 * @brief Drops the given key from the cache, if it is in there
+		 */
+		void remove(const std::string& key);
+
+		/**
+		 * @brief Drops all cached files
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns the current counters
+		 */
+		Stats getStats() const;
+		void resetStats();
+
+	private:
+		/**
+		 * @brief Evicts the least recently used files until the budget is met. m_Mutex must be locked.
+		 */
+		void evict(size_t budget);
+
+		struct Entry
+		{
+			SharedFileData data;
+			std::list<std::string>::iterator lru;
+		};
+
+		mutable std::mutex m_Mutex;
+		std::atomic<size_t> m_Budget;
+		size_t m_BytesCached;
+
+		/**
+		 * @brief Cached files, and their keys from most to least recently used
+		 */
+		std::unordered_map<std::string, Entry> m_Entries;
+		std::list<std::string> m_LRU;
+
+		/**
+		 * @brief Reads currently in flight
+		 */
+		std::unordered_map<std::string, std::shared_future<SharedFileData>> m_Loading;
+
+		Stats m_Stats;
+	};
+}
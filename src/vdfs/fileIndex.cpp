@@ -1,13 +1,51 @@
 #include "fileIndex.h"
 #include "utils/logger.h"
 #include "archive_virtual.h"
+#include "archive_physical.h"
+#include "archive_compressed.h"
+#include "batchReader.h"
 #include <locale>
 #include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <stdio.h>
 
 using namespace VDFS;
 
-FileIndex::FileIndex()
+namespace
 {
+	/**
+	 * @brief ASCII-only uppercase, same as ::toupper in the "C"-locale, but without a table lookup
+	 */
+	inline char foldCase(char c)
+	{
+		return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+	}
+
+	/**
+	 * @brief FNV-1a over the case-folded name
+	 */
+	inline uint32_t hashFolded(std::string_view name)
+	{
+		uint32_t h = 2166136261u;
+		for(char c : name)
+		{
+			h ^= static_cast<uint8_t>(foldCase(c));
+			h *= 16777619u;
+		}
+
+		return h;
+	}
+}
+
+FileIndex::FileIndex() :
+	m_Directories(1),
+	m_QueryIndexDirty(false),
+	m_TraceEnabled(false),
+	m_RequestStatsEnabled(false)
+{
+	m_Directories[0].parent = 0;
 }
 
 FileIndex::~FileIndex()
@@ -16,12 +54,17 @@ FileIndex::~FileIndex()
 		delete a;
 
 	m_LoadedVirtualArchives.clear();
+
+	for(auto& a : m_LoadedPhysicalArchives)
+		delete a;
+
+	m_LoadedPhysicalArchives.clear();
 }
 
 /**
 * @brief Loads a VDF-File and initializes everything
 */
-bool FileIndex::loadVDF(const std::string& vdf, uint32_t priority)
+bool FileIndex::loadVDF(const std::string& vdf, uint32_t priority, bool memoryMapped)
 {
 	// Check if this was already loaded
 	std::string upper = vdf;
@@ -29,14 +72,10 @@ bool FileIndex::loadVDF(const std::string& vdf, uint32_t priority)
 	if(m_LoadedArchives.find(upper) != m_LoadedArchives.end())
 		return true; // Already loaded, don't do it again
 
-	ArchiveVirtual* a = new ArchiveVirtual();
-
 	// Load the archive
-	if(!a->loadVDF(vdf, priority))
-	{
-		delete a;
+	Archive* a = openArchiveFile(vdf, priority, memoryMapped, true);
+	if(!a)
 		return false;
-	}
 
 	// Grab files and handle load-priority
 	a->insertFilesIntoIndex(*this);
@@ -52,28 +91,170 @@ bool FileIndex::loadVDF(const std::string& vdf, uint32_t priority)
 	return true;
 }
 
+/**
+* @brief Loads multiple VDF-Files at once
+*/
+bool FileIndex::loadVDFs(const std::vector<std::string>& archives, uint32_t priority, bool memoryMapped)
+{
+	std::vector<Archive*> loaded;
+	return loadVDFs(archives, priority, memoryMapped, loaded);
+}
+
+bool FileIndex::loadVDFs(const std::vector<std::string>& archives, uint32_t priority, bool memoryMapped, std::vector<Archive*>& loaded)
+{
+	loaded.assign(archives.size(), nullptr);
+
+	// Sort out everything that was already loaded or is listed twice. Only the first occurrence counts, like with loadVDF.
+	std::vector<std::string> upper(archives.size());
+	std::vector<size_t> toLoad;
+	std::vector<bool> skipped(archives.size(), true);
+	std::set<std::string> requested;
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		upper[i] = archives[i];
+		std::transform(upper[i].begin(), upper[i].end(), upper[i].begin(), ::toupper);
+
+		if(m_LoadedArchives.find(upper[i]) == m_LoadedArchives.end() && requested.insert(upper[i]).second)
+		{
+			toLoad.push_back(i);
+			skipped[i] = false;
+		}
+	}
+
+	// Open the archives and read their catalogs in parallel. This doesn't touch the index yet.
+	std::vector<Archive*> opened(archives.size(), nullptr);
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for(size_t n = next++; n < toLoad.size(); n = next++)
+			opened[toLoad[n]] = openArchiveFile(archives[toLoad[n]], priority, memoryMapped, true);
+	};
+
+	size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), toLoad.size());
+	std::vector<std::thread> threads;
+	for(size_t t = 1; t < numThreads; t++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for(std::thread& t : threads)
+		t.join();
+
+	// Merge in list order, so priorities resolve the same way as when loading one after another
+	bool allLoaded = true;
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		if(!opened[i])
+		{
+			// Archives which were skipped above are fine
+			if(!skipped[i])
+				allLoaded = false;
+
+			continue;
+		}
+
+		opened[i]->insertFilesIntoIndex(*this);
+
+		LogInfo() << "Successfully loaded VDF-Archive: " << archives[i];
+
+		m_LoadedVirtualArchives.emplace_back(opened[i]);
+		m_LoadedArchives.insert(upper[i]);
+		loaded[i] = opened[i];
+	}
+
+	return allLoaded;
+}
+
+/**
+* @brief Opens the given archive-file, depending on its type either as ArchiveVirtual or ArchiveCompressed
+*/
+Archive* FileIndex::openArchiveFile(const std::string& file, uint32_t priority, bool memoryMapped, bool readCatalog)
+{
+	if(ArchiveCompressed::isCompressedArchive(file))
+	{
+		// Catalog is small enough to always read it
+		ArchiveCompressed* a = new ArchiveCompressed();
+		if(a->loadArchive(file, priority, memoryMapped))
+			return a;
+
+		delete a;
+		return nullptr;
+	}
+
+	ArchiveVirtual* a = new ArchiveVirtual();
+	if(readCatalog ? a->loadVDF(file, priority, memoryMapped) : a->openVDF(file, priority, memoryMapped))
+		return a;
+
+	delete a;
+	return nullptr;
+}
+
+/**
+* @brief Scans the given directory tree and adds all loose files found there to the index
+*/
+bool FileIndex::loadDirectory(const std::string& directory, uint32_t priority, bool memoryMapped)
+{
+	// Check if this was already loaded
+	std::string upper = directory;
+	std::transform(upper.begin(), upper.end(),upper.begin(), ::toupper);
+	if(m_LoadedArchives.find(upper) != m_LoadedArchives.end())
+		return true; // Already loaded, don't do it again
+
+	ArchivePhysical* a = new ArchivePhysical();
+
+	if(!a->loadDirectory(directory, priority, memoryMapped))
+	{
+		delete a;
+		return false;
+	}
+
+	size_t numFiles = a->insertFilesIntoIndex(*this);
+
+	LogInfo() << "Successfully loaded directory: " << directory << " (" << numFiles << " files)";
+
+	m_LoadedPhysicalArchives.emplace_back(a);
+	m_LoadedArchives.insert(upper);
+
+	return true;
+}
+
 /**
 * @brief Places a file into the index
 * @return True if the file was new, false otherwise
 */
-bool FileIndex::addFile(const FileInfo& inf)
+bool FileIndex::addFile(const FileInfo& inf, std::string_view directory)
 {
 	// Already exists?
-	auto it = m_FileIndicesByName.find(inf.fileName);
-	if(it != m_FileIndicesByName.end())
+	size_t idx = findFileIndex(inf.fileName);
+	if(idx != static_cast<size_t>(-1))
 	{
 		// Check priority
-		if(inf.priority <= m_KnownFiles[(*it).second].priority)
+		if(inf.priority <= m_KnownFiles[idx].priority)
 			return false;
 
 		// Overwrite if new priority is greater
-		m_KnownFiles[(*it).second] = inf;
+		m_KnownFiles[idx] = inf;
+		m_FileCache.remove(std::string(getFoldedName(idx)));
+		m_FileDirectories[idx] = getDirectoryId(directory);
+		m_QueryIndexDirty = true;
 		return true;
 	}
 
-	// Add to known files and register in the index-map
+	// Intern the case-folded name
+	IndexedName n;
+	n.arenaOffset = static_cast<uint32_t>(m_NameArena.size());
+	n.length = static_cast<uint32_t>(inf.fileName.size());
+	n.hash = hashFolded(inf.fileName);
+
+	for(char c : inf.fileName)
+		m_NameArena.push_back(foldCase(c));
+
+	// Add to known files and register in the hash-table
 	m_KnownFiles.push_back(inf);
-	m_FileIndicesByName[inf.fileName] = m_KnownFiles.size() - 1;
+	m_IndexedNames.push_back(n);
+	m_FileDirectories.push_back(getDirectoryId(directory));
+	m_QueryIndexDirty = true;
+
+	insertIntoHashTable(m_KnownFiles.size() - 1);
 
 	return true;
 }
@@ -82,19 +263,22 @@ bool FileIndex::addFile(const FileInfo& inf)
 * @brief Replaces a file matching the same name
 * @return True, if the file was actually replaced. False if it was just added because it didn't exist
 */
-bool FileIndex::replaceFileByName(const FileInfo& inf)
+bool FileIndex::replaceFileByName(const FileInfo& inf, std::string_view directory)
 {
 	// Check if the file even exists first
-	auto it = m_FileIndicesByName.find(inf.fileName);
-	if(it == m_FileIndicesByName.end())
+	size_t idx = findFileIndex(inf.fileName);
+	if(idx == static_cast<size_t>(-1))
 	{
 		// It doesn't, just add it
-		addFile(inf);
+		addFile(inf, directory);
 		return false;
 	}
 
 	// It does exist, replace it
-	m_KnownFiles[(*it).second] = inf;
+	m_KnownFiles[idx] = inf;
+	m_FileCache.remove(std::string(getFoldedName(idx)));
+	m_FileDirectories[idx] = getDirectoryId(directory);
+	m_QueryIndexDirty = true;
 	return true;
 }
 
@@ -102,29 +286,108 @@ bool FileIndex::replaceFileByName(const FileInfo& inf)
 * @brief Fills the given pointer with the information about the provided filename.
 * @return False, if the file was not found
 */
-bool FileIndex::getFileByName(const std::string& name, FileInfo* outinf) const
+bool FileIndex::getFileByName(std::string_view name, FileInfo* outinf) const
 {
 	// Does the file even exist?
-	std::string upper = name;
-	std::transform(upper.begin(), upper.end(),upper.begin(), ::toupper);
-
-	auto it = m_FileIndicesByName.find(upper);
-	if(it == m_FileIndicesByName.end())
+	const FileInfo* inf = findFile(name);
+	if(!inf)
 		return false;
 
 	// Output the file information
-	if(outinf)*outinf = m_KnownFiles[(*it).second];
+	if(outinf)*outinf = *inf;
 
 	return true;
 }
 
+/**
+* @brief Returns the information about the provided filename without copying it
+*/
+const FileInfo* FileIndex::findFile(std::string_view name) const
+{
+	size_t idx = findFileIndex(name);
+	if(idx == static_cast<size_t>(-1))
+		return nullptr;
+
+	return &m_KnownFiles[idx];
+}
+
+/**
+* @brief Returns the index of the given file in m_KnownFiles, or -1 if it isn't known
+*/
+size_t FileIndex::findFileIndex(std::string_view name) const
+{
+	if(m_HashSlots.empty())
+		return static_cast<size_t>(-1);
+
+	uint32_t hash = hashFolded(name);
+	size_t mask = m_HashSlots.size() - 1;
+
+	// Linear probing until we hit an empty slot
+	for(size_t slot = hash & mask; m_HashSlots[slot] != 0; slot = (slot + 1) & mask)
+	{
+		size_t idx = m_HashSlots[slot] - 1;
+		const IndexedName& n = m_IndexedNames[idx];
+
+		if(n.hash != hash || n.length != name.size())
+			continue;
+
+		// Names in the arena are already folded
+		const char* stored = &m_NameArena[n.arenaOffset];
+		size_t i = 0;
+		while(i < name.size() && foldCase(name[i]) == stored[i])
+			i++;
+
+		if(i == name.size())
+			return idx;
+	}
+
+	return static_cast<size_t>(-1);
+}
+
+/**
+* @brief Puts the file at the given index of m_KnownFiles into the hash-table
+*/
+void FileIndex::insertIntoHashTable(size_t fileIdx)
+{
+	// Keep the load factor at or below 0.5, rehash everything when growing
+	if(m_KnownFiles.size() * 2 > m_HashSlots.size())
+	{
+		size_t newSize = m_HashSlots.empty() ? 1024 : m_HashSlots.size() * 2;
+		while(m_KnownFiles.size() * 2 > newSize)
+			newSize *= 2;
+
+		m_HashSlots.assign(newSize, 0);
+
+		// Everything up to fileIdx is already known, fileIdx gets inserted below
+		for(size_t i = 0; i < fileIdx; i++)
+			insertIntoHashTable(i);
+	}
+
+	size_t mask = m_HashSlots.size() - 1;
+	size_t slot = m_IndexedNames[fileIdx].hash & mask;
+	while(m_HashSlots[slot] != 0)
+		slot = (slot + 1) & mask;
+
+	m_HashSlots[slot] = static_cast<uint32_t>(fileIdx + 1);
+}
+
 /**
 * @brief Clears the complete index and all registered files
 */
 void FileIndex::clearIndex()
 {
-	m_FileIndicesByName.clear();
+	m_HashSlots.clear();
+	m_IndexedNames.clear();
+	m_NameArena.clear();
 	m_KnownFiles.clear();
+	m_FileDirectories.clear();
+	m_Directories.resize(1);
+	m_Directories[0].children.clear();
+	m_QueryIndexDirty = true;
+	m_FileCache.clear();
+
+	std::lock_guard<std::mutex> guard(m_RequestMutex);
+	m_FileRequests.clear();
 }
 
 /**
@@ -132,19 +395,766 @@ void FileIndex::clearIndex()
 */
 bool FileIndex::getFileData(const FileInfo& inf, std::vector<uint8_t>& data) const
 {
+	recordAccess(inf, inf.fileSize);
+
+	return readFileData(inf, data);
+}
+
+/**
+* @brief Fills a vector with the data of the given file, going through the file-cache if it has a budget
+*/
+bool FileIndex::readFileData(const FileInfo& inf, std::vector<uint8_t>& data) const
+{
+	if(m_FileCache.getBudget())
+	{
+		SharedFileData shared = readSharedFileData(inf);
+		if(!shared)
+			return false;
+
+		data.assign(shared->begin(), shared->end());
+		return true;
+	}
+
 	return inf.targetArchive->extractFile(inf, data);
 }
 
-bool FileIndex::getFileData(const std::string& file, std::vector<uint8_t>& data) const
+bool FileIndex::getFileData(std::string_view file, std::vector<uint8_t>& data) const
 {
-	std::string upper = file;
-	std::transform(upper.begin(), upper.end(),upper.begin(), ::toupper);
+	const FileInfo* inf = findFile(file);
+	if(inf)
+		return getFileData(*inf, data);
 
-	FileInfo inf;
-	if(getFileByName(upper, &inf))
-		return inf.targetArchive->extractFile(inf, data);
+	LogError() << "File not found: " << file;
+
+	return false;
+}
+
+/**
+* @brief Extracts multiple files at once, sorted by archive and offset
+*/
+bool FileIndex::getFileDataMany(const std::vector<std::string>& names, std::vector<std::vector<uint8_t>>& data) const
+{
+	bool allRead = true;
+
+	data.clear();
+	data.resize(names.size());
+
+	// Resolve everything first
+	std::vector<FileInfo> infos(names.size());
+	std::vector<size_t> order;
+	order.reserve(names.size());
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		if(!getFileByName(names[i], &infos[i]))
+		{
+			LogError() << "File not found: " << names[i];
+			allRead = false;
+			continue;
+		}
+
+		order.push_back(i);
+	}
+
+	// Trace in requested order, not in the order we read
+	for(size_t i : order)
+		recordAccess(infos[i], infos[i].fileSize);
+
+	// Group by archive and read each one front to back
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		if(infos[a].targetArchive != infos[b].targetArchive)
+			return std::less<Archive*>()(infos[a].targetArchive, infos[b].targetArchive);
+
+		return infos[a].archiveOffset < infos[b].archiveOffset;
+	});
+
+	// Each archive gets all of its files as one batch. The reader keeps its ring between calls, and as it may only
+	// be used by one thread at a time, every thread gets its own.
+	thread_local BatchReader reader;
+	std::vector<const FileInfo*> files;
+	std::vector<uint8_t*> targets;
+	for(size_t first = 0; first < order.size();)
+	{
+		Archive* archive = infos[order[first]].targetArchive;
+
+		files.clear();
+		targets.clear();
+
+		size_t last = first;
+		for(; last < order.size() && infos[order[last]].targetArchive == archive; last++)
+		{
+			size_t i = order[last];
+			data[i].resize(infos[i].fileSize);
+
+			files.push_back(&infos[i]);
+			targets.push_back(data[i].data());
+		}
+
+		if(!archive->extractFiles(files, targets, reader))
+			allRead = false;
+
+		first = last;
+	}
+
+	return allRead;
+}
+
+/**
+* @brief Fills the view with a pointer into the mapped archive holding the given file, without copying anything
+*/
+bool FileIndex::getFileView(const FileInfo& inf, FileView& view, std::vector<uint8_t>* storage) const
+{
+	bool viewed = peekFileView(inf, view, storage);
+
+	// Only count what was handed out. Callers without storage read the file some other way then, and count it there.
+	if(viewed || storage)
+		recordAccess(inf, inf.fileSize);
+
+	return viewed;
+}
+
+/**
+* @brief Same as getFileView, without counting the request
+*/
+bool FileIndex::peekFileView(const FileInfo& inf, FileView& view, std::vector<uint8_t>* storage) const
+{
+	if(inf.targetArchive->getFileView(inf, view))
+		return true;
+
+	// Archive isn't mapped, fall back to a copy if we may
+	if(!storage || !readFileData(inf, *storage))
+		return false;
+
+	view.data = storage->data();
+	view.size = storage->size();
+
+	return true;
+}
+
+bool FileIndex::getFileView(std::string_view file, FileView& view, std::vector<uint8_t>* storage) const
+{
+	const FileInfo* inf = findFile(file);
+	if(inf)
+		return getFileView(*inf, view, storage);
 
 	LogError() << "File not found: " << file;
 
 	return false;
-}
\ No newline at end of file
+}
+
+/**
+* @brief Reads up to length bytes of the given file, starting at offset
+*/
+bool FileIndex::readRange(const FileInfo& inf, uint32_t offset, uint32_t length, std::vector<uint8_t>& data) const
+{
+	if(offset > inf.fileSize)
+		return false;
+
+	data.resize(std::min(length, inf.fileSize - offset));
+
+	return readRange(inf, offset, static_cast<uint32_t>(data.size()), data.data());
+}
+
+bool FileIndex::readRange(std::string_view file, uint32_t offset, uint32_t length, std::vector<uint8_t>& data) const
+{
+	const FileInfo* inf = findFile(file);
+	if(inf)
+		return readRange(*inf, offset, length, data);
+
+	LogError() << "File not found: " << file;
+
+	return false;
+}
+
+/**
+* @brief Reads exactly length bytes of the given file, starting at offset, into target
+*/
+bool FileIndex::readRange(const FileInfo& inf, uint32_t offset, uint32_t length, uint8_t* target) const
+{
+	recordAccess(inf, length);
+
+	return readRangeData(inf, offset, length, target);
+}
+
+/**
+* @brief Reads the range without counting the request
+*/
+bool FileIndex::readRangeData(const FileInfo& inf, uint32_t offset, uint32_t length, uint8_t* target) const
+{
+	if(!inf.targetArchive->extractRange(inf, offset, length, target))
+	{
+		LogError() << "Failed to read range " << offset << "+" << length << " of " << inf.fileName;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+* @brief Returns the data of the given file as shared, immutable buffer
+*/
+SharedFileData FileIndex::getSharedFileData(const FileInfo& inf) const
+{
+	recordAccess(inf, inf.fileSize);
+
+	return readSharedFileData(inf);
+}
+
+/**
+* @brief Loads the given file into a shared buffer, or takes it from the file-cache
+*/
+SharedFileData FileIndex::readSharedFileData(const FileInfo& inf) const
+{
+	auto load = [&](std::vector<uint8_t>& data) {
+		return inf.targetArchive->extractFile(inf, data);
+	};
+
+	if(!m_FileCache.getBudget())
+	{
+		std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>();
+		return load(*data) ? data : nullptr;
+	}
+
+	std::string key = inf.fileName;
+	std::transform(key.begin(), key.end(), key.begin(), foldCase);
+
+	return m_FileCache.get(key, load);
+}
+
+SharedFileData FileIndex::getSharedFileData(std::string_view file) const
+{
+	const FileInfo* inf = findFile(file);
+	if(inf)
+		return getSharedFileData(*inf);
+
+	LogError() << "File not found: " << file;
+
+	return nullptr;
+}
+
+/**
+* @brief Warms the given file, so a following request doesn't have to wait for the disk
+*/
+void FileIndex::prefetchFile(const FileInfo& inf) const
+{
+	if(!m_FileCache.getBudget())
+	{
+		inf.targetArchive->prefetch(inf);
+		return;
+	}
+
+	std::string key = inf.fileName;
+	std::transform(key.begin(), key.end(), key.begin(), foldCase);
+
+	// Not through getSharedFileData, this is no request to trace
+	m_FileCache.get(key, [&](std::vector<uint8_t>& data) {
+		return inf.targetArchive->extractFile(inf, data);
+	});
+}
+
+/**
+* @brief Keeps up to the given number of bytes of recently requested files in memory
+*/
+void FileIndex::setFileCacheBudget(size_t bytes)
+{
+	m_FileCache.setBudget(bytes);
+}
+
+/**
+* @brief Returns the id of the given directory, creating it and its parents if needed
+*/
+uint32_t FileIndex::getDirectoryId(std::string_view path)
+{
+	uint32_t dir = 0;
+
+	size_t start = 0;
+	while(start < path.size())
+	{
+		size_t end = path.find_first_of("/\\", start);
+		if(end == std::string_view::npos)
+			end = path.size();
+
+		std::string_view part = path.substr(start, end - start);
+		start = end + 1;
+
+		if(part.empty())
+			continue;
+
+		std::string folded(part);
+		std::transform(folded.begin(), folded.end(), folded.begin(), foldCase);
+
+		uint32_t child = static_cast<uint32_t>(-1);
+		for(uint32_t c : m_Directories[dir].children)
+		{
+			if(m_Directories[c].foldedName == folded)
+			{
+				child = c;
+				break;
+			}
+		}
+
+		if(child == static_cast<uint32_t>(-1))
+		{
+			child = static_cast<uint32_t>(m_Directories.size());
+
+			Directory d;
+			d.parent = dir;
+			d.name = std::string(part);
+			d.foldedName = folded;
+			m_Directories.push_back(d);
+			m_Directories[dir].children.push_back(child);
+		}
+
+		dir = child;
+	}
+
+	return dir;
+}
+
+/**
+* @brief Returns the id of the given directory, or -1 if it doesn't exist
+*/
+uint32_t FileIndex::findDirectory(std::string_view path) const
+{
+	uint32_t dir = 0;
+
+	size_t start = 0;
+	while(start < path.size())
+	{
+		size_t end = path.find_first_of("/\\", start);
+		if(end == std::string_view::npos)
+			end = path.size();
+
+		std::string_view part = path.substr(start, end - start);
+		start = end + 1;
+
+		if(part.empty())
+			continue;
+
+		uint32_t child = static_cast<uint32_t>(-1);
+		for(uint32_t c : m_Directories[dir].children)
+		{
+			const std::string& n = m_Directories[c].foldedName;
+			if(n.size() == part.size() && std::equal(part.begin(), part.end(), n.begin(), [](char a, char b) { return foldCase(a) == b; }))
+			{
+				child = c;
+				break;
+			}
+		}
+
+		if(child == static_cast<uint32_t>(-1))
+			return child;
+
+		dir = child;
+	}
+
+	return dir;
+}
+
+/**
+* @brief Returns the full path of the given directory
+*/
+std::string FileIndex::getDirectoryPath(uint32_t directory) const
+{
+	std::string path;
+	for(uint32_t d = directory; d != 0; d = m_Directories[d].parent)
+		path = m_Directories[d].name + (path.empty() ? "" : "/") + path;
+
+	return path;
+}
+
+/**
+* @brief Returns the path of the given file inside its archive
+*/
+std::string FileIndex::getFilePath(const FileInfo& inf) const
+{
+	size_t idx = findFileIndex(inf.fileName);
+	if(idx == static_cast<size_t>(-1))
+		return inf.fileName;
+
+	std::string dir = getDirectoryPath(m_FileDirectories[idx]);
+	return dir.empty() ? inf.fileName : dir + "/" + inf.fileName;
+}
+
+/**
+* @brief Returns the case-folded name of the file at the given index of m_KnownFiles
+*/
+std::string_view FileIndex::getFoldedName(size_t fileIdx) const
+{
+	const IndexedName& n = m_IndexedNames[fileIdx];
+	return std::string_view(m_NameArena.data() + n.arenaOffset, n.length);
+}
+
+namespace
+{
+	/**
+	 * @brief Returns the extension of an already folded name, without the dot
+	 */
+	std::string_view extensionOf(std::string_view name)
+	{
+		size_t dot = name.rfind('.');
+		return dot == std::string_view::npos ? std::string_view() : name.substr(dot + 1);
+	}
+
+	/**
+	 * @brief Case-insensitive glob-match of '*' and '?'. The name has to be folded already.
+	 */
+	bool globMatch(std::string_view pattern, std::string_view name)
+	{
+		size_t p = 0, n = 0;
+		size_t starP = std::string_view::npos, starN = 0;
+
+		while(n < name.size())
+		{
+			if(p < pattern.size() && pattern[p] == '*')
+			{
+				// Remember where to go back to, if the rest doesn't match
+				starP = p++;
+				starN = n;
+			}
+			else if(p < pattern.size() && (pattern[p] == '?' || foldCase(pattern[p]) == name[n]))
+			{
+				p++;
+				n++;
+			}
+			else if(starP != std::string_view::npos)
+			{
+				p = starP + 1;
+				n = ++starN;
+			}
+			else
+				return false;
+		}
+
+		while(p < pattern.size() && pattern[p] == '*')
+			p++;
+
+		return p == pattern.size();
+	}
+
+	/**
+	 * @brief Compares a folded name against a not yet folded key
+	 */
+	int compareFolded(std::string_view folded, std::string_view key)
+	{
+		size_t n = std::min(folded.size(), key.size());
+		for(size_t i = 0; i < n; i++)
+		{
+			char k = foldCase(key[i]);
+			if(folded[i] != k)
+				return static_cast<unsigned char>(folded[i]) < static_cast<unsigned char>(k) ? -1 : 1;
+		}
+
+		return folded.size() == key.size() ? 0 : (folded.size() < key.size() ? -1 : 1);
+	}
+}
+
+/**
+* @brief Rebuilds the sorted indices used by the queries
+*/
+void FileIndex::updateQueryIndex() const
+{
+	if(!m_QueryIndexDirty && m_SortedByName.size() == m_KnownFiles.size())
+		return;
+
+	m_SortedByName.resize(m_KnownFiles.size());
+	for(size_t i = 0; i < m_SortedByName.size(); i++)
+		m_SortedByName[i] = static_cast<uint32_t>(i);
+
+	std::sort(m_SortedByName.begin(), m_SortedByName.end(), [&](uint32_t a, uint32_t b) {
+		return getFoldedName(a) < getFoldedName(b);
+	});
+
+	// Stable, so files with the same extension stay sorted by name
+	m_SortedByExtension = m_SortedByName;
+	std::stable_sort(m_SortedByExtension.begin(), m_SortedByExtension.end(), [&](uint32_t a, uint32_t b) {
+		return extensionOf(getFoldedName(a)) < extensionOf(getFoldedName(b));
+	});
+
+	m_DirectoryFiles.assign(m_Directories.size(), std::vector<uint32_t>());
+	for(uint32_t idx : m_SortedByName)
+		m_DirectoryFiles[m_FileDirectories[idx]].push_back(idx);
+
+	m_QueryIndexDirty = false;
+}
+
+/**
+* @brief Returns all files whose name starts with the given prefix
+*/
+std::vector<const FileInfo*> FileIndex::findFilesByPrefix(std::string_view prefix) const
+{
+	std::lock_guard<std::mutex> guard(m_QueryMutex);
+	updateQueryIndex();
+
+	// Everything starting with the prefix is in one range of the sorted list
+	auto first = std::lower_bound(m_SortedByName.begin(), m_SortedByName.end(), prefix, [&](uint32_t idx, std::string_view key) {
+		return compareFolded(getFoldedName(idx).substr(0, key.size()), key) < 0;
+	});
+
+	std::vector<const FileInfo*> r;
+	for(auto it = first; it != m_SortedByName.end() && compareFolded(getFoldedName(*it).substr(0, prefix.size()), prefix) == 0; ++it)
+		r.push_back(&m_KnownFiles[*it]);
+
+	return r;
+}
+
+/**
+* @brief Returns all files with the given extension
+*/
+std::vector<const FileInfo*> FileIndex::findFilesByExtension(std::string_view extension) const
+{
+	if(!extension.empty() && extension[0] == '.')
+		extension.remove_prefix(1);
+
+	std::lock_guard<std::mutex> guard(m_QueryMutex);
+	updateQueryIndex();
+
+	auto first = std::lower_bound(m_SortedByExtension.begin(), m_SortedByExtension.end(), extension, [&](uint32_t idx, std::string_view key) {
+		return compareFolded(extensionOf(getFoldedName(idx)), key) < 0;
+	});
+
+	std::vector<const FileInfo*> r;
+	for(auto it = first; it != m_SortedByExtension.end() && compareFolded(extensionOf(getFoldedName(*it)), extension) == 0; ++it)
+		r.push_back(&m_KnownFiles[*it]);
+
+	return r;
+}
+
+/**
+* @brief Returns all files inside the given directory
+*/
+std::vector<const FileInfo*> FileIndex::findFilesInDirectory(std::string_view directory, bool recursive) const
+{
+	std::vector<const FileInfo*> r;
+
+	std::lock_guard<std::mutex> guard(m_QueryMutex);
+
+	uint32_t dir = findDirectory(directory);
+	if(dir == static_cast<uint32_t>(-1))
+		return r;
+
+	updateQueryIndex();
+
+	std::vector<uint32_t> stack(1, dir);
+	std::vector<uint32_t> found;
+	while(!stack.empty())
+	{
+		uint32_t d = stack.back();
+		stack.pop_back();
+
+		found.insert(found.end(), m_DirectoryFiles[d].begin(), m_DirectoryFiles[d].end());
+
+		if(recursive)
+			stack.insert(stack.end(), m_Directories[d].children.begin(), m_Directories[d].children.end());
+	}
+
+	// Files of multiple directories need to be merged back into name-order
+	if(recursive)
+	{
+		std::sort(found.begin(), found.end(), [&](uint32_t a, uint32_t b) {
+			return getFoldedName(a) < getFoldedName(b);
+		});
+	}
+
+	for(uint32_t idx : found)
+		r.push_back(&m_KnownFiles[idx]);
+
+	return r;
+}
+
+/**
+* @brief Returns all files matching the given pattern
+*/
+std::vector<const FileInfo*> FileIndex::findFilesByGlob(std::string_view pattern) const
+{
+	std::vector<const FileInfo*> r;
+
+	// Patterns with a directory-part get matched against whole paths
+	size_t slash = pattern.find_last_of("/\\");
+	if(slash != std::string_view::npos)
+	{
+		std::string_view dirPattern = pattern.substr(0, slash);
+		std::string_view namePattern = pattern.substr(slash + 1);
+
+		// Only the name has wildcards, so only a single directory needs to be looked at
+		if(dirPattern.find_first_of("*?") == std::string_view::npos)
+		{
+			for(const FileInfo* inf : findFilesInDirectory(dirPattern))
+			{
+				if(globMatch(namePattern, getFoldedName(inf - m_KnownFiles.data())))
+					r.push_back(inf);
+			}
+
+			return r;
+		}
+
+		std::lock_guard<std::mutex> guard(m_QueryMutex);
+		updateQueryIndex();
+
+		// Directories may be given with either separator
+		std::string p(pattern);
+		std::replace(p.begin(), p.end(), '\\', '/');
+
+		std::string folded;
+		for(uint32_t idx : m_SortedByName)
+		{
+			folded = getDirectoryPath(m_FileDirectories[idx]) + "/" + std::string(getFoldedName(idx));
+			std::transform(folded.begin(), folded.end(), folded.begin(), foldCase);
+
+			if(globMatch(p, folded))
+				r.push_back(&m_KnownFiles[idx]);
+		}
+
+		return r;
+	}
+
+	// Names with a literal start only need to look at the files with that prefix
+	size_t wildcard = pattern.find_first_of("*?");
+	if(wildcard == std::string_view::npos)
+	{
+		const FileInfo* inf = findFile(pattern);
+		if(inf)
+			r.push_back(inf);
+
+		return r;
+	}
+
+	std::vector<const FileInfo*> candidates;
+	if(wildcard > 0)
+		candidates = findFilesByPrefix(pattern.substr(0, wildcard));
+	else if(pattern.size() > 2 && pattern[1] == '.' && pattern.find_first_of("*?.", 2) == std::string_view::npos)
+		candidates = findFilesByExtension(pattern.substr(2)); // Common case of "*.EXT". Not "*.A.B", extensions end at the last dot.
+	else
+	{
+		std::lock_guard<std::mutex> guard(m_QueryMutex);
+		updateQueryIndex();
+
+		for(uint32_t idx : m_SortedByName)
+			candidates.push_back(&m_KnownFiles[idx]);
+	}
+
+	for(const FileInfo* inf : candidates)
+	{
+		if(globMatch(pattern, getFoldedName(inf - m_KnownFiles.data())))
+			r.push_back(inf);
+	}
+
+	return r;
+}
+
+/**
+* @brief Starts recording the order in which files are requested
+*/
+void FileIndex::startAccessTrace()
+{
+	std::lock_guard<std::mutex> guard(m_TraceMutex);
+
+	m_AccessTrace.clear();
+	m_TracedFiles.clear();
+	m_TraceEnabled = true;
+}
+
+/**
+* @brief Stops recording file requests
+*/
+void FileIndex::stopAccessTrace()
+{
+	m_TraceEnabled = false;
+}
+
+/**
+* @brief Returns the names of all files requested while tracing, in order
+*/
+std::vector<std::string> FileIndex::getAccessTrace() const
+{
+	std::lock_guard<std::mutex> guard(m_TraceMutex);
+	return m_AccessTrace;
+}
+
+/**
+* @brief Counts a request for bytes of the given file and puts it into the access-trace, if tracing is enabled
+*		 and it wasn't requested before
+*/
+void FileIndex::recordAccess(const FileInfo& inf, uint64_t bytes) const
+{
+	// Keep this cheap when neither is enabled, it's on every read
+	if(m_RequestStatsEnabled.load(std::memory_order_relaxed))
+	{
+		// Most callers pass a reference into m_KnownFiles, which saves the lookup
+		size_t idx = &inf >= m_KnownFiles.data() && &inf < m_KnownFiles.data() + m_KnownFiles.size()
+			? static_cast<size_t>(&inf - m_KnownFiles.data())
+			: findFileIndex(inf.fileName);
+
+		if(idx != static_cast<size_t>(-1))
+		{
+			std::lock_guard<std::mutex> guard(m_RequestMutex);
+			if(m_FileRequests.size() < m_KnownFiles.size())
+				m_FileRequests.resize(m_KnownFiles.size(), FileRequestCounter{0, 0});
+
+			m_FileRequests[idx].numRequests++;
+			m_FileRequests[idx].bytesRequested += bytes;
+		}
+	}
+
+	if(!m_TraceEnabled.load(std::memory_order_relaxed))
+		return;
+
+	std::string upper = inf.fileName;
+	std::transform(upper.begin(), upper.end(), upper.begin(), foldCase);
+
+	std::lock_guard<std::mutex> guard(m_TraceMutex);
+	if(m_TracedFiles.insert(upper).second)
+		m_AccessTrace.push_back(inf.fileName);
+}
+
+/**
+* @brief Writes the access-trace to the given text-file, one file name per line
+*/
+bool FileIndex::saveAccessTrace(const std::string& file) const
+{
+	std::vector<std::string> trace = getAccessTrace();
+
+	FILE* f = fopen(file.c_str(), "w");
+	if(!f)
+	{
+		LogError() << "Failed to open file for writing: " << file;
+		return false;
+	}
+
+	bool ok = true;
+	for(const std::string& name : trace)
+		ok = fprintf(f, "%s\n", name.c_str()) >= 0 && ok;
+
+	ok = fclose(f) == 0 && ok;
+
+	return ok;
+}
+
+/**
+* @brief Reads an access-trace written by saveAccessTrace
+*/
+bool FileIndex::loadAccessTrace(const std::string& file, std::vector<std::string>& names)
+{
+	FILE* f = fopen(file.c_str(), "r");
+	if(!f)
+	{
+		LogError() << "Failed to open file: " << file;
+		return false;
+	}
+
+	char line[512];
+	while(fgets(line, sizeof(line), f))
+	{
+		std::string name = line;
+
+		// Strip line endings, also the ones from windows
+		while(!name.empty() && (name.back() == '\n' || name.back() == '\r'))
+			name.pop_back();
+
+		if(!name.empty())
+			names.push_back(name);
+	}
+
+	fclose(f);
+
+	return true;
+}
@@ -1,16 +1,22 @@
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 #include <set>
+#include <mutex>
+#include <atomic>
+#include <utility>
 
 
 #include "archive_virtual.h"
+#include "archive_physical.h"
+#include "fileCache.h"
 
 namespace VDFS
 {
-	// TODO: Repace with general class and make a forward decl!
 	class ArchiveVirtual;
+	class ArchivePhysical;
+	class ArchiveCompressed;
 
 	/**
 	 * @brief Information about in which archive the file is and on what offset it starts
@@ -19,45 +25,247 @@ namespace VDFS
 	{
 		std::string fileName;
 		uint32_t fileSize;
-		ArchiveVirtual* targetArchive; 
-		uint32_t archiveOffset; // 0 for physical files
+		Archive* targetArchive; 
+		uint32_t archiveOffset; // Index of the file in its directory-scan for physical files
 		uint32_t priority;
 	};
 
+	/**
+	 * @brief How often a single file was requested through the index, see FileIndex::getMostRequestedFiles
+	 */
+	struct FileRequestStats
+	{
+		std::string fileName;
+		uint32_t fileSize;
+		uint64_t numRequests;
+		uint64_t bytesRequested;
+	};
+
 	class FileIndex
 	{
+		// Counts each opened file once, not every read going to the archive
+		friend class FileReader;
+
 	public:
 		FileIndex();
 		~FileIndex();
 
 		/**
-		 * @brief Loads a VDF-File and initializes everything
+		 * @brief Loads a VDF-File and initializes everything. Compressed archives written by ArchiveWriter are detected and loaded as well.
+		 * @param memoryMapped Map the archive into memory, so files can be accessed using getFileView
+		 */
+		bool loadVDF(const std::string& vdf, uint32_t priority = 0, bool memoryMapped = false);
+
+		/**
+		 * @brief Loads multiple VDF-Files at once. Catalogs are read in parallel, then merged into the index
+		 *		  in list order, so the result is the same as calling loadVDF for each of them.
+		 * @return False, if any of the archives could not be loaded
 		 */
-		bool loadVDF(const std::string& vdf, uint32_t priority = 0);
+		bool loadVDFs(const std::vector<std::string>& archives, uint32_t priority = 0, bool memoryMapped = false);
+
+		/**
+		 * @brief Scans the given directory tree once and adds all loose files found there to the index.
+		 *		  By default, these override files of the same name from any VDF-archive.
+		 * @param memoryMapped Map files into memory when they are viewed using getFileView
+		 */
+		bool loadDirectory(const std::string& directory, uint32_t priority = ARCHIVE_PHYSICAL_PRIORITY, bool memoryMapped = false);
+
+		/**
+		 * @brief Loads the given VDF-Files in order, like calling loadVDF for each of them.
+		 *		  The merged index is stored in cacheFile, so following runs can skip reading the archive catalogs.
+		 *		  The cache is rebuilt whenever the list of archives or any of their sizes or modification times change.
+		 *		  Only used when the index is still empty, otherwise this just loads the archives.
+		 * @return False, if any of the archives could not be loaded
+		 */
+		bool loadVDFsCached(const std::vector<std::string>& archives, const std::string& cacheFile, uint32_t priority = 0, bool memoryMapped = false);
 
 		/**
 		 * @brief Places a file into the index
+		 * @param directory Directory the file is in, like "_WORK/DATA/ANIMS". Used by the directory- and path-queries.
 		 * @return True if the file was new, false otherwise
 		 */
-		bool addFile(const FileInfo& inf);
+		bool addFile(const FileInfo& inf, std::string_view directory = std::string_view());
 
 		/**
 		 * @brief Replaces a file matching the same name
 		 * @return True, if the file was actually replaced. False if it was just added because it didn't exist
 		 */
-		bool replaceFileByName(const FileInfo& inf);
+		bool replaceFileByName(const FileInfo& inf, std::string_view directory = std::string_view());
 
 		/**
 		 * @brief Fills the given pointer with the information about the provided filename.
+		 *		  Lookup is case-insensitive and doesn't allocate.
 		 * @return False, if the file was not found
 		 */
-		bool getFileByName(const std::string& name, FileInfo* outinf) const;
+		bool getFileByName(std::string_view name, FileInfo* outinf) const;
 
 		/**
-		 * @brief Fills a vector with the data of the given file
+		 * @brief Returns the information about the provided filename without copying it, nullptr if not found.
+		 *		  Only valid until the index is modified.
+		 */
+		const FileInfo* findFile(std::string_view name) const;
+
+		/**
+		 * @brief Returns all files whose name starts with the given prefix, like "HUMANS-" for all animations of that model.
+		 *		  Case-insensitive, sorted by name. Pointers are only valid until the index is modified.
+		 */
+		std::vector<const FileInfo*> findFilesByPrefix(std::string_view prefix) const;
+
+		/**
+		 * @brief Returns all files with the given extension, with or without the leading dot. Sorted by name.
+		 */
+		std::vector<const FileInfo*> findFilesByExtension(std::string_view extension) const;
+
+		/**
+		 * @brief Returns all files inside the given directory, like "_WORK/DATA/TEXTURES". Sorted by name.
+		 * @param recursive Whether to include the files of all subdirectories as well
+		 */
+		std::vector<const FileInfo*> findFilesInDirectory(std::string_view directory, bool recursive = false) const;
+
+		/**
+		 * @brief Returns all files matching the given pattern, where '*' matches any number of characters and '?' a single one.
+		 *		  Patterns containing a '/' are matched against the whole path, otherwise only against the name. Sorted by name.
+		 */
+		std::vector<const FileInfo*> findFilesByGlob(std::string_view pattern) const;
+
+		/**
+		 * @brief Returns the path of the given file inside its archive, like "_WORK/DATA/ANIMS/HUMANS-S_RUN.MAN"
+		 */
+		std::string getFilePath(const FileInfo& inf) const;
+
+		/**
+		 * @brief Fills a vector with the data of the given file.
+		 *		  Safe to call from multiple threads, as long as the index isn't modified at the same time.
 		 */
 		bool getFileData(const FileInfo& inf, std::vector<uint8_t>& data) const;
-		bool getFileData(const std::string& file, std::vector<uint8_t>& data) const;
+		bool getFileData(std::string_view file, std::vector<uint8_t>& data) const;
+
+		/**
+		 * @brief Extracts multiple files at once. The requests are sorted by archive and offset before reading,
+		 *		  so each archive is read front to back. data[i] will hold the contents of names[i].
+		 *		  Safe to call from multiple threads, so a batch can be split up between workers.
+		 * @return False, if any of the files could not be found or read
+		 */
+		bool getFileDataMany(const std::vector<std::string>& names, std::vector<std::vector<uint8_t>>& data) const;
+
+		/**
+		 * @brief Fills the view with a pointer into the mapped archive holding the given file, without copying anything.
+		 *		  If the archive is not memory mapped and storage is given, the file gets extracted into storage
+		 *		  and the view points there instead.
+		 * @return False, if the file was not found or could not be viewed
+		 */
+		bool getFileView(const FileInfo& inf, FileView& view, std::vector<uint8_t>* storage = nullptr) const;
+		bool getFileView(std::string_view file, FileView& view, std::vector<uint8_t>* storage = nullptr) const;
+
+		/**
+		 * @brief Same as getFileView, but doesn't count as request of the file and doesn't go into the access-trace.
+		 *		  For looking into files ahead of their actual use. The archive still counts what it had to read.
+		 */
+		bool peekFileView(const FileInfo& inf, FileView& view, std::vector<uint8_t>* storage = nullptr) const;
+
+		/**
+		 * @brief Reads up to length bytes of the given file, starting at offset. Doesn't touch the rest of the file,
+		 *		  so headers can be inspected without extracting everything. data is shorter than length if the file ends before.
+		 * @return False, if the file was not found, offset is past its end or reading failed
+		 */
+		bool readRange(const FileInfo& inf, uint32_t offset, uint32_t length, std::vector<uint8_t>& data) const;
+		bool readRange(std::string_view file, uint32_t offset, uint32_t length, std::vector<uint8_t>& data) const;
+
+		/**
+		 * @brief Reads exactly length bytes of the given file, starting at offset, into target
+		 * @return False, if the range is not completely inside the file or reading failed
+		 */
+		bool readRange(const FileInfo& inf, uint32_t offset, uint32_t length, uint8_t* target) const;
+
+		/**
+		 * @brief Returns the data of the given file as shared, immutable buffer. With the file-cache enabled,
+		 *		  repeated requests for the same file are served from memory, and concurrent requests only read it once.
+		 * @return nullptr, if the file was not found or could not be read
+		 */
+		SharedFileData getSharedFileData(const FileInfo& inf) const;
+		SharedFileData getSharedFileData(std::string_view file) const;
+
+		/**
+		 * @brief Warms the given file, so a following request doesn't have to wait for the disk. With the file-cache
+		 *		  enabled, the file is read into it. Otherwise the OS is only hinted to read it in the background.
+		 */
+		void prefetchFile(const FileInfo& inf) const;
+
+		/**
+		 * @brief Keeps up to the given number of bytes of recently requested files in memory. getFileData and the
+		 *		  copying fallback of getFileView are served from there as well. 0 disables the cache, which is the default.
+		 */
+		void setFileCacheBudget(size_t bytes);
+
+		/**
+		 * @brief Returns the hit-, miss- and eviction-counters of the file-cache
+		 */
+		FileCache::Stats getFileCacheStats() const { return m_FileCache.getStats(); }
+
+		/**
+		 * @brief Starts recording the order in which files are requested through getFileData, getFileDataMany and getFileView.
+		 *		  Each file is only recorded the first time it is requested. Clears any previous trace.
+		 */
+		void startAccessTrace();
+
+		/**
+		 * @brief Stops recording file requests. The trace is kept until the next call to startAccessTrace.
+		 */
+		void stopAccessTrace();
+
+		/**
+		 * @brief Returns the names of all files requested while tracing, in order
+		 */
+		std::vector<std::string> getAccessTrace() const;
+
+		/**
+		 * @brief Writes the access-trace to the given text-file, one file name per line
+		 */
+		bool saveAccessTrace(const std::string& file) const;
+
+		/**
+		 * @brief Reads an access-trace written by saveAccessTrace
+		 */
+		static bool loadAccessTrace(const std::string& file, std::vector<std::string>& names);
+
+		/**
+		 * @brief Returns the I/O counters of every loaded archive, along with the path it was loaded from
+		 */
+		std::vector<std::pair<std::string, ArchiveIoStats>> getArchiveIoStats() const;
+
+		/**
+		 * @brief Enables counting the requests of each file, see getMostRequestedFiles. Off by default, since
+		 *		  every request has to take a lock then.
+		 */
+		void setRequestStatsEnabled(bool enabled);
+
+		/**
+		 * @brief Returns up to n of the files requested most often through getFileData, getFileDataMany,
+		 *		  getFileView, getSharedFileData, readRange and FileReader::open, while request-stats were enabled.
+		 *		  Sorted by number of requests, most requested first.
+		 */
+		std::vector<FileRequestStats> getMostRequestedFiles(size_t n) const;
+
+		/**
+		 * @brief Returns up to n of the largest files requested so far, largest first
+		 */
+		std::vector<FileRequestStats> getLargestRequestedFiles(size_t n) const;
+
+		/**
+		 * @brief Returns the I/O counters of all archives, the counters of the file-cache and the top n files
+		 *		  of getMostRequestedFiles and getLargestRequestedFiles as JSON-object
+		 */
+		std::string getIoStatsJson(size_t n = 20) const;
+
+		/**
+		 * @brief Writes getIoStatsJson to the given file
+		 */
+		bool saveIoStats(const std::string& file, size_t n = 20) const;
+
+		/**
+		 * @brief Resets the I/O counters of all archives and the per-file request counters
+		 */
+		void resetIoStats();
 
 		/**
 		 * @brief Clears the complete index and all registered files
@@ -67,27 +275,187 @@ namespace VDFS
 		/**
 		 * @brief Returnst the list of all known files
 		 */
-		const std::vector<FileInfo>& getKnownFiles(){return m_KnownFiles;}
+		const std::vector<FileInfo>& getKnownFiles() const {return m_KnownFiles;}
 
 	private:
+		/**
+		 * @brief Name of a known file, stored case-folded inside the name arena
+		 */
+		struct IndexedName
+		{
+			uint32_t arenaOffset;
+			uint32_t length;
+			uint32_t hash;
+		};
+
+		/**
+		 * @brief Node of the directory tree. Index 0 is the root.
+		 */
+		struct Directory
+		{
+			uint32_t parent;
+			std::string name;
+			std::string foldedName;
+			std::vector<uint32_t> children;
+		};
+
+		/**
+		 * @brief Returns the id of the given directory, creating it and its parents if needed
+		 */
+		uint32_t getDirectoryId(std::string_view path);
+
+		/**
+		 * @brief Returns the id of the given directory, or -1 if it doesn't exist
+		 */
+		uint32_t findDirectory(std::string_view path) const;
+
+		/**
+		 * @brief Returns the full path of the given directory
+		 */
+		std::string getDirectoryPath(uint32_t directory) const;
+
+		/**
+		 * @brief Returns the case-folded name of the file at the given index of m_KnownFiles
+		 */
+		std::string_view getFoldedName(size_t fileIdx) const;
+
+		/**
+		 * @brief Rebuilds the sorted indices used by the queries, if the index was modified since the last query.
+		 *		  m_QueryMutex must be locked.
+		 */
+		void updateQueryIndex() const;
+
+		/**
+		 * @brief Returns the index of the given file in m_KnownFiles, or -1 if it isn't known
+		 */
+		size_t findFileIndex(std::string_view name) const;
+
+		/**
+		 * @brief Puts the file at the given index of m_KnownFiles into the hash-table
+		 */
+		void insertIntoHashTable(size_t fileIdx);
+
+		/**
+		 * @brief Same as the public loadVDFs, but also fills loaded[i] with the archive that was newly loaded
+		 *		  from archives[i], or nullptr if it failed or was already loaded
+		 */
+		bool loadVDFs(const std::vector<std::string>& archives, uint32_t priority, bool memoryMapped, std::vector<Archive*>& loaded);
+
+		/**
+		 * @brief Opens the given archive-file, depending on its type either as ArchiveVirtual or ArchiveCompressed
+		 * @param readCatalog Whether the catalog has to be read right away. Otherwise it is read on demand, if possible.
+		 * @return nullptr, if loading failed
+		 */
+		static Archive* openArchiveFile(const std::string& file, uint32_t priority, bool memoryMapped, bool readCatalog);
+
+		/**
+		 * @brief Counts a request for bytes of the given file and puts it into the access-trace,
+		 *		  if tracing is enabled and it wasn't requested before
+		 */
+		void recordAccess(const FileInfo& inf, uint64_t bytes) const;
+
+		/**
+		 * @brief Same as getFileData and getSharedFileData, without counting the request. For the public
+		 *		  functions going through each other, so every request is counted once.
+		 */
+		bool readFileData(const FileInfo& inf, std::vector<uint8_t>& data) const;
+		SharedFileData readSharedFileData(const FileInfo& inf) const;
+
+		/**
+		 * @brief Same as readRange, without counting the request
+		 */
+		bool readRangeData(const FileInfo& inf, uint32_t offset, uint32_t length, uint8_t* target) const;
+
+		/**
+		 * @brief Returns the request counters of all files which were requested at least once
+		 */
+		std::vector<FileRequestStats> getRequestedFiles() const;
+
+		/**
+		 * @brief Tries to initialize the empty index from the given cache-file
+		 * @return False, if the cache is missing, broken or outdated. The index stays empty then.
+		 */
+		bool readIndexCache(const std::vector<std::string>& archives, const std::string& cacheFile, uint32_t priority, bool memoryMapped);
+
+		/**
+		 * @brief Writes the current index to the given cache-file. loaded[i] holds the archive loaded from archives[i],
+		 *		  or nullptr if that failed.
+		 */
+		bool writeIndexCache(const std::vector<std::string>& archives, const std::vector<Archive*>& loaded, const std::string& cacheFile, uint32_t priority) const;
+
 		/**
 		 * @brief Vector of all known files
 		 */
 		std::vector<FileInfo> m_KnownFiles;
 
 		/**
-		 * @brief Map of indices of m_KnownFiles by their filenames 
+		 * @brief Interned, case-folded names of m_KnownFiles. Same order as m_KnownFiles.
+		 */
+		std::vector<IndexedName> m_IndexedNames;
+		std::vector<char> m_NameArena;
+
+		/**
+		 * @brief Directory tree, and the directory of each file in m_KnownFiles
+		 */
+		std::vector<Directory> m_Directories;
+		std::vector<uint32_t> m_FileDirectories;
+
+		/**
+		 * @brief Indices into m_KnownFiles, sorted by name, by extension and name and by directory and name.
+		 *		  Built on the first query after the index was modified.
+		 */
+		mutable std::mutex m_QueryMutex;
+		mutable bool m_QueryIndexDirty;
+		mutable std::vector<uint32_t> m_SortedByName;
+		mutable std::vector<uint32_t> m_SortedByExtension;
+		mutable std::vector<std::vector<uint32_t>> m_DirectoryFiles;
+
+		/**
+		 * @brief Open addressing hash-table of (index into m_KnownFiles + 1). 0 marks an empty slot.
+		 *		  Size is always a power of two.
+		 */
+		std::vector<uint32_t> m_HashSlots;
+
+		/**
+		 * @brief all currently loaded virtual archives, compressed or not
 		 */
-		std::unordered_map<std::string, size_t> m_FileIndicesByName;
+		std::vector<Archive*> m_LoadedVirtualArchives;
 
 		/**
-		 * @brief all currently loaded virtual archives
+		 * @brief all currently loaded directories of loose files
 		 */
-		std::vector<ArchiveVirtual*> m_LoadedVirtualArchives;
+		std::vector<ArchivePhysical*> m_LoadedPhysicalArchives;
 
 		/** 
 		 * @brief set of all loaded archives
 		 */
 		std::set<std::string> m_LoadedArchives;
+
+		/**
+		 * @brief Recently used file-data, see setFileCacheBudget
+		 */
+		mutable FileCache m_FileCache;
+
+		/**
+		 * @brief Recorded file requests, see startAccessTrace. m_TracedFiles holds the upper-case names already in the trace.
+		 */
+		std::atomic<bool> m_TraceEnabled;
+		mutable std::mutex m_TraceMutex;
+		mutable std::vector<std::string> m_AccessTrace;
+		mutable std::set<std::string> m_TracedFiles;
+
+		/**
+		 * @brief Request counters of each file, same order as m_KnownFiles. Grown on demand.
+		 *		  Only filled while m_RequestStatsEnabled is set.
+		 */
+		struct FileRequestCounter
+		{
+			uint64_t numRequests;
+			uint64_t bytesRequested;
+		};
+
+		std::atomic<bool> m_RequestStatsEnabled;
+		mutable std::mutex m_RequestMutex;
+		mutable std::vector<FileRequestCounter> m_FileRequests;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "filePrefetcher.h"
+#include "fileIndex.h"
+
+using namespace VDFS;
+
+FilePrefetcher::FilePrefetcher(const FileIndex& index) :
+	m_Index(index),
+	m_Busy(false),
+	m_Stop(false),
+	m_NumPrefetched(0)
+{
+}
+
+/**
+ * @brief Drops everything not warmed yet and stops the background thread
+ */
+FilePrefetcher::~FilePrefetcher()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		m_Queue.clear();
+		m_Stop = true;
+	}
+
+	m_QueueChanged.notify_all();
+
+	if(m_Thread.joinable())
+		m_Thread.join();
+}
+
+/**
+ * @brief Queues the given files
+ */
+void FilePrefetcher::prefetch(const std::vector<std::string>& names)
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		m_Queue.insert(m_Queue.end(), names.begin(), names.end());
+
+		if(!m_Thread.joinable())
+			m_Thread = std::thread(&FilePrefetcher::run, this);
+	}
+
+	m_QueueChanged.notify_all();
+}
+
+/**
+ * @brief Blocks until everything queued so far was warmed
+ */
+void FilePrefetcher::wait()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_QueueChanged.wait(lock, [this]() { return m_Queue.empty() && !m_Busy; });
+}
+
+/**
+ * @brief Drops everything not warmed yet
+ */
+void FilePrefetcher::cancel()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		m_Queue.clear();
+	}
+
+	m_QueueChanged.notify_all();
+}
+
+/**
+ * @brief Background thread, warming one queued file after another
+ */
+void FilePrefetcher::run()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while(true)
+	{
+		m_QueueChanged.wait(lock, [this]() { return m_Stop || !m_Queue.empty(); });
+		if(m_Stop)
+			return;
+
+		std::string name = std::move(m_Queue.front());
+		m_Queue.pop_front();
+		m_Busy = true;
+
+		// Let others queue or cancel while we wait for the disk
+		lock.unlock();
+
+		const FileInfo* inf = m_Index.findFile(name);
+		if(inf)
+		{
+			m_Index.prefetchFile(*inf);
+			m_NumPrefetched.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		lock.lock();
+		m_Busy = false;
+
+		// Someone might be waiting for the queue to run dry
+		if(m_Queue.empty())
+			m_QueueChanged.notify_all();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace VDFS
+{
+	class FileIndex;
+
+	/**
+	 * @brief Warms files of an index on a background thread, using FileIndex::prefetchFile, so the disk can work
+	 *		  while the caller is busy with something else. Files are warmed in the order they were queued.
+	 *		  The index must not be modified while the prefetcher is running.
+	 */
+	class FilePrefetcher
+	{
+	public:
+		FilePrefetcher(const FileIndex& index);
+
+		/**
+		 * @brief Drops everything not warmed yet and stops the background thread
+		 */
+		~FilePrefetcher();
+
+		/**
+		 * @brief Queues the given files. Unknown names are skipped. Starts the background thread, if it isn't running yet.
+		 */
+		void prefetch(const std::vector<std::string>& names);
+
+		/**
+		 * @brief Blocks until everything queued so far was warmed
+		 */
+		void wait();
+
+		/**
+		 * @brief Drops everything not warmed yet
+		 */
+		void cancel();
+
+		/**
+		 * @brief Number of files warmed so far
+		 */
+		size_t getNumPrefetched() const { return m_NumPrefetched.load(std::memory_order_relaxed); }
+
+	private:
+		FilePrefetcher(const FilePrefetcher&) = delete;
+		FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+		/**
+		 * @brief Background thread, warming one queued file after another
+		 */
+		void run();
+
+		const FileIndex& m_Index;
+
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_QueueChanged;
+		std::deque<std::string> m_Queue;
+		bool m_Busy;
+		bool m_Stop;
+
+		std::atomic<size_t> m_NumPrefetched;
+	};
+}
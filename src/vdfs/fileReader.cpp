@@ -0,0 +1,136 @@
+#include "fileReader.h"
+#include "utils/logger.h"
+#include <string.h>
+#include <algorithm>
+
+using namespace VDFS;
+
+FileReader::FileReader() :
+	m_pIndex(nullptr),
+	m_View(),
+	m_HasView(false),
+	m_BufferStart(0),
+	m_BufferFill(0),
+	m_BufferSize(0),
+	m_Position(0),
+	m_Error(false)
+{
+	m_File.fileSize = 0;
+	m_File.targetArchive = nullptr;
+	m_File.archiveOffset = 0;
+	m_File.priority = 0;
+}
+
+/**
+ * @brief Opens the given file of the index
+ */
+bool FileReader::open(const FileIndex& index, std::string_view file, uint32_t bufferSize)
+{
+	const FileInfo* inf = index.findFile(file);
+	if(!inf)
+	{
+		LogError() << "File not found: " << file;
+		return false;
+	}
+
+	return open(index, *inf, bufferSize);
+}
+
+bool FileReader::open(const FileIndex& index, const FileInfo& inf, uint32_t bufferSize)
+{
+	m_pIndex = &index;
+	m_File = inf;
+	m_Position = 0;
+	m_Error = false;
+	m_BufferStart = 0;
+	m_BufferFill = 0;
+	m_BufferSize = std::max<uint32_t>(bufferSize, 1);
+	m_Buffer.clear();
+
+	// Mapped archives can be read from directly
+	m_HasView = index.peekFileView(inf, m_View) && m_View.size == inf.fileSize;
+
+	// Counted once here, however the file gets read later
+	index.recordAccess(inf, inf.fileSize);
+
+	return true;
+}
+
+/**
+ * @brief Reads up to size bytes at the current position and moves past them
+ */
+size_t FileReader::read(void* target, size_t size)
+{
+	if(!m_pIndex || m_Error)
+		return 0;
+
+	size = std::min(size, static_cast<size_t>(getSize() - m_Position));
+	if(size == 0)
+		return 0;
+
+	uint8_t* out = reinterpret_cast<uint8_t*>(target);
+
+	if(m_HasView)
+	{
+		memcpy(out, m_View.data + m_Position, size);
+		m_Position += static_cast<uint32_t>(size);
+		return size;
+	}
+
+	size_t done = 0;
+	while(done < size)
+	{
+		// Serve what we can from the buffer
+		if(m_Position >= m_BufferStart && m_Position < m_BufferStart + m_BufferFill)
+		{
+			size_t n = std::min(size - done, static_cast<size_t>(m_BufferStart + m_BufferFill - m_Position));
+			memcpy(out + done, m_Buffer.data() + (m_Position - m_BufferStart), n);
+
+			done += n;
+			m_Position += static_cast<uint32_t>(n);
+			continue;
+		}
+
+		// Large reads go straight to the target, no point in copying them twice
+		size_t left = size - done;
+		if(left >= m_BufferSize)
+		{
+			if(!m_pIndex->readRangeData(m_File, m_Position, static_cast<uint32_t>(left), out + done))
+			{
+				m_Error = true;
+				break;
+			}
+
+			done += left;
+			m_Position += static_cast<uint32_t>(left);
+			continue;
+		}
+
+		// Refill the buffer at the current position
+		m_Buffer.resize(m_BufferSize);
+		m_BufferStart = m_Position;
+		m_BufferFill = std::min(m_BufferSize, getSize() - m_Position);
+
+		if(!m_pIndex->readRangeData(m_File, m_BufferStart, m_BufferFill, m_Buffer.data()))
+		{
+			m_BufferFill = 0;
+			m_Error = true;
+			break;
+		}
+	}
+
+	return done;
+}
+
+/**
+ * @brief Moves to the given position inside the file
+ */
+bool FileReader::seek(uint32_t position)
+{
+	if(!m_pIndex || position > getSize())
+		return false;
+
+	// The buffer stays, seeking back into it is free
+	m_Position = position;
+	return true;
+}
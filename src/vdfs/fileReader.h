@@ -0,0 +1,101 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "fileIndex.h"
+
+namespace VDFS
+{
+	const uint32_t FILE_READER_DEFAULT_BUFFER_SIZE = 16 * 1024;
+
+	/**
+	 * @brief Reads a file of the index front to back, without extracting it as a whole. Files inside mapped
+	 *		  archives are read straight from the mapping, others through a small buffer refilled on demand.
+	 *		  The index has to stay unmodified while the reader is open.
+	 */
+	class FileReader
+	{
+	public:
+		FileReader();
+
+		/**
+		 * @brief Opens the given file of the index
+		 * @param bufferSize Number of bytes to read ahead, if the file can't be read from a mapping
+		 * @return False, if the file was not found
+		 */
+		bool open(const FileIndex& index, std::string_view file, uint32_t bufferSize = FILE_READER_DEFAULT_BUFFER_SIZE);
+		bool open(const FileIndex& index, const FileInfo& inf, uint32_t bufferSize = FILE_READER_DEFAULT_BUFFER_SIZE);
+
+		/**
+		 * @brief Reads up to size bytes at the current position and moves past them
+		 * @return Number of bytes read. Less than size at the end of the file, or if reading failed.
+		 */
+		size_t read(void* target, size_t size);
+
+		/**
+		 * @brief Reads exactly size bytes, like read
+		 * @return False, if the file ended before or reading failed
+		 */
+		bool readExact(void* target, size_t size) { return read(target, size) == size; }
+
+		/**
+		 * @brief Moves to the given position inside the file
+		 * @return False, if the position is past the end of the file
+		 */
+		bool seek(uint32_t position);
+
+		/**
+		 * @brief Skips the given number of bytes, without reading them
+		 */
+		bool skip(uint32_t bytes) { return bytes <= getSize() - m_Position && seek(m_Position + bytes); }
+
+		/**
+		 * @brief Current position inside the file
+		 */
+		uint32_t tell() const { return m_Position; }
+
+		/**
+		 * @brief Size of the opened file
+		 */
+		uint32_t getSize() const { return m_pIndex ? m_File.fileSize : 0; }
+
+		/**
+		 * @brief Returns whether the position is at the end of the file
+		 */
+		bool eof() const { return m_Position >= getSize(); }
+
+		/**
+		 * @brief Returns whether reading failed at some point
+		 */
+		bool hasError() const { return m_Error; }
+
+		/**
+		 * @brief Information about the opened file
+		 */
+		const FileInfo& getFileInfo() const { return m_File; }
+
+	private:
+		/**
+		 * @brief Index the file is read from, nullptr if nothing is open
+		 */
+		const FileIndex* m_pIndex;
+		FileInfo m_File;
+
+		/**
+		 * @brief Set if the file could be viewed directly, no buffering needed then
+		 */
+		FileView m_View;
+		bool m_HasView;
+
+		/**
+		 * @brief Read-ahead buffer, holding the file-data starting at m_BufferStart
+		 */
+		std::vector<uint8_t> m_Buffer;
+		uint32_t m_BufferStart;
+		uint32_t m_BufferFill;
+		uint32_t m_BufferSize;
+
+		uint32_t m_Position;
+		bool m_Error;
+	};
+}
@@ -0,0 +1,329 @@
+#include "fileIndex.h"
+#include "utils/logger.h"
+#include "utils/system.h"
+#include "archive_virtual.h"
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+
+/**
+ * Quick format rundown of the index-cache:
+ *
+ * The file starts with an IndexCacheHeader. It is followed by one IndexCacheArchive for each requested archive,
+ * each one directly followed by its path (not null-terminated). After that, numFiles IndexCacheFile-entries
+ * describe the merged index in the order it was built, referencing the archives by their position in the list.
+ * The paths of the files are stored in one blob at the end of the file, so the directories can be restored as well.
+ *
+ * The cache is only valid if the requested list of archives matches the stored one exactly, including
+ * size and modification time of each archive. Otherwise, everything is loaded from the archives again.
+ *
+ * A valid cache saves reading the catalogs of the archives, not building the index: Its entries still go through
+ * addFile, in the stored order, so the result is the same as loading the archives one by one.
+ */
+
+using namespace VDFS;
+
+namespace
+{
+	const uint32_t INDEX_CACHE_MAGIC = 0x58444E49; // "INDX"
+	const uint32_t INDEX_CACHE_VERSION = 2;
+
+	enum EIndexCacheArchiveFlags
+	{
+		IC_ARCHIVE_EXISTS = 1,
+		IC_ARCHIVE_LOADED = 2,
+	};
+
+#pragma pack(push, 1)
+	struct IndexCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numArchives;
+		uint32_t numFiles;
+		uint32_t pathBlobSize;
+	};
+
+	struct IndexCacheArchive
+	{
+		uint64_t size;
+		uint64_t mtime;
+		uint32_t priority;
+		uint32_t flags;
+		uint32_t pathLength;
+	};
+
+	struct IndexCacheFile
+	{
+		uint32_t archive;
+		uint32_t archiveOffset;
+		uint32_t fileSize;
+		uint32_t priority;
+		uint32_t pathOffset;
+		uint32_t pathLength;
+		uint32_t nameLength; // The name is the end of the path
+	};
+#pragma pack(pop)
+
+	/**
+	 * @brief State of an archive on disk, as stored in the cache
+	 */
+	IndexCacheArchive getArchiveState(const std::string& path, uint32_t priority)
+	{
+		IndexCacheArchive a = {};
+		a.priority = priority;
+		a.pathLength = static_cast<uint32_t>(path.size());
+
+		if(Utils::System::getFileStats(path.c_str(), a.size, a.mtime))
+			a.flags |= IC_ARCHIVE_EXISTS;
+
+		return a;
+	}
+}
+
+/**
+* @brief Loads the given archives, using the index-cache if it is still up to date
+*/
+bool FileIndex::loadVDFsCached(const std::vector<std::string>& archives, const std::string& cacheFile, uint32_t priority, bool memoryMapped)
+{
+	// The cache describes the complete index, so it can only be used for an empty one
+	if(!m_KnownFiles.empty() || !m_LoadedVirtualArchives.empty() || !m_LoadedPhysicalArchives.empty())
+		return loadVDFs(archives, priority, memoryMapped);
+
+	if(readIndexCache(archives, cacheFile, priority, memoryMapped))
+	{
+		LogInfo() << "Loaded VDFS-Index from cache: " << cacheFile;
+
+		// Report archives which couldn't be loaded when the cache was written, same as without it
+		bool allLoaded = true;
+		for(const std::string& a : archives)
+		{
+			std::string upper = a;
+			std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+			allLoaded = allLoaded && m_LoadedArchives.find(upper) != m_LoadedArchives.end();
+		}
+
+		return allLoaded;
+	}
+
+	// Cache is missing or outdated, read everything from the archives
+	clearIndex();
+
+	std::vector<Archive*> loaded;
+	bool allLoaded = loadVDFs(archives, priority, memoryMapped, loaded);
+
+	if(!writeIndexCache(archives, loaded, cacheFile, priority))
+		LogWarn() << "Failed to write VDFS-Index cache: " << cacheFile;
+
+	return allLoaded;
+}
+
+/**
+* @brief Tries to initialize the index from the given cache-file
+*/
+bool FileIndex::readIndexCache(const std::vector<std::string>& archives, const std::string& cacheFile, uint32_t priority, bool memoryMapped)
+{
+	size_t size = 0;
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(Utils::System::mapFile(cacheFile.c_str(), size));
+	if(!data)
+		return false;
+
+	// Unmaps the cache on every way out of here
+	struct MappedCache
+	{
+		const uint8_t* data;
+		size_t size;
+		~MappedCache(){ Utils::System::unmapFile(data, size); }
+	} mapped = { data, size };
+
+	size_t pos = 0;
+	auto read = [&](void* target, size_t n) {
+		if(n > size - pos)
+			return false;
+
+		memcpy(target, data + pos, n);
+		pos += n;
+		return true;
+	};
+
+	IndexCacheHeader header;
+	if(!read(&header, sizeof(header))
+		|| header.magic != INDEX_CACHE_MAGIC
+		|| header.version != INDEX_CACHE_VERSION
+		|| header.numArchives != archives.size())
+		return false;
+
+	// Check that all archives are still the same as when the cache was written
+	std::vector<uint32_t> flags(archives.size());
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		IndexCacheArchive stored;
+		if(!read(&stored, sizeof(stored)) || stored.pathLength > size - pos)
+			return false;
+
+		IndexCacheArchive current = getArchiveState(archives[i], priority);
+		if(archives[i].size() != stored.pathLength
+			|| memcmp(archives[i].data(), data + pos, stored.pathLength) != 0
+			|| current.priority != stored.priority
+			|| current.size != stored.size
+			|| current.mtime != stored.mtime
+			|| current.flags != (stored.flags & IC_ARCHIVE_EXISTS))
+			return false;
+
+		pos += stored.pathLength;
+		flags[i] = stored.flags;
+	}
+
+	size_t filesStart = pos;
+	if(header.numFiles > (size - filesStart) / sizeof(IndexCacheFile))
+		return false;
+
+	size_t pathsStart = filesStart + header.numFiles * sizeof(IndexCacheFile);
+	if(header.pathBlobSize > size - pathsStart)
+		return false;
+
+	// Open the archives, but leave their catalogs alone
+	std::vector<Archive*> opened(archives.size(), nullptr);
+	auto closeAll = [&](){
+		for(Archive* a : opened)
+			delete a;
+	};
+
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		if(!(flags[i] & IC_ARCHIVE_LOADED))
+			continue;
+
+		opened[i] = openArchiveFile(archives[i], priority, memoryMapped, false);
+		if(!opened[i])
+		{
+			closeAll();
+			return false;
+		}
+	}
+
+	// Put the merged list back into the index, in the order it was built
+	m_KnownFiles.reserve(header.numFiles);
+	m_IndexedNames.reserve(header.numFiles);
+	m_FileDirectories.reserve(header.numFiles);
+
+	const char* paths = reinterpret_cast<const char*>(data + pathsStart);
+	for(uint32_t i = 0; i < header.numFiles; i++)
+	{
+		IndexCacheFile f;
+		memcpy(&f, data + filesStart + i * sizeof(IndexCacheFile), sizeof(f));
+
+		if(f.archive >= opened.size() || !opened[f.archive]
+			|| f.pathOffset > header.pathBlobSize || f.pathLength > header.pathBlobSize - f.pathOffset
+			|| f.nameLength > f.pathLength)
+		{
+			clearIndex();
+			closeAll();
+			return false;
+		}
+
+		std::string_view path(paths + f.pathOffset, f.pathLength);
+
+		FileInfo inf;
+		inf.fileName = std::string(path.substr(f.pathLength - f.nameLength));
+		inf.fileSize = f.fileSize;
+		inf.targetArchive = opened[f.archive];
+		inf.archiveOffset = f.archiveOffset;
+		inf.priority = f.priority;
+
+		addFile(inf, path.substr(0, f.pathLength - f.nameLength));
+	}
+
+	// Everything checked out, register the archives
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		if(!opened[i])
+			continue;
+
+		std::string upper = archives[i];
+		std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+		m_LoadedVirtualArchives.emplace_back(opened[i]);
+		m_LoadedArchives.insert(upper);
+	}
+
+	return true;
+}
+
+/**
+* @brief Writes the current index to the given cache-file
+*/
+bool FileIndex::writeIndexCache(const std::vector<std::string>& archives, const std::vector<Archive*>& loaded, const std::string& cacheFile, uint32_t priority) const
+{
+	IndexCacheHeader header;
+	header.magic = INDEX_CACHE_MAGIC;
+	header.version = INDEX_CACHE_VERSION;
+	header.numArchives = static_cast<uint32_t>(archives.size());
+	header.numFiles = static_cast<uint32_t>(m_KnownFiles.size());
+	header.pathBlobSize = 0;
+
+	std::vector<IndexCacheFile> files;
+	std::string pathBlob;
+	files.reserve(m_KnownFiles.size());
+	for(const FileInfo& inf : m_KnownFiles)
+	{
+		IndexCacheFile f;
+		auto it = std::find(loaded.begin(), loaded.end(), inf.targetArchive);
+		if(it == loaded.end())
+			return false; // File from somewhere else, can't describe that
+
+		f.archive = static_cast<uint32_t>(it - loaded.begin());
+		f.archiveOffset = inf.archiveOffset;
+		f.fileSize = inf.fileSize;
+		f.priority = inf.priority;
+
+		std::string path = getFilePath(inf);
+		f.pathOffset = static_cast<uint32_t>(pathBlob.size());
+		f.pathLength = static_cast<uint32_t>(path.size());
+		f.nameLength = static_cast<uint32_t>(inf.fileName.size());
+		pathBlob += path;
+
+		files.push_back(f);
+	}
+
+	header.pathBlobSize = static_cast<uint32_t>(pathBlob.size());
+
+	// Write to a temporary file first, so a crash never leaves a broken cache behind
+	std::string tmpFile = cacheFile + ".tmp";
+	FILE* f = fopen(tmpFile.c_str(), "wb");
+	if(!f)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	for(size_t i = 0; i < archives.size() && ok; i++)
+	{
+		IndexCacheArchive a = getArchiveState(archives[i], priority);
+		if(loaded[i])
+			a.flags |= IC_ARCHIVE_LOADED;
+
+		ok = fwrite(&a, sizeof(a), 1, f) == 1
+			&& fwrite(archives[i].data(), 1, archives[i].size(), f) == archives[i].size();
+	}
+
+	if(ok && !files.empty())
+		ok = fwrite(files.data(), sizeof(IndexCacheFile), files.size(), f) == files.size();
+
+	if(ok && !pathBlob.empty())
+		ok = fwrite(pathBlob.data(), 1, pathBlob.size(), f) == pathBlob.size();
+
+	ok = fclose(f) == 0 && ok;
+
+	if(ok)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		// Rename doesn't replace existing files here
+		remove(cacheFile.c_str());
+#endif
+		ok = rename(tmpFile.c_str(), cacheFile.c_str()) == 0;
+	}
+
+	if(!ok)
+		remove(tmpFile.c_str());
+
+	return ok;
+}
@@ -0,0 +1,234 @@
+#include "fileIndex.h"
+#include "utils/logger.h"
+#include <stdio.h>
+#include <algorithm>
+
+/**
+ * I/O statistics of the index. Every archive counts its own reads and views (see Archive::getIoStats), while the
+ * index counts how often each file was requested through it, once enabled by setRequestStatsEnabled. A file served
+ * from the file-cache counts as request, but doesn't show up in the counters of its archive.
+ */
+
+using namespace VDFS;
+
+namespace
+{
+	/**
+	 * @brief Appends the given string as quoted JSON-string
+	 */
+	void appendJsonString(std::string& out, const std::string& s)
+	{
+		out += '"';
+		for(char c : s)
+		{
+			switch(c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if(static_cast<uint8_t>(c) < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+					out += buf;
+				}
+				else
+				{
+					out += c;
+				}
+			}
+		}
+		out += '"';
+	}
+
+	void appendJsonField(std::string& out, const char* name, uint64_t value, bool last = false)
+	{
+		out += '"';
+		out += name;
+		out += "\": ";
+		out += std::to_string(value);
+		out += last ? "" : ", ";
+	}
+
+	void appendFileList(std::string& out, const char* name, const std::vector<FileRequestStats>& files)
+	{
+		out += "\t\"";
+		out += name;
+		out += "\": [";
+		for(size_t i = 0; i < files.size(); i++)
+		{
+			out += i ? ",\n\t\t{" : "\n\t\t{";
+			out += "\"name\": ";
+			appendJsonString(out, files[i].fileName);
+			out += ", ";
+			appendJsonField(out, "size", files[i].fileSize);
+			appendJsonField(out, "requests", files[i].numRequests);
+			appendJsonField(out, "bytesRequested", files[i].bytesRequested, true);
+			out += "}";
+		}
+		out += files.empty() ? "]" : "\n\t]";
+	}
+}
+
+/**
+* @brief Returns the I/O counters of every loaded archive
+*/
+std::vector<std::pair<std::string, ArchiveIoStats>> FileIndex::getArchiveIoStats() const
+{
+	std::vector<std::pair<std::string, ArchiveIoStats>> stats;
+	for(const Archive* a : m_LoadedVirtualArchives)
+		stats.emplace_back(a->getFilePath(), a->getIoStats());
+
+	for(const Archive* a : m_LoadedPhysicalArchives)
+		stats.emplace_back(a->getFilePath(), a->getIoStats());
+
+	return stats;
+}
+
+/**
+* @brief Enables counting the requests of each file
+*/
+void FileIndex::setRequestStatsEnabled(bool enabled)
+{
+	m_RequestStatsEnabled = enabled;
+}
+
+/**
+* @brief Returns the request counters of all files which were requested at least once
+*/
+std::vector<FileRequestStats> FileIndex::getRequestedFiles() const
+{
+	std::vector<FileRequestStats> files;
+
+	std::lock_guard<std::mutex> guard(m_RequestMutex);
+	for(size_t i = 0; i < m_FileRequests.size() && i < m_KnownFiles.size(); i++)
+	{
+		if(!m_FileRequests[i].numRequests)
+			continue;
+
+		files.push_back(FileRequestStats{m_KnownFiles[i].fileName, m_KnownFiles[i].fileSize, m_FileRequests[i].numRequests, m_FileRequests[i].bytesRequested});
+	}
+
+	return files;
+}
+
+/**
+* @brief Returns up to n of the files requested most often
+*/
+std::vector<FileRequestStats> FileIndex::getMostRequestedFiles(size_t n) const
+{
+	std::vector<FileRequestStats> files = getRequestedFiles();
+
+	n = std::min(n, files.size());
+	std::partial_sort(files.begin(), files.begin() + n, files.end(), [](const FileRequestStats& a, const FileRequestStats& b) {
+		if(a.numRequests != b.numRequests)
+			return a.numRequests > b.numRequests;
+
+		return a.bytesRequested > b.bytesRequested;
+	});
+
+	files.resize(n);
+	return files;
+}
+
+/**
+* @brief Returns up to n of the largest files requested so far
+*/
+std::vector<FileRequestStats> FileIndex::getLargestRequestedFiles(size_t n) const
+{
+	std::vector<FileRequestStats> files = getRequestedFiles();
+
+	n = std::min(n, files.size());
+	std::partial_sort(files.begin(), files.begin() + n, files.end(), [](const FileRequestStats& a, const FileRequestStats& b) {
+		if(a.fileSize != b.fileSize)
+			return a.fileSize > b.fileSize;
+
+		return a.numRequests > b.numRequests;
+	});
+
+	files.resize(n);
+	return files;
+}
+
+/**
+* @brief Returns all I/O counters as JSON-object
+*/
+std::string FileIndex::getIoStatsJson(size_t n) const
+{
+	std::vector<std::pair<std::string, ArchiveIoStats>> archives = getArchiveIoStats();
+
+	std::string out = "{\n\t\"archives\": [";
+	for(size_t i = 0; i < archives.size(); i++)
+	{
+		const ArchiveIoStats& s = archives[i].second;
+
+		out += i ? ",\n\t\t{" : "\n\t\t{";
+		out += "\"path\": ";
+		appendJsonString(out, archives[i].first);
+		out += ", ";
+		appendJsonField(out, "bytesRead", s.bytesRead);
+		appendJsonField(out, "reads", s.numReads);
+		appendJsonField(out, "seekDistance", s.seekDistance);
+		appendJsonField(out, "readMicroseconds", s.readNanoseconds / 1000);
+		appendJsonField(out, "mappedBytes", s.mappedBytes);
+		appendJsonField(out, "views", s.numViews, true);
+		out += "}";
+	}
+	out += archives.empty() ? "],\n" : "\n\t],\n";
+
+	FileCache::Stats cache = m_FileCache.getStats();
+	out += "\t\"fileCache\": {";
+	appendJsonField(out, "budget", m_FileCache.getBudget());
+	appendJsonField(out, "hits", cache.hits);
+	appendJsonField(out, "misses", cache.misses);
+	appendJsonField(out, "evictions", cache.evictions);
+	appendJsonField(out, "coalesced", cache.coalesced);
+	appendJsonField(out, "bytesCached", cache.bytesCached);
+	appendJsonField(out, "files", cache.numFiles, true);
+	out += "},\n";
+
+	appendFileList(out, "mostRequested", getMostRequestedFiles(n));
+	out += ",\n";
+	appendFileList(out, "largestRequested", getLargestRequestedFiles(n));
+	out += "\n}\n";
+
+	return out;
+}
+
+/**
+* @brief Writes getIoStatsJson to the given file
+*/
+bool FileIndex::saveIoStats(const std::string& file, size_t n) const
+{
+	std::string json = getIoStatsJson(n);
+
+	FILE* f = fopen(file.c_str(), "w");
+	if(!f)
+	{
+		LogError() << "Failed to open file for writing: " << file;
+		return false;
+	}
+
+	bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+	ok = fclose(f) == 0 && ok;
+
+	return ok;
+}
+
+/**
+* @brief Resets the I/O counters of all archives and the per-file request counters
+*/
+void FileIndex::resetIoStats()
+{
+	for(Archive* a : m_LoadedVirtualArchives)
+		a->resetIoStats();
+
+	for(Archive* a : m_LoadedPhysicalArchives)
+		a->resetIoStats();
+
+	std::lock_guard<std::mutex> guard(m_RequestMutex);
+	m_FileRequests.clear();
+}
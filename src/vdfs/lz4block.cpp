@@ -0,0 +1,234 @@
+#include "lz4block.h"
+#include <string.h>
+#include <vector>
+
+/**
+ * Quick format rundown:
+ *
+ * The data is a list of sequences. Each one starts with a token-byte, holding the number of literals in
+ * the high and the match-length minus 4 in the low 4 bits. A value of 15 means more length-bytes follow,
+ * which get added until one is not 255. After the literals come 2 bytes of backwards offset (little endian)
+ * and the extra match-length bytes. The last sequence only has literals.
+ *
+ * To stay compatible with the reference decoder, the last 5 bytes are always literals and no match may
+ * start within the last 12 bytes.
+ */
+
+using namespace VDFS;
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t LAST_LITERALS = 5;
+	const size_t MF_LIMIT = 12;
+	const size_t MAX_OFFSET = 65535;
+	const unsigned HASH_LOG = 14;
+
+	inline uint32_t read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline uint32_t hash4(uint32_t v)
+	{
+		return (v * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	/**
+	 * @brief Number of bytes needed to encode an extra length of len, after the 4 bits in the token
+	 */
+	inline size_t extraLengthBytes(size_t len)
+	{
+		return len >= 15 ? (len - 15) / 255 + 1 : 0;
+	}
+
+	inline uint8_t* writeExtraLength(uint8_t* op, size_t len)
+	{
+		if(len < 15)
+			return op;
+
+		len -= 15;
+		while(len >= 255)
+		{
+			*op++ = 255;
+			len -= 255;
+		}
+
+		*op++ = static_cast<uint8_t>(len);
+		return op;
+	}
+
+	/**
+	 * @brief Reads the additional bytes of a length-field
+	 */
+	inline bool readExtraLength(const uint8_t* src, size_t srcSize, size_t& ip, size_t& len)
+	{
+		uint8_t b;
+		do
+		{
+			if(ip >= srcSize)
+				return false;
+
+			b = src[ip++];
+			len += b;
+		}while(b == 255);
+
+		return true;
+	}
+}
+
+size_t LZ4::compressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+size_t LZ4::compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+	uint8_t* op = dst;
+	uint8_t* const opEnd = dst + dstCapacity;
+
+	size_t anchor = 0;
+
+	// Writes the sequence of literals [anchor, litEnd) followed by a match, or only the literals if matchLen is 0
+	auto emit = [&](size_t litEnd, size_t offset, size_t matchLen) {
+		size_t litLen = litEnd - anchor;
+		size_t needed = 1 + extraLengthBytes(litLen) + litLen + (matchLen ? 2 + extraLengthBytes(matchLen - MIN_MATCH) : 0);
+		if(needed > static_cast<size_t>(opEnd - op))
+			return false;
+
+		uint8_t* token = op++;
+		*token = static_cast<uint8_t>((litLen < 15 ? litLen : 15) << 4);
+		op = writeExtraLength(op, litLen);
+
+		if(litLen)
+			memcpy(op, src + anchor, litLen);
+
+		op += litLen;
+
+		if(matchLen)
+		{
+			*op++ = static_cast<uint8_t>(offset & 0xFF);
+			*op++ = static_cast<uint8_t>(offset >> 8);
+
+			size_t code = matchLen - MIN_MATCH;
+			*token |= static_cast<uint8_t>(code < 15 ? code : 15);
+			op = writeExtraLength(op, code);
+		}
+
+		return true;
+	};
+
+	if(srcSize > MF_LIMIT)
+	{
+		std::vector<uint32_t> table(size_t(1) << HASH_LOG, 0);
+		const size_t matchLimit = srcSize - LAST_LITERALS;
+		const size_t mfLimit = srcSize - MF_LIMIT;
+
+		size_t ip = 0;
+		while(ip <= mfLimit)
+		{
+			uint32_t seq = read32(src + ip);
+			uint32_t h = hash4(seq);
+			size_t candidate = table[h];
+			table[h] = static_cast<uint32_t>(ip);
+
+			if(candidate >= ip || ip - candidate > MAX_OFFSET || read32(src + candidate) != seq)
+			{
+				ip++;
+				continue;
+			}
+
+			// Grow the match backwards into the pending literals
+			while(ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1])
+			{
+				ip--;
+				candidate--;
+			}
+
+			// ...and forwards as far as allowed
+			size_t len = MIN_MATCH;
+			while(ip + len < matchLimit && src[candidate + len] == src[ip + len])
+				len++;
+
+			if(!emit(ip, ip - candidate, len))
+				return 0;
+
+			ip += len;
+			anchor = ip;
+
+			// Make the position right before the next search known as well, helps with runs
+			if(ip - 2 <= mfLimit)
+				table[hash4(read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+		}
+	}
+
+	// Everything left over goes into the last sequence
+	if(!emit(srcSize, 0, 0))
+		return 0;
+
+	return static_cast<size_t>(op - dst);
+}
+
+bool LZ4::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+	size_t ip = 0;
+	size_t op = 0;
+
+	while(ip < srcSize)
+	{
+		uint8_t token = src[ip++];
+
+		// Literals
+		size_t litLen = token >> 4;
+		if(litLen == 15 && !readExtraLength(src, srcSize, ip, litLen))
+			return false;
+
+		if(litLen > srcSize - ip || litLen > dstSize - op)
+			return false;
+
+		if(litLen)
+			memcpy(dst + op, src + ip, litLen);
+
+		ip += litLen;
+		op += litLen;
+
+		// The last sequence ends after its literals
+		if(ip == srcSize)
+			break;
+
+		// Match
+		if(srcSize - ip < 2)
+			return false;
+
+		size_t offset = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+		ip += 2;
+
+		if(offset == 0 || offset > op)
+			return false;
+
+		size_t matchLen = token & 15;
+		if(matchLen == 15 && !readExtraLength(src, srcSize, ip, matchLen))
+			return false;
+
+		matchLen += MIN_MATCH;
+		if(matchLen > dstSize - op)
+			return false;
+
+		// Matches may overlap with what they produce, copy bytewise then
+		uint8_t* out = dst + op;
+		const uint8_t* match = out - offset;
+		if(offset >= matchLen)
+			memcpy(out, match, matchLen);
+		else
+		{
+			for(size_t i = 0; i < matchLen; i++)
+				out[i] = match[i];
+		}
+
+		op += matchLen;
+	}
+
+	return op == dstSize;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VDFS
+{
+	/**
+	 * @brief Compressor and decompressor for the LZ4 block-format. Output is compatible with the reference implementation,
+	 *		  though the compressor is a simple greedy one and doesn't reach the same ratios.
+	 */
+	namespace LZ4
+	{
+		/**
+		 * @brief Maximum size the compressed data of srcSize bytes can take
+		 */
+		size_t compressBound(size_t srcSize);
+
+		/**
+		 * @brief Compresses src into dst, which should have room for at least compressBound(srcSize) bytes
+		 * @return Size of the compressed data, 0 if it didn't fit into dst
+		 */
+		size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+		/**
+		 * @brief Decompresses exactly dstSize bytes from src. Never reads or writes out of bounds, even for broken input.
+		 * @return False, if the data is corrupt or doesn't decompress to dstSize bytes
+		 */
+		bool decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+	}
+}
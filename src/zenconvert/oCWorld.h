@@ -3,6 +3,11 @@
 #include "zenParser.h"
 #include "zCVob.h"
 #include "utils/logger.h"
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
 
 namespace ZenConvert
 {
@@ -27,9 +32,6 @@ namespace ZenConvert
 				return;
 			}
 
-			static int i=0;
-			i++;
-
 			// Read vob data, followed by the count of the children of this vob
 			zCVobData v = zCVob::readObjectData(parser);
 
@@ -45,8 +47,130 @@ namespace ZenConvert
 			{
 				readVobTree(parser, target.back().childVobs);
 			}
-			
-			
+		}
+
+		/**
+		* @brief Moves the parser past a vob and all of its children, like readVobTree would, but without
+		*		 reading any of the properties
+		*/
+		static void skipVobTree(ZenParser& parser)
+		{
+			uint32_t numChildren;
+
+			ZenParser::ChunkHeader header;
+			parser.readChunkStart(header);
+			parser.skipChunk();
+
+			// Read how many vobs this one has as child
+			parser.getImpl()->readEntry("", &numChildren, sizeof(numChildren), ZenConvert::ParserImpl::ZVT_INT);
+
+			// References don't have any
+			if(header.classname == "\xA7")
+				return;
+
+			for(uint32_t i = 0; i < numChildren; i++)
+			{
+				skipVobTree(parser);
+			}
+		}
+
+		/**
+		* @brief Reads numRootVobs vob-trees into target, same as calling readVobTree for each of them.
+		*		 Large trees are first scanned for where each of the root-vobs starts, then the subtrees are read
+		*		 by multiple threads, each with its own parser on the same data. The results are put together
+		*		 in the order of the file, so they are the same as when reading them one after another.
+		* @param numThreads Threads to read with at most, 0 to use one per core
+		*/
+		static void readVobTrees(ZenParser& parser, uint32_t numRootVobs, std::vector<zCVobData>& target, size_t numThreads = 0)
+		{
+			if(!numThreads)
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+			if(numThreads < 2 || numRootVobs < MIN_PARALLEL_ROOT_VOBS)
+			{
+				for(uint32_t i = 0; i < numRootVobs; i++)
+				{
+					readVobTree(parser, target);
+				}
+
+				return;
+			}
+
+			// Find where the subtrees start. The last one ends where the parser is afterwards.
+			std::vector<size_t> starts(numRootVobs + 1);
+			for(uint32_t i = 0; i < numRootVobs; i++)
+			{
+				starts[i] = parser.getSeek();
+				skipVobTree(parser);
+			}
+			starts[numRootVobs] = parser.getSeek();
+
+			// Hand out small batches of subtrees, each read into a vector of its own
+			const size_t batchSize = std::max<size_t>(1, numRootVobs / (numThreads * 8));
+			const size_t numBatches = (numRootVobs + batchSize - 1) / batchSize;
+			std::vector<std::vector<zCVobData>> batches(numBatches);
+			std::vector<std::exception_ptr> errors(numBatches);
+
+			std::atomic<size_t> next(0);
+			auto worker = [&]() {
+				// Own parser on the same data, to get an own seek and format-state. The header is shared.
+				ZenParser p(parser.getData(), parser.getFileSize());
+				p.setReadPropertyStrings(parser.getReadPropertyStrings());
+				bool hasHeader = false;
+
+				for(size_t n = next++; n < numBatches; n = next++)
+				{
+					size_t first = n * batchSize;
+					size_t last = std::min<size_t>(first + batchSize, numRootVobs);
+
+					try
+					{
+						if(!hasHeader)
+						{
+							p.copyHeader(parser);
+							hasHeader = true;
+						}
+
+						p.setSeek(starts[first]);
+						for(size_t i = first; i < last; i++)
+						{
+							readVobTree(p, batches[n]);
+						}
+
+						if(p.getSeek() != starts[last])
+							throw std::runtime_error("Vob-subtree was read differently than it was scanned");
+					}
+					catch(...)
+					{
+						// Whatever this thread didn't read yet doesn't matter, the error is thrown in the end
+						errors[n] = std::current_exception();
+						return;
+					}
+				}
+			};
+
+			numThreads = std::min(numThreads, numBatches);
+			std::vector<std::thread> threads;
+			for(size_t t = 1; t < numThreads; t++)
+				threads.emplace_back(worker);
+
+			worker();
+
+			for(std::thread& t : threads)
+				t.join();
+
+			for(std::exception_ptr& e : errors)
+			{
+				if(e)
+					std::rethrow_exception(e);
+			}
+
+			// Put them together in file-order
+			for(std::vector<zCVobData>& b : batches)
+			{
+				for(zCVobData& v : b)
+					target.push_back(std::move(v));
+			}
 		}
 
 		/**
@@ -81,10 +205,7 @@ namespace ZenConvert
 					info.rootVobs.reserve(numChildren);
 
 					// Read children
-					for(uint32_t i = 0; i < numChildren; i++)
-					{
-						readVobTree(parser, info.rootVobs);
-					}
+					readVobTrees(parser, numChildren, info.rootVobs);
 					parser.readChunkEnd();
 				}
 				else
@@ -96,7 +217,10 @@ namespace ZenConvert
 			return info;
 		}
 
-	private:
+		/**
+		* @brief Below this many root-vobs, scanning the tree and starting threads doesn't pay off
+		*/
+		static const uint32_t MIN_PARALLEL_ROOT_VOBS = 64;
 	};
 
 }
\ No newline at end of file
@@ -1,6 +1,89 @@
 #include "parserImpl.h"
+#include "zenTokenizer.h"
 
 ZenConvert::ParserImpl::ParserImpl(ZenParser * parser) :
 	m_pParser(parser)
 {
 }
+
+/**
+ * @brief Parses the inside of a chunk-header
+ */
+bool ZenConvert::ParserImpl::parseChunkDescriptor(std::string_view descriptor, ZenParser::ChunkHeader& header)
+{
+	std::string_view name;
+	std::string_view className;
+	int classVersion = 0;
+	int objectID = 0;
+	bool createObject = false;
+	enum State
+	{
+		S_OBJECT_NAME,
+		S_REFERENCE,
+		S_CLASS_NAME,
+		S_CLASS_VERSION,
+		S_OBJECT_ID,
+		S_FINISHED
+	} state = S_OBJECT_NAME;
+
+	std::string_view rest = descriptor;
+	for(std::string_view arg = Tokenizer::nextToken(rest, ' '); !arg.empty(); arg = Tokenizer::nextToken(rest, ' '))
+	{
+		switch(state)
+		{
+		case S_OBJECT_NAME:
+			if(arg != "%")
+			{
+				name = arg;
+				state = S_REFERENCE;
+				break;
+			}
+		case S_REFERENCE:
+			if(arg == "%")
+			{
+				createObject = true;
+				state = S_CLASS_NAME;
+				break;
+			}
+			else if(arg == "\xA7")
+			{
+				createObject = false;
+				state = S_CLASS_NAME;
+				break;
+			}
+			else
+				createObject = true;
+		case S_CLASS_NAME:
+			if(!Tokenizer::isNumber(arg))
+			{
+				className = arg;
+				state = S_CLASS_VERSION;
+				break;
+			}
+		case S_CLASS_VERSION:
+			classVersion = 0;
+			Tokenizer::parseNumber(arg, classVersion);
+			state = S_OBJECT_ID;
+			break;
+		case S_OBJECT_ID:
+			objectID = 0;
+			Tokenizer::parseNumber(arg, objectID);
+			state = S_FINISHED;
+			break;
+		default:
+			return false; // More parts than expected
+		}
+	}
+
+	if(state != S_FINISHED)
+		return false;
+
+	header.classname = className;
+	header.createObject = createObject;
+	header.name = name;
+	header.objectID = objectID;
+	header.size = 0; // Doesn't matter in ASCII
+	header.version = classVersion;
+
+	return true;
+}
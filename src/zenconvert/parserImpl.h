@@ -33,6 +33,11 @@ namespace ZenConvert
 			ZVT_ENUM = 0x11,
 		};
 
+		/**
+		 * @brief Key-ID returned when the name of a property isn't known
+		 */
+		static const uint32_t INVALID_KEY = 0xFFFFFFFF;
+
 		ParserImpl(ZenParser* parser);
 		virtual ~ParserImpl(){}
 
@@ -41,6 +46,12 @@ namespace ZenConvert
 		 */
 		virtual void readImplHeader() = 0;
 
+		/**
+		 * @brief Creates an implementation for the given parser, which works on the same data as this one.
+		 *		  Whatever this one took from the header is shared, so the new one doesn't have to read it again.
+		 */
+		virtual ParserImpl* clone(ZenParser* parser) const = 0;
+
 		/**
 		 * @brief Read the start of a chunk. [...] Returns true if there actually was a start. 
 		 *		  Otherwise it will leave m_Seek untouched and return false.
@@ -53,6 +64,13 @@ namespace ZenConvert
 		 */
 		virtual bool readChunkEnd()=0;
 
+		/**
+		 * @brief Moves past the rest of the current chunk, including its end, by only looking at chunk-headers
+		 *		  and -ends. Returns false without moving if the format can't do that, ZenParser::skipChunk
+		 *		  goes through every entry then.
+		 */
+		virtual bool skipChunk() { return false; }
+
 		/**
 		 * @brief Reads a string
 		 */
@@ -68,11 +86,50 @@ namespace ZenConvert
 		 */
 		virtual void readEntryType(EZenValueType& type, size_t& size) = 0;
 
+		/**
+		 * @brief Returns the ID of the name of the entry which will be read next, if the format stores one.
+		 *		  IDs are small integers, so readers can tell properties apart without comparing their names.
+		 * @return INVALID_KEY, if the format doesn't store the names of its entries like this
+		 */
+		virtual uint32_t getNextKeyId() const { return INVALID_KEY; }
+
+		/**
+		 * @brief Returns the ID the given property-name has in this archive, to compare against getNextKeyId
+		 * @return INVALID_KEY, if there is no such name in this archive
+		 */
+		virtual uint32_t findKeyId(std::string_view) const { return INVALID_KEY; }
+
+		/**
+		 * @brief Returns the property-name with the given ID. Points into the data of the parser.
+		 * @return Empty view, if the ID is unknown
+		 */
+		virtual std::string_view getKeyName(uint32_t) const { return std::string_view(); }
+
+		/**
+		 * @brief IDs of the property-names of a schema, as findKeyId returns them, cached for this parser.
+		 *		  Keyed by the address of the schema. Empty, until ReadObjectSchema filled it in.
+		 */
+		std::vector<uint32_t>& getSchemaKeyIds(const void* schema) { return m_SchemaKeyIds[schema]; }
+
 	protected:
 
+		/**
+		 * @brief Parses the inside of a chunk-header like "% oCItem:zCVob 47105 12", without the brackets,
+		 *		  into name, classname, version, objectID and whether an object is created. Doesn't allocate.
+		 * @return False, if the descriptor is incomplete
+		 */
+		static bool parseChunkDescriptor(std::string_view descriptor, ZenParser::ChunkHeader& header);
+
 		/**
 		 * @brief Parser-Object this operates on
 		 */
 		ZenParser* m_pParser;
+
+	private:
+
+		/**
+		 * @brief See getSchemaKeyIds
+		 */
+		std::unordered_map<const void*, std::vector<uint32_t>> m_SchemaKeyIds;
 	};
 }
\ No newline at end of file
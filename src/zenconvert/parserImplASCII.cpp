@@ -1,5 +1,6 @@
 #include "parserImplASCII.h"
 #include "utils/logger.h"
+#include "zenTokenizer.h"
 
 using namespace ZenConvert;
 
@@ -15,119 +16,33 @@ bool ParserImplASCII::readChunkStart(ZenParser::ChunkHeader& header)
 	m_pParser->skipSpaces();
 
 	size_t seek = m_pParser->getSeek();
-	try{
-		// Check chunk-header
-		m_pParser->skipSpaces();
-
-		// Early exit if this is a chunk-end or not a chunk header
-		if(m_pParser->m_Data[m_pParser->m_Seek] != '[' || m_pParser->m_Data[m_pParser->m_Seek+1] == ']')
-		{
-			m_pParser->setSeek(seek);
-			return false;
-		}
-
-		//if(m_pParser->m_Data[m_pParser->m_Seek] != '[')
-		//	throw std::runtime_error("Invalid format");
-
-		m_pParser->m_Seek++;
-
-		size_t tmpSeek = m_pParser->m_Seek;
-		while(m_pParser->m_Data[tmpSeek] != ']')
-		{
-			if(m_pParser->m_Data[tmpSeek] == '\r' && m_pParser->m_Data[tmpSeek] == '\n')
-				throw std::runtime_error("Invalid vob descriptor");
-
-			++tmpSeek;
-		}
+	const uint8_t* data = m_pParser->m_pData;
+	const size_t dataSize = m_pParser->m_DataSize;
 
+	// Early exit if this is a chunk-end or not a chunk header
+	if(seek + 1 >= dataSize || data[seek] != '[' || data[seek + 1] == ']')
+		return false;
 
-		// Save chunks starting-position (right after chunk-header)
-		header.startPosition = m_pParser->m_Seek;
+	// Find the end of the header, which has to be on the same line
+	size_t tmpSeek = seek + 1;
+	while(tmpSeek < dataSize && data[tmpSeek] != ']' && data[tmpSeek] != '\r' && data[tmpSeek] != '\n')
+		++tmpSeek;
 
-		// Parse chunk-header
-		std::string vobDescriptor(reinterpret_cast<char *>(&m_pParser->m_Data[m_pParser->m_Seek]), tmpSeek - m_pParser->m_Seek);
-		std::vector<std::string> vec = Utils::split(vobDescriptor, ' ');
-		m_pParser->m_Seek = tmpSeek + 1;
+	if(tmpSeek >= dataSize || data[tmpSeek] != ']')
+		return false;
 
-		std::string name;
-		std::string className;
-		int classVersion = 0;
-		int objectID = 0;
-		bool createObject = false;
-		enum State
-		{
-			S_OBJECT_NAME,
-			S_REFERENCE,
-			S_CLASS_NAME,
-			S_CLASS_VERSION,
-			S_OBJECT_ID,
-			S_FINISHED
-		} state = S_OBJECT_NAME;
-
-		for(auto &arg : vec)
-		{
-			switch(state)
-			{
-			case S_OBJECT_NAME:
-				if(arg != "%")
-				{
-					name = arg;
-					state = S_REFERENCE;
-					break;
-				}
-			case S_REFERENCE:
-				if(arg == "%")
-				{
-					createObject = true;
-					state = S_CLASS_NAME;
-					break;
-				}
-				else if(arg == "\xA7")
-				{
-					createObject = false;
-					state = S_CLASS_NAME;
-					break;
-				}
-				else
-					createObject = true;
-			case S_CLASS_NAME:
-				if(!m_pParser->isNumber(arg))
-				{
-					className = arg;
-					state = S_CLASS_VERSION;
-					break;
-				}
-			case S_CLASS_VERSION:
-				classVersion = std::atoi(arg.c_str());
-				state = S_OBJECT_ID;
-				break;
-			case S_OBJECT_ID:
-				objectID = std::atoi(arg.c_str());
-				state = S_FINISHED;
-				break;
-			default:
-				throw std::runtime_error("Strange parser state");
-			}
-		}
+	// Parse chunk-header
+	std::string_view vobDescriptor(reinterpret_cast<const char *>(&data[seek + 1]), tmpSeek - seek - 1);
+	if(!parseChunkDescriptor(vobDescriptor, header))
+		return false;
 
-		if(state != S_FINISHED)
-			throw std::runtime_error("Parser did not finish");
+	// Save chunks starting-position (right after chunk-header)
+	header.startPosition = static_cast<uint32_t>(seek + 1);
 
-		header.classname = className;
-		header.createObject = createObject;
-		header.name = name;
-		header.objectID = objectID;
-		header.size = 0; // Doesn't matter in ASCII
-		header.version = classVersion;
+	m_pParser->m_Seek = tmpSeek + 1;
 
-		// Skip the last newline
-		m_pParser->skipSpaces();
-	}
-	catch(std::runtime_error e)
-	{
-		m_pParser->setSeek(seek);
-		return false;
-	}
+	// Skip the last newline
+	m_pParser->skipSpaces();
 
 	return true;
 }
@@ -140,9 +55,8 @@ bool ParserImplASCII::readChunkEnd()
 	size_t seek = m_pParser->getSeek();
 
 	m_pParser->skipSpaces();
-	std::string l = readString();
 
-	if(l != "[]")
+	if(m_pParser->readLineView() != "[]")
 	{
 		m_pParser->setSeek(seek); // Next property isn't a string or the end
 		return false;
@@ -153,6 +67,54 @@ bool ParserImplASCII::readChunkEnd()
 	return true;
 }
 
+/**
+ * @brief Moves past the rest of the current chunk. Only chunk-headers and -ends start with '[',
+ *		  so every other line is skipped without looking any further.
+ */
+bool ParserImplASCII::skipChunk()
+{
+	const uint8_t* data = m_pParser->m_pData;
+	const size_t dataSize = m_pParser->m_DataSize;
+	size_t seek = m_pParser->m_Seek;
+	size_t level = 1;
+
+	while(seek < dataSize)
+	{
+		// Skip the indentation
+		while(seek < dataSize && (data[seek] == ' ' || data[seek] == '\t' || data[seek] == '\r' || data[seek] == '\n'))
+			++seek;
+
+		size_t lineStart = seek;
+		while(seek < dataSize && data[seek] != '\r' && data[seek] != '\n' && data[seek] != '\0')
+			++seek;
+
+		std::string_view line(reinterpret_cast<const char*>(&data[lineStart]), seek - lineStart);
+		if(line.empty() || line.front() != '[')
+			continue;
+
+		if(line == "[]")
+		{
+			if(--level == 0)
+			{
+				// Same as readChunkEnd, which skips the newline and the indentation of the next line
+				m_pParser->m_Seek = seek;
+				m_pParser->skipSpaces();
+				return true;
+			}
+
+			continue;
+		}
+
+		// Same checks as readChunkStart
+		ZenParser::ChunkHeader header;
+		size_t end = line.find(']');
+		if(end != std::string_view::npos && parseChunkDescriptor(line.substr(1, end - 1), header))
+			level++;
+	}
+
+	throw std::runtime_error("Chunk doesn't end before the file does");
+}
+
 /**
  * @brief Read the implementation specific header and stores it in the parsers main-header struct
  */
@@ -169,6 +131,14 @@ void ParserImplASCII::readImplHeader()
 	m_pParser->skipSpaces();
 }
 
+/**
+ * @brief Creates an implementation for the given parser. Nothing of the header is kept in here.
+ */
+ParserImpl* ParserImplASCII::clone(ZenParser* parser) const
+{
+	return new ParserImplASCII(parser);
+}
+
 /**
  * @brief Reads a string
  */
@@ -183,76 +153,71 @@ std::string ParserImplASCII::readString()
 void ParserImplASCII::readEntry(const std::string& expectedName, void* target, size_t targetSize, EZenValueType expectedType)
 {
 	m_pParser->skipSpaces();
-	std::string line = m_pParser->readLine();
+	std::string_view line = m_pParser->readLineView();
 
 	// Special cases for chunk starts/ends
-	if(line == "[]" || (line.front() == '[' && line.back() == ']'))
+	if(line == "[]" || (!line.empty() && line.front() == '[' && line.back() == ']'))
 	{
-		*reinterpret_cast<std::string*>(target) = line;
+		*reinterpret_cast<std::string*>(target) = std::string(line);
 		return;
 	}
 
-	// Split at =, then at :
-	// parts should then have 3 elements, name, type and value
-	auto parts = Utils::split(line, "=:");
-
-	if(parts.size() < 2)
+	// Lines look like name=type:value
+	std::string_view valueName, type, value;
+	if(!splitProperty(line, valueName, type, value))
 		throw std::runtime_error("Failed to parse property: " + expectedName);
 
-	const std::string& valueName = parts[0];
-	const std::string& type = parts[1];
-	const std::string& value = parts.size() > 2 ? parts[2] : "";
-
-	// Split value as well, if possible
-	auto vparts = Utils::split(value, ' ');
-
 	if(!expectedName.empty() && valueName != expectedName)
-		throw std::runtime_error("Value name does not match expected name. Value:" + valueName + " Expected: " + expectedName);
+		throw std::runtime_error("Value name does not match expected name. Value:" + std::string(valueName) + " Expected: " + expectedName);
+
+	// Values made of multiple parts are separated by spaces
+	std::string_view vparts = value;
 
 	switch(expectedType)
 	{
 		case ZVT_0: break;
-		case ZVT_STRING: *reinterpret_cast<std::string*>(target) = value; break;
-		case ZVT_INT: *reinterpret_cast<int32_t*>(target) = std::stoi(value); break;
-		case ZVT_FLOAT: *reinterpret_cast<float*>(target) = std::stof(value); break;
-		case ZVT_BYTE: *reinterpret_cast<uint8_t*>(target) = static_cast<uint8_t>(std::stoi(value)); break;
-		case ZVT_WORD: *reinterpret_cast<int16_t*>(target) = static_cast<int16_t>(std::stoi(value)); break;
-		case ZVT_BOOL: *reinterpret_cast<bool*>(target) = std::stoi(value) != 0; break;
-		case ZVT_VEC3: *reinterpret_cast<Math::float3*>(target) = Math::float3(std::stof(vparts[0]), std::stof(vparts[1]), std::stof(vparts[2])); break;
+		case ZVT_STRING: *reinterpret_cast<std::string*>(target) = std::string(value); break;
+		case ZVT_INT: *reinterpret_cast<int32_t*>(target) = Tokenizer::toNumber<int32_t>(value); break;
+		case ZVT_FLOAT: *reinterpret_cast<float*>(target) = Tokenizer::toNumber<float>(value); break;
+		case ZVT_BYTE: *reinterpret_cast<uint8_t*>(target) = static_cast<uint8_t>(Tokenizer::toNumber<int32_t>(value)); break;
+		case ZVT_WORD: *reinterpret_cast<int16_t*>(target) = static_cast<int16_t>(Tokenizer::toNumber<int32_t>(value)); break;
+		case ZVT_BOOL: *reinterpret_cast<bool*>(target) = Tokenizer::toNumber<int32_t>(value) != 0; break;
+		case ZVT_VEC3: 
+			{
+				float x = Tokenizer::toNumber<float>(Tokenizer::nextToken(vparts, ' '));
+				float y = Tokenizer::toNumber<float>(Tokenizer::nextToken(vparts, ' '));
+				float z = Tokenizer::toNumber<float>(Tokenizer::nextToken(vparts, ' '));
+				*reinterpret_cast<Math::float3*>(target) = Math::float3(x, y, z);
+			}
+			break;
 		
 		case ZVT_COLOR: 
-			reinterpret_cast<uint8_t*>(target)[0] = std::stoi(vparts[0]); // FIXME: These are may ordered wrong
-			reinterpret_cast<uint8_t*>(target)[1] = std::stoi(vparts[1]);
-			reinterpret_cast<uint8_t*>(target)[2] = std::stoi(vparts[2]);
-			reinterpret_cast<uint8_t*>(target)[3] = std::stoi(vparts[3]);
+			for(size_t i = 0; i < 4; i++)
+				reinterpret_cast<uint8_t*>(target)[i] = static_cast<uint8_t>(Tokenizer::toNumber<int32_t>(Tokenizer::nextToken(vparts, ' '))); // FIXME: These are may ordered wrong
 			break;
 
 		case ZVT_RAW_FLOAT:
 			{
-				size_t i=0;
-				for(auto& v : vparts)
+				float* data = reinterpret_cast<float*>(target);
+				for(size_t i = 0; i < targetSize / sizeof(float) && !vparts.empty(); i++)
 				{
-					float* data = reinterpret_cast<float*>(target);
-					data[i] = std::stof(v);
-					i++;
+					std::string_view v = Tokenizer::nextToken(vparts, ' ');
+					if(v.empty())
+						break;
+
+					data[i] = Tokenizer::toNumber<float>(v);
 				}
 			}
 			break;
 		case ZVT_RAW: 
 			{
 				uint8_t* data = reinterpret_cast<uint8_t*>(target);
-				char c[3];
-				c[2] = 0;
 
-				for(size_t i = 0; i < targetSize; i++)
-				{
-					if(value.size() < i * 2 + 1)
-						throw std::runtime_error("Invalid raw dataset");
+				if(value.size() < targetSize * 2)
+					throw std::runtime_error("Invalid raw dataset");
 
-					c[0] = value[i * 2];
-					c[1] = value[i * 2 + 1];
-					data[i] = static_cast<uint8_t>(std::stoi(std::string(c), 0, 16));
-				}
+				for(size_t i = 0; i < targetSize; i++)
+					data[i] = static_cast<uint8_t>(Tokenizer::toNumber<uint32_t>(value.substr(i * 2, 2), 16));
 			}
 			break;
 		case ZVT_10: break;
@@ -261,7 +226,7 @@ void ParserImplASCII::readEntry(const std::string& expectedName, void* target, s
 		case ZVT_13: break;
 		case ZVT_14: break;
 		case ZVT_15: break;
-		case ZVT_ENUM: *reinterpret_cast<uint8_t*>(target) = std::stoi(value); break;
+		case ZVT_ENUM: *reinterpret_cast<uint8_t*>(target) = static_cast<uint8_t>(Tokenizer::toNumber<int32_t>(value)); break;
 	}
 }
 
@@ -271,36 +236,50 @@ void ParserImplASCII::readEntry(const std::string& expectedName, void* target, s
 void ParserImplASCII::readEntryType(EZenValueType& outtype, size_t& size)
 {
 	m_pParser->skipSpaces();
-	std::string line = m_pParser->readLine();
+	std::string_view line = m_pParser->readLineView();
 
 	// Special cases for chunk starts/ends
-	if(line == "[]" || (line.front() == '[' && line.back() == ']'))
+	if(line == "[]" || (!line.empty() && line.front() == '[' && line.back() == ']'))
 	{
 		outtype = ZVT_STRING;
 		size = 0;
 		return;
 	}
 
-	// Split at =, then at :
-	// parts should then have 3 elements, name, type and value
-	auto parts = Utils::split(line, "=:");
-
-	if(parts.size() < 2) // Need at least name and type
+	// Need at least name and type
+	std::string_view valueName, type, value;
+	if(!splitProperty(line, valueName, type, value))
 		throw std::runtime_error("Failed to read property type");
 
-	const std::string& type = parts[1];
-	size_t cLoc = line.find_first_of(':') == std::string::npos ? 0 : line.find_first_of(':');
-
-	if(type == "string") { outtype = ZVT_STRING; size = 0; }
-	else if(type == "int") { outtype = ZVT_INT; size = 0; }
-	else if(type == "float") { outtype = ZVT_FLOAT; size = 0; }
-	else if(type == "byte") { outtype = ZVT_BYTE; size = 0; }
-	else if(type == "word") { outtype = ZVT_WORD; size = 0; }
-	else if(type == "bool") { outtype = ZVT_BOOL; size = 0; }
-	else if(type == "vec3") { outtype = ZVT_VEC3; size = 0; }
-	else if(type == "color") { outtype = ZVT_COLOR; size = 0; }
-	else if(type == "rawFloat") { outtype = ZVT_RAW_FLOAT; size = 0; }
-	else if(type == "raw") { outtype = ZVT_RAW; size = 0; }
-	else if(type == "enum") { outtype = ZVT_ENUM; size = 0; }
+	size = 0;
+	if(type == "string") outtype = ZVT_STRING;
+	else if(type == "int") outtype = ZVT_INT;
+	else if(type == "float") outtype = ZVT_FLOAT;
+	else if(type == "byte") outtype = ZVT_BYTE;
+	else if(type == "word") outtype = ZVT_WORD;
+	else if(type == "bool") outtype = ZVT_BOOL;
+	else if(type == "vec3") outtype = ZVT_VEC3;
+	else if(type == "color") outtype = ZVT_COLOR;
+	else if(type == "rawFloat") outtype = ZVT_RAW_FLOAT;
+	else if(type == "raw") outtype = ZVT_RAW;
+	else if(type == "enum") outtype = ZVT_ENUM;
 	else throw std::runtime_error("Unknown type");
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Splits a property-line of the form name=type:value into its parts
+ */
+bool ParserImplASCII::splitProperty(std::string_view line, std::string_view& name, std::string_view& type, std::string_view& value)
+{
+	size_t eq = line.find('=');
+	if(eq == std::string_view::npos || eq == 0)
+		return false;
+
+	name = line.substr(0, eq);
+
+	size_t colon = line.find(':', eq + 1);
+	type = line.substr(eq + 1, colon == std::string_view::npos ? std::string_view::npos : colon - eq - 1);
+	value = colon == std::string_view::npos ? std::string_view() : line.substr(colon + 1);
+
+	return !type.empty();
+}
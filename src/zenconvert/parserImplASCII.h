@@ -14,6 +14,11 @@ namespace ZenConvert
 		 */
 		virtual void readImplHeader();
 
+		/**
+		 * @brief Creates an implementation for the given parser, sharing the header read by this one
+		 */
+		virtual ParserImpl* clone(ZenParser* parser) const;
+
 		/**
 		* @brief Read the start of a chunk. [...] Returns true if there actually was a start. 
 		*		  Otherwise it will leave m_Seek untouched and return false.
@@ -26,6 +31,11 @@ namespace ZenConvert
 		*/
 		virtual bool readChunkEnd();
 
+		/**
+		* @brief Moves past the rest of the current chunk, without reading any of its entries
+		*/
+		virtual bool skipChunk();
+
 		/**
 		 * @brief Reads a string
 		 */
@@ -40,5 +50,12 @@ namespace ZenConvert
 		* @brief Reads the type of a single entry
 		*/
 		virtual void readEntryType(EZenValueType& type, size_t& size);
+
+	private:
+		/**
+		 * @brief Splits a property-line of the form name=type:value into its parts. The value may be empty.
+		 * @return False, if this is no property-line
+		 */
+		static bool splitProperty(std::string_view line, std::string_view& name, std::string_view& type, std::string_view& value);
 	};
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "parserImplBinSafe.h"
+#include "zenTokenizer.h"
+#include <string.h>
 
 using namespace ZenConvert;
 
-ZenConvert::ParserImplBinSafe::ParserImplBinSafe(ZenParser * parser) : ParserImpl(parser)
+ZenConvert::ParserImplBinSafe::ParserImplBinSafe(ZenParser * parser) : ParserImpl(parser), m_NextKeyId(INVALID_KEY)
 {
 }
 
@@ -11,126 +13,41 @@ ZenConvert::ParserImplBinSafe::ParserImplBinSafe(ZenParser * parser) : ParserImp
 */
 bool ParserImplBinSafe::readChunkStart(ZenParser::ChunkHeader& header)
 {
-	size_t seek = m_pParser->getSeek();
-	try{
-
-		EZenValueType type;
-		size_t size;
-
-		// Check if this actually will be a string
-		readTypeAndSizeBinSafe(type, size);
-		m_pParser->setSeek(seek);
-
-		if(type != ZVT_STRING)	
-			return false; // Next property isn't a string or the end
-
-		// Read chunk-header
-		std::string vobDescriptor = readString();
-
-		// Early exit if this is a chunk-end or not a chunk header
-		if(vobDescriptor.front() != '[' && vobDescriptor.back() != ']' || vobDescriptor.size() <= 2)
-		{
-			m_pParser->setSeek(seek);
-			return false;
-		}
+	// This gets called speculatively in front of most entries, so find out cheaply whether this is a chunk-header
+	std::string_view vobDescriptor;
+	if(!peekString(vobDescriptor) || vobDescriptor.size() <= 2 || vobDescriptor.front() != '[' || vobDescriptor.back() != ']')
+		return false; // Next property isn't a string, or a chunk-end or no chunk-header
 
-		vobDescriptor = vobDescriptor.substr(1, vobDescriptor.size() - 2);
-
-		// Special case for camera keyframes
-		if(vobDescriptor.find('%') != std::string::npos && vobDescriptor.find('\xA7') != std::string::npos)
-		{
-			// Make a header with createObject = true and ref as classname
-			auto parts = Utils::split(vobDescriptor, ' ');
-			header.createObject = true;
-			header.classname = "\xA7";
-			header.name = "%";
-			header.size = 0;
-			header.version = 0;
-			header.objectID = std::stoi(parts.back());
-			return true;
-		}
-
-		// Save chunks starting-position (right after chunk-header)
-		header.startPosition = m_pParser->m_Seek;
+	size_t seek = m_pParser->getSeek();
+	uint32_t keyId = m_NextKeyId;
 
-		// Parse chunk-header
-		std::vector<std::string> vec = Utils::split(vobDescriptor, ' ');
+	// Actually read it, to get past the trailing hash
+	readStringView();
 
-		std::string name;
-		std::string className;
-		int classVersion = 0;
-		int objectID = 0;
-		bool createObject = false;
-		enum State
-		{
-			S_OBJECT_NAME,
-			S_REFERENCE,
-			S_CLASS_NAME,
-			S_CLASS_VERSION,
-			S_OBJECT_ID,
-			S_FINISHED
-		} state = S_OBJECT_NAME;
-
-		for(auto &arg : vec)
-		{
-			switch(state)
-			{
-			case S_OBJECT_NAME:
-				if(arg != "%")
-				{
-					name = arg;
-					state = S_REFERENCE;
-					break;
-				}
-			case S_REFERENCE:
-				if(arg == "%")
-				{
-					createObject = true;
-					state = S_CLASS_NAME;
-					break;
-				}
-				else if(arg == "\xA7")
-				{
-					createObject = false;
-					state = S_CLASS_NAME;
-					break;
-				}
-				else
-					createObject = true;
-			case S_CLASS_NAME:
-				if(!m_pParser->isNumber(arg))
-				{
-					className = arg;
-					state = S_CLASS_VERSION;
-					break;
-				}
-			case S_CLASS_VERSION:
-				classVersion = std::atoi(arg.c_str());
-				state = S_OBJECT_ID;
-				break;
-			case S_OBJECT_ID:
-				objectID = std::atoi(arg.c_str());
-				state = S_FINISHED;
-				break;
-			default:
-				throw std::runtime_error("Strange parser state");
-			}
-		}
+	vobDescriptor = vobDescriptor.substr(1, vobDescriptor.size() - 2);
 
-		if(state != S_FINISHED)
-			throw std::runtime_error("Parser did not finish");
+	// Special case for camera keyframes
+	if(vobDescriptor.find('%') != std::string_view::npos && vobDescriptor.find('\xA7') != std::string_view::npos)
+	{
+		// Make a header with createObject = true and ref as classname
+		header.createObject = true;
+		header.classname = "\xA7";
+		header.name = "%";
+		header.size = 0;
+		header.version = 0;
+		header.objectID = 0;
+		Tokenizer::parseNumber(Tokenizer::lastToken(vobDescriptor, ' '), header.objectID);
+		return true;
+	}
 
-		header.classname = className;
-		header.createObject = createObject;
-		header.name = name;
-		header.objectID = objectID;
-		header.size = 0; // Doesn't matter in ASCII
-		header.version = classVersion;
+	// Save chunks starting-position (right after chunk-header)
+	header.startPosition = m_pParser->m_Seek;
 
-	}
-	catch(std::runtime_error e)
+	// Parse chunk-header
+	if(!parseChunkDescriptor(vobDescriptor, header))
 	{
 		m_pParser->setSeek(seek);
+		m_NextKeyId = keyId;
 		return false;
 	}
 
@@ -142,33 +59,78 @@ bool ParserImplBinSafe::readChunkStart(ZenParser::ChunkHeader& header)
 */
 bool ParserImplBinSafe::readChunkEnd()
 {
-	size_t seek = m_pParser->getSeek();
-	try{
+	std::string_view str;
+	if(!peekString(str) || str != "[]")
+		return false; // Next property isn't a string or not the end
+
+	readStringView();
+	return true;
+}
+
+/**
+* @brief Moves past the rest of the current chunk. Every entry has its size in front, so only strings looking
+*		 like chunk-headers or -ends need a closer look.
+*/
+bool ParserImplBinSafe::skipChunk()
+{
+	size_t level = 1;
+
+	while(m_pParser->m_Seek < m_pParser->m_DataSize)
+	{
 		EZenValueType type;
 		size_t size;
-
-		// Check if this actually will be a string
 		readTypeAndSizeBinSafe(type, size);
-		m_pParser->setSeek(seek);
 
-		if(type != ZVT_STRING)	
-			return false; // Next property isn't a string or the end
-		
+		if(size > m_pParser->m_DataSize - m_pParser->m_Seek)
+			throw std::runtime_error("BinSafe: Entry exceeds the file");
+
+		std::string_view str(reinterpret_cast<const char*>(&m_pParser->m_pData[m_pParser->m_Seek]), size);
+		m_pParser->m_Seek += size;
 
-		std::string l = readString();
+		if(type != ZVT_STRING || str.size() < 2 || str.front() != '[' || str.back() != ']')
+			continue;
 
-		if(l != "[]")
+		if(str == "[]")
 		{
-			m_pParser->setSeek(seek);
-			return false;
+			if(--level == 0)
+			{
+				// Same as readChunkEnd
+				skipKeyHash();
+				return true;
+			}
+
+			continue;
 		}
+
+		// Same checks as readChunkStart
+		std::string_view vobDescriptor = str.substr(1, str.size() - 2);
+		ZenParser::ChunkHeader header;
+		if((vobDescriptor.find('%') != std::string_view::npos && vobDescriptor.find('\xA7') != std::string_view::npos)
+			|| parseChunkDescriptor(vobDescriptor, header))
+			level++;
 	}
-	catch(std::runtime_error e)
-	{
-		m_pParser->setSeek(seek);
-		return false; // Next property isn't a string or the end
-	}
 
+	throw std::runtime_error("BinSafe: Chunk doesn't end before the file does");
+}
+
+/**
+* @brief Looks at the next entry without reading it
+*/
+bool ParserImplBinSafe::peekString(std::string_view& str) const
+{
+	const uint8_t* data = m_pParser->m_pData;
+	size_t seek = m_pParser->m_Seek;
+	size_t dataSize = m_pParser->m_DataSize;
+
+	// Type and 16-bit size, followed by the characters
+	if(seek >= dataSize || dataSize - seek < 3 || data[seek] != ZVT_STRING)
+		return false;
+
+	uint16_t size = static_cast<uint16_t>(data[seek + 1] | (data[seek + 2] << 8));
+	if(size > dataSize - seek - 3)
+		return false;
+
+	str = std::string_view(reinterpret_cast<const char*>(&data[seek + 3]), size);
 	return true;
 }
 
@@ -186,41 +148,71 @@ void ParserImplBinSafe::readImplHeader()
 	// Read offset of where to find the global hash-table of all objects
 	m_pParser->m_Header.binSafeHeader.bsHashTableOffset = m_pParser->readBinaryDWord();
 
-	// Read hashtable
+	// Read hashtable. Its entries hold the names of all properties, and the index they were inserted at,
+	// which is what the hash in front of each property refers to.
 	size_t s = m_pParser->m_Seek;
 	m_pParser->m_Seek = m_pParser->m_Header.binSafeHeader.bsHashTableOffset;
 
-	struct BinSafeEntry
-	{
-		std::string key;
-		uint16_t insertionIndex;
-	};
+	std::shared_ptr<KeyTable> table = std::make_shared<KeyTable>();
+	m_Keys = nullptr;
+
+	if(m_pParser->m_Seek > m_pParser->m_DataSize || m_pParser->m_DataSize - m_pParser->m_Seek < sizeof(uint32_t))
+		throw std::runtime_error("BinSafe: Hashtable exceeds the file");
 
-	std::unordered_map<uint32_t, std::vector<BinSafeEntry>> map;
 	uint32_t htSize = m_pParser->readBinaryDWord();
+	table->keyIds.reserve(htSize);
 	for(uint32_t i = 0; i < htSize; i++)
 	{
+		if(m_pParser->m_DataSize - m_pParser->m_Seek < sizeof(uint16_t) * 2 + sizeof(uint32_t))
+			throw std::runtime_error("BinSafe: Hashtable exceeds the file");
+
 		uint16_t keyLen = m_pParser->readBinaryWord();
 		uint16_t insIdx = m_pParser->readBinaryWord();
-		uint32_t hashValue = m_pParser->readBinaryDWord();
+		m_pParser->readBinaryDWord(); // Hash-value of the name, not needed for looking them up by index
+
+		if(m_pParser->m_DataSize - m_pParser->m_Seek < keyLen)
+			throw std::runtime_error("BinSafe: Hashtable exceeds the file");
+
+		// Keep a view on the name, the parser holds the data anyways
+		std::string_view key(reinterpret_cast<const char*>(&m_pParser->m_pData[m_pParser->m_Seek]), keyLen);
+		m_pParser->m_Seek += keyLen;
 
-		// Read the keys data from the archive
-		std::vector<uint8_t> keyData(keyLen);
-		m_pParser->readBinaryRaw(keyData.data(), keyLen);
+		if(insIdx >= table->keys.size())
+			table->keys.resize(insIdx + 1);
 
-		// Put the source key together with the insertion index into the map
-		std::string key(keyData.begin(), keyData.end());
-		map[hashValue].push_back( {key, insIdx} );
+		table->keys[insIdx] = key;
+		table->keyIds.emplace(key, insIdx);
 	}
 
+	m_Keys = std::move(table);
+
 	// Restore old position
 	m_pParser->m_Seek = s;
 }
 
+/**
+* @brief Creates an implementation for the given parser, sharing the hash-table read by this one
+*/
+ParserImpl* ParserImplBinSafe::clone(ZenParser* parser) const
+{
+	ParserImplBinSafe* impl = new ParserImplBinSafe(parser);
+	impl->m_Keys = m_Keys;
+
+	return impl;
+}
+
 /**
 * @brief Reads a string
 */
 std::string ParserImplBinSafe::readString()
+{
+	return std::string(readStringView());
+}
+
+/**
+* @brief Reads a string, without copying it
+*/
+std::string_view ParserImplBinSafe::readStringView()
 {
 	EZenValueType type;
 	size_t size;
@@ -231,15 +223,14 @@ std::string ParserImplBinSafe::readString()
 	if(type != ZVT_STRING)
 		throw std::runtime_error("Expected string-type");
 
-	std::string str; str.resize(size);
-	m_pParser->readBinaryRaw(&str[0], size);
+	if(size > m_pParser->m_DataSize - m_pParser->m_Seek)
+		throw std::runtime_error("String exceeds the file");
+
+	std::string_view str(reinterpret_cast<const char*>(&m_pParser->m_pData[m_pParser->m_Seek]), size);
+	m_pParser->m_Seek += size;
 
 	// Skip potential hash-value at the end of the string
-	EZenValueType t = static_cast<EZenValueType>(m_pParser->readBinaryByte());
-	if(t != ZVT_HASH)
-		m_pParser->m_Seek -= sizeof(uint8_t);
-	else
-		m_pParser->m_Seek += sizeof(uint32_t);
+	skipKeyHash();
 
 	return str;
 }
@@ -294,11 +285,14 @@ void ParserImplBinSafe::readEntry(const std::string& expectedName, void* target,
 	EZenValueType type;
 	size_t size;
 
+	// Remember the name of this entry, reading it moves on to the next one
+	uint32_t keyId = m_NextKeyId;
+
 	// Read type and size of the entry
 	readTypeAndSizeBinSafe(type, size);
 
 	if(expectedType != ZVT_0 && type != expectedType)
-		throw std::runtime_error("Valuetype name does not match expected type. Value:" + expectedName);
+		throw std::runtime_error("Valuetype name does not match expected type. Value:" + (expectedName.empty() ? std::string(getKeyName(keyId)) : expectedName));
 
 	switch(type)
 	{
@@ -340,11 +334,7 @@ void ParserImplBinSafe::readEntry(const std::string& expectedName, void* target,
 	}
 
 	// Skip potential hash-value at the end of the entry
-	EZenValueType t = static_cast<EZenValueType>(m_pParser->readBinaryByte());
-	if(t != ZVT_HASH)
-		m_pParser->m_Seek -= sizeof(uint8_t);
-	else
-		m_pParser->m_Seek += sizeof(uint32_t);
+	skipKeyHash();
 }
 
 /**
@@ -353,4 +343,46 @@ void ParserImplBinSafe::readEntry(const std::string& expectedName, void* target,
 void ParserImplBinSafe::readEntryType(EZenValueType& outtype, size_t& size)
 {
 	readTypeAndSizeBinSafe(outtype, size);
+
+	// Hashes are skipped like any other entry from here, but still name the entry after them
+	if(outtype == ZVT_HASH && m_pParser->m_DataSize - m_pParser->m_Seek >= sizeof(uint32_t))
+	{
+		memcpy(&m_NextKeyId, &m_pParser->m_pData[m_pParser->m_Seek], sizeof(uint32_t));
+	}
+}
+
+/**
+* @brief Skips the hash in front of the next entry, if there is one, and remembers the ID it holds
+*/
+void ParserImplBinSafe::skipKeyHash()
+{
+	if(m_pParser->m_Seek >= m_pParser->m_DataSize || m_pParser->m_pData[m_pParser->m_Seek] != ZVT_HASH)
+	{
+		// Chunk-headers and -ends don't have a name
+		m_NextKeyId = INVALID_KEY;
+		return;
+	}
+
+	m_pParser->m_Seek += sizeof(uint8_t);
+	m_NextKeyId = m_pParser->readBinaryDWord();
+}
+
+/**
+* @brief Returns the ID the given property-name has in this archive
+*/
+uint32_t ParserImplBinSafe::findKeyId(std::string_view name) const
+{
+	if(!m_Keys)
+		return INVALID_KEY;
+
+	auto it = m_Keys->keyIds.find(name);
+	return it != m_Keys->keyIds.end() ? it->second : INVALID_KEY;
+}
+
+/**
+* @brief Returns the property-name with the given ID
+*/
+std::string_view ParserImplBinSafe::getKeyName(uint32_t keyId) const
+{
+	return m_Keys && keyId < m_Keys->keys.size() ? m_Keys->keys[keyId] : std::string_view();
 }
\ No newline at end of file
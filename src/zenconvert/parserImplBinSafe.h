@@ -1,5 +1,6 @@
 #pragma once
 #include "parserImpl.h"
+#include <memory>
 
 namespace ZenConvert
 {
@@ -14,6 +15,11 @@ namespace ZenConvert
 		*/
 		virtual void readImplHeader();
 
+		/**
+		* @brief Creates an implementation for the given parser, sharing the header read by this one
+		*/
+		virtual ParserImpl* clone(ZenParser* parser) const;
+
 		/**
 		* @brief Read the start of a chunk. [...] Returns true if there actually was a start. 
 		*		  Otherwise it will leave m_Seek untouched and return false.
@@ -26,6 +32,11 @@ namespace ZenConvert
 		 */
 		virtual bool readChunkEnd();
 
+		/**
+		* @brief Moves past the rest of the current chunk, without reading any of its entries
+		*/
+		virtual bool skipChunk();
+
 		/**
 		* @brief Reads a string
 		*/
@@ -40,13 +51,64 @@ namespace ZenConvert
 		* @brief Reads the type of a single entry
 		*/
 		virtual void readEntryType(EZenValueType& type, size_t& size);
+
+		/**
+		 * @brief Returns the ID of the name of the entry which will be read next, which is the index
+		 *		  of the name in the hash-table of the archive
+		 */
+		virtual uint32_t getNextKeyId() const { return m_NextKeyId; }
+
+		/**
+		 * @brief Returns the ID the given property-name has in this archive
+		 */
+		virtual uint32_t findKeyId(std::string_view name) const;
+
+		/**
+		 * @brief Returns the property-name with the given ID
+		 */
+		virtual std::string_view getKeyName(uint32_t keyId) const;
 	private:
 
-		
+		/**
+		 * @brief Looks at the next entry without reading it. If it is a string, str is pointed to its characters.
+		 *		  Never throws, so it can be used to test what comes next.
+		 * @return False, if the next entry is no string or doesn't fit into the data
+		 */
+		bool peekString(std::string_view& str) const;
+
+		/**
+		 * @brief Reads a string, returning a view into the data of the parser instead of a copy
+		 */
+		std::string_view readStringView();
 
 		/**
 		 * @brief reads the small header in front of datatypes
 		 */
 		void readTypeAndSizeBinSafe(EZenValueType & type, size_t & size);
+
+		/**
+		 * @brief Skips the hash in front of the next entry, if there is one, and remembers the ID it holds
+		 */
+		void skipKeyHash();
+
+		/**
+		 * @brief Names of all properties in this archive, read from its hash-table. Indexed by their ID,
+		 *		  which is what the hashes in front of the entries store. Views point into the data of the parser.
+		 */
+		struct KeyTable
+		{
+			std::vector<std::string_view> keys;
+			std::unordered_map<std::string_view, uint32_t> keyIds;
+		};
+
+		/**
+		 * @brief Never changed once read, so clones of this implementation can share it
+		 */
+		std::shared_ptr<const KeyTable> m_Keys;
+
+		/**
+		 * @brief ID of the name of the entry which will be read next
+		 */
+		uint32_t m_NextKeyId;
 	};
 }
\ No newline at end of file
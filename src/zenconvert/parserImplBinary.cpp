@@ -20,12 +20,9 @@ bool ParserImplBinary::readChunkStart(ZenParser::ChunkHeader& header)
 	m_pParser->skipSpaces();
 
 	// Skip chunk-header
-	std::string name = m_pParser->readLine();
-	std::string classname = m_pParser->readLine();
-
-	header.classname = classname;
+	header.name = m_pParser->readLineView();
+	header.classname = m_pParser->readLineView();
 	header.createObject = true; // TODO: References shouldn't be used in binary zens...
-	header.name = name;
 	header.objectID = objectIndex;
 	header.size = chunksize;
 	header.version = version;
@@ -57,6 +54,14 @@ void ParserImplBinary::readImplHeader()
 	m_pParser->skipSpaces();
 }
 
+/**
+ * @brief Creates an implementation for the given parser. Nothing of the header is kept in here.
+ */
+ParserImpl* ParserImplBinary::clone(ZenParser* parser) const
+{
+	return new ParserImplBinary(parser);
+}
+
 /**
  * @brief Reads a string
  */
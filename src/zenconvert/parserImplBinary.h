@@ -14,6 +14,11 @@ namespace ZenConvert
 		 */
 		virtual void readImplHeader();
 
+		/**
+		 * @brief Creates an implementation for the given parser, sharing the header read by this one
+		 */
+		virtual ParserImpl* clone(ZenParser* parser) const;
+
 		/**
 		* @brief Read the start of a chunk. [...] Returns true if there actually was a start. 
 		*		  Otherwise it will leave m_Seek untouched and return false.
@@ -8,6 +8,35 @@ namespace ZenConvert
 	class zCMaterial
 	{
 	public:
+		/**
+		 * Properties of a zCMaterial, in the order they are stored
+		 */
+		static constexpr auto PROPERTIES = std::make_tuple(
+			Field("MaterialName",					"name", &zCMaterialData::matName),
+			Field("MaterialGroup",					"matGroup", &zCMaterialData::matGroup),
+			Field("Color",							"color", &zCMaterialData::color),
+			Field("SmoothAngle",					"smoothAngle", &zCMaterialData::smoothAngle),
+			Field("Texture",						"texture", &zCMaterialData::texture),
+			Field("TextureScale",					"texScale", &zCMaterialData::texScale),
+			Field("TextureAniFPS",					"texAniFPS", &zCMaterialData::texAniFPS),
+			Field("TextureAniMapMode",				"texAniMapMode", &zCMaterialData::texAniMapMode),
+			Field("TextureAniMapDir",				"texAniMapDir", &zCMaterialData::texAniMapDir),
+			Field("NoCollisionDetection",			"noCollDet", &zCMaterialData::noCollDet),
+			Field("NoLightmap",						"noLightmap", &zCMaterialData::noLighmap),
+			Field("LoadDontCollapse",				"lodDontCollapse", &zCMaterialData::loadDontCollapse),
+			Field("DetailObject",					"detailObject", &zCMaterialData::detailObject),
+			Field("DetailTextureScale",				"detailObjectScale", &zCMaterialData::detailTextureScale),
+			Field("ForceOccluder",					"forceOccluder", &zCMaterialData::forceOccluder),
+			Field("EnvironmentMapping",				"environmentalMapping", &zCMaterialData::environmentMapping),
+			Field("EnvironmentalMappingStrength",	"environmentalMappingStrength", &zCMaterialData::environmentalMappingStrength),
+			Field("WaveMode",						"waveMode", &zCMaterialData::waveMode),
+			Field("WaveSpeed",						"waveSpeed", &zCMaterialData::waveSpeed),
+			Field("WaveMaxAmplitude",				"waveMaxAmplitude", &zCMaterialData::waveMaxAmplitude),
+			Field("WaveGridSize",					"waveGridSize", &zCMaterialData::waveGridSize),
+			Field("IgnoreSun",						"ignoreSunLight", &zCMaterialData::ignoreSun),
+			Field("AlphaFunc",						"alphaFunc", &zCMaterialData::alphaFunc),
+			Field("DefaultMapping",					"defaultMapping", &zCMaterialData::defaultMapping));
+
 		/**
 		 * Reads this object from an internal zen
 		 */
@@ -18,31 +47,7 @@ namespace ZenConvert
 			
 			materialInfo.objectClass = "zCMaterial";
 			
-			ReadObjectProperties(parser,				materialInfo.properties,
-				Prop("MaterialName",					materialInfo.matName),
-				Prop("MaterialGroup",					materialInfo.matGroup),
-				Prop("Color",							materialInfo.color),
-				Prop("SmoothAngle",						materialInfo.smoothAngle),
-				Prop("Texture",							materialInfo.texture),
-				Prop("TextureScale",					materialInfo.texScale),
-				Prop("TextureAniFPS",					materialInfo.texAniFPS),
-				Prop("TextureAniMapMode",				materialInfo.texAniMapMode),
-				Prop("TextureAniMapDir",				materialInfo.texAniMapDir),
-				Prop("NoCollisionDetection",			materialInfo.noCollDet),
-				Prop("NoLightmap",						materialInfo.noLighmap),
-				Prop("LoadDontCollapse",				materialInfo.loadDontCollapse),
-				Prop("DetailObject",					materialInfo.detailObject),
-				Prop("DetailTextureScale",				materialInfo.detailTextureScale),
-				Prop("ForceOccluder",					materialInfo.forceOccluder),
-				Prop("EnvironmentMapping",				materialInfo.environmentMapping),
-				Prop("EnvironmentalMappingStrength",	materialInfo.environmentalMappingStrength),
-				Prop("WaveMode",						materialInfo.waveMode),
-				Prop("WaveSpeed",						materialInfo.waveSpeed),
-				Prop("WaveMaxAmplitude",				materialInfo.waveMaxAmplitude),
-				Prop("WaveGridSize",					materialInfo.waveGridSize),
-				Prop("IgnoreSun",						materialInfo.ignoreSun),
-				Prop("AlphaFunc",						materialInfo.alphaFunc),
-				Prop("DefaultMapping",					materialInfo.defaultMapping));
+			ReadObjectSchema(parser, materialInfo, PROPERTIES);
 
 			return materialInfo;
 		}
@@ -29,14 +29,15 @@ zCMesh::zCMesh(const std::string& fileName, VDFS::FileIndex& fileIndex)
 	ZenConvert::Chunk parentVob("parent", "", 0);
 	ZenConvert::zCMesh worldMesh;
 
-	std::vector<uint8_t> data;
-	fileIndex.getFileData(fileName, data);
+	// Only gets copied into storage if the archive isn't memory mapped
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
+	fileIndex.getFileView(fileName, view, &storage);
 
 	try
 	{
-		// Create parser from memory
-		// FIXME: There is an internal copy of the data here. Optimize!
-		ZenConvert::ZenParser parser(data.data(), data.size());
+		// Create parser from memory. It reads straight from the view, which stays valid for this scope.
+		ZenConvert::ZenParser parser(view.data, view.size);
 		
 		// .MSH-Files are just saved zCMeshes
 		readObjectData(parser, false);
@@ -124,7 +125,8 @@ void zCMesh::readObjectData(ZenParser& parser, bool fromZen)
 				//  - String - Name
 				//  - zCMaterial-Chunk
 
-				ZenParser p2(&parser.getData()[parser.getSeek()], parser.getData().size() - parser.getSeek());
+				// Shares the data of this parser, limited to the chunk
+				ZenParser p2(parser, parser.getSeek(), chunkEnd - parser.getSeek());
 				p2.readHeader();
 
 				// Read number of materials
@@ -133,7 +135,7 @@ void zCMesh::readObjectData(ZenParser& parser, bool fromZen)
 				// Read every stored material
 				for(uint32_t i = 0; i < numMaterials; i++)
 				{
-					p2.readLine(false); // Read unused material name (Stored a second time later)
+					p2.readLineView(false); // Read unused material name (Stored a second time later)
 
 										// Skip chunk headers - we know these are zCMaterial
 					uint32_t chunksize = p2.readBinaryDWord();
@@ -143,8 +145,8 @@ void zCMesh::readObjectData(ZenParser& parser, bool fromZen)
 					p2.skipSpaces();
 
 					// Skip chunk-header
-					std::string name = p2.readLine();
-					std::string classname = p2.readLine();
+					p2.readLineView();
+					p2.readLineView();
 
 					// Save into vector
 					m_Materials.emplace_back(zCMaterial::readObjectData(p2));
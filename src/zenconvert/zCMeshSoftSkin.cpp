@@ -40,7 +40,7 @@ struct oBBox3d
 /**
 * @brief Reads the mesh-object from the given binary stream
 */
-void zCMeshSoftSkin::readObjectData(ZenParser& parser)
+void zCMeshSoftSkin::readObjectData(ZenParser& parser, bool materialsOnly)
 {
 	// Information about the whole file we are reading here
 	BinaryFileInfo fileInfo;
@@ -66,18 +66,30 @@ void zCMeshSoftSkin::readObjectData(ZenParser& parser)
 		{
 			uint32_t version = parser.readBinaryDWord();
 
-			m_Mesh.readObjectData(parser);
+			m_Mesh.readObjectData(parser, materialsOnly);
 
 			uint32_t vertexWeightStreamSize = parser.readBinaryDWord();
 
-			m_VertexWeightStream.resize(vertexWeightStreamSize);
-			parser.readBinaryRaw(m_VertexWeightStream.data(), vertexWeightStreamSize);
+			if(materialsOnly)
+			{
+				parser.setSeek(parser.getSeek() + vertexWeightStreamSize);
+			}
+			else
+			{
+				m_VertexWeightStream.resize(vertexWeightStreamSize);
+				parser.readBinaryRaw(m_VertexWeightStream.data(), vertexWeightStreamSize);
+			}
 
 			uint32_t numNodeWedgeNormals = parser.readBinaryDWord();
-			std::vector<zTNodeWedgeNormal> nodeWedgeNormals(numNodeWedgeNormals);
-
-			if(numNodeWedgeNormals > 0)
+			if(materialsOnly)
+			{
+				parser.setSeek(parser.getSeek() + numNodeWedgeNormals * sizeof(zTNodeWedgeNormal));
+			}
+			else if(numNodeWedgeNormals > 0)
+			{
+				std::vector<zTNodeWedgeNormal> nodeWedgeNormals(numNodeWedgeNormals);
 				parser.readBinaryRaw(nodeWedgeNormals.data(), numNodeWedgeNormals * sizeof(zTNodeWedgeNormal));
+			}
 
 			uint16_t numNodes = parser.readBinaryWord();
 			std::vector<int32_t> nodeList(numNodes);
@@ -20,9 +20,9 @@ namespace ZenConvert
 
 		/**
 		 * @brief Reads the mesh-object from the given binary stream
-		 * @param fromZen Whether this mesh is supposed to be read from a zenfile. In this case, information about the binary chunk is also read.
+		 * @param materialsOnly Only read the materials of the mesh and skip over everything else, see zCProgMeshProto::readObjectData
 		 */
-		void readObjectData(ZenParser& parser);
+		void readObjectData(ZenParser& parser, bool materialsOnly = false);
 
 		/**
 		 * @return Internal zCProgMeshProto of this soft skin. The soft-skin only displaces the vertices found in the ProgMesh.
@@ -72,14 +72,15 @@ void SampleUnpackQuat(const uint16_t* in, Math::float4& out)
 zCModelAni::zCModelAni(const std::string& fileName, const VDFS::FileIndex& fileIndex, float scale)
 {
 
-	std::vector<uint8_t> data;
-	fileIndex.getFileData(fileName, data);
+	// Only gets copied into storage if the archive isn't memory mapped
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
+	fileIndex.getFileView(fileName, view, &storage);
 
 	try
 	{
-		// Create parser from memory
-		// FIXME: There is an internal copy of the data here. Optimize!
-		ZenConvert::ZenParser parser(data.data(), data.size());
+		// Create parser from memory. It reads straight from the view, which stays valid for this scope.
+		ZenConvert::ZenParser parser(view.data, view.size);
 
 		readObjectData(parser);
 
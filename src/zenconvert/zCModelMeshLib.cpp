@@ -30,14 +30,15 @@ const uint16_t MLID_MDH_END	= 0xD120;
 */
 zCModelMeshLib::zCModelMeshLib(const std::string& fileName, const VDFS::FileIndex& fileIndex)
 {
-	std::vector<uint8_t> data;
-	fileIndex.getFileData(fileName, data);
+	// Only gets copied into storage if the archive isn't memory mapped
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
+	fileIndex.getFileView(fileName, view, &storage);
 
 	try
 	{
-		// Create parser from memory
-		// FIXME: There is an internal copy of the data here. Optimize!
-		ZenConvert::ZenParser parser(data.data(), data.size());
+		// Create parser from memory. It reads straight from the view, which stays valid for this scope.
+		ZenConvert::ZenParser parser(view.data, view.size);
 
 		if(fileName.find(".MDM") != std::string::npos)
 			loadMDM(parser);
@@ -56,7 +57,7 @@ zCModelMeshLib::zCModelMeshLib(const std::string& fileName, const VDFS::FileInde
 /**
 * @brief Reads the mesh-object from the given binary stream
 */
-void zCModelMeshLib::loadMDM(ZenParser& parser)
+void zCModelMeshLib::loadMDM(ZenParser& parser, bool materialsOnly)
 {
 	// Information about the whole file we are reading here
 	BinaryFileInfo fileInfo;
@@ -104,7 +105,7 @@ void zCModelMeshLib::loadMDM(ZenParser& parser)
 			for(uint16_t i = 0; i < numNodes; i++)
 			{
 				m_NodeAttachments.emplace_back();
-				m_NodeAttachments.back().readObjectData(parser);
+				m_NodeAttachments.back().readObjectData(parser, materialsOnly);
 			}
 
 			/*if (meshLib) meshLib->AllocNumNodeVisuals(num);
@@ -139,7 +140,7 @@ void zCModelMeshLib::loadMDM(ZenParser& parser)
 			for(uint16_t i = 0; i < numSoftSkins; i++)
 			{
 				m_Meshes.emplace_back();
-				m_Meshes.back().readObjectData(parser);
+				m_Meshes.back().readObjectData(parser, materialsOnly);
 			}
 		}
 		break;
@@ -251,10 +252,10 @@ void zCModelMeshLib::loadMDH(ZenParser& parser)
 /**
 * @brief reads this lib as MDL
 */
-void zCModelMeshLib::loadMDL(ZenParser& parser)
+void zCModelMeshLib::loadMDL(ZenParser& parser, bool materialsOnly)
 {
 	loadMDH(parser);
-	loadMDM(parser);
+	loadMDM(parser, materialsOnly);
 }
 
 /**
@@ -40,9 +40,9 @@ namespace ZenConvert
 
 		/**
 		 * @brief Reads the mesh-object from the given binary stream
-		 * @param fromZen Whether this mesh is supposed to be read from a zenfile. In this case, information about the binary chunk is also read.
+		 * @param materialsOnly Only read the materials of the meshes and skip over their geometry, see zCProgMeshProto::readObjectData
 		 */
-		void loadMDM(ZenParser& parser);
+		void loadMDM(ZenParser& parser, bool materialsOnly = false);
 
 		/**
 		* @brief Reads the model hierachy from a file (MDH-File)
@@ -52,7 +52,7 @@ namespace ZenConvert
 		/**
 		* @brief reads this lib as MDL
 		*/
-		void loadMDL(ZenParser& parser);
+		void loadMDL(ZenParser& parser, bool materialsOnly = false);
 
 		/**
 		 * @brief Creates packed submesh-data
@@ -64,6 +64,11 @@ namespace ZenConvert
 		 */
 		const std::vector<zCMeshSoftSkin>& getMeshes() const { return m_Meshes; }
 
+		/**
+		 * @return List of meshes attached to nodes of the hierachy
+		 */
+		const std::vector<zCProgMeshProto>& getAttachments() const { return m_NodeAttachments; }
+
 		/**
 		 * @return List of nodes in the hierachy
 		 */
@@ -46,14 +46,15 @@ struct MeshOffsetsSubMesh
 zCProgMeshProto::zCProgMeshProto(const std::string& fileName, const VDFS::FileIndex& fileIndex)
 {
 
-	std::vector<uint8_t> data;
-	fileIndex.getFileData(fileName, data);
+	// Only gets copied into storage if the archive isn't memory mapped
+	std::vector<uint8_t> storage;
+	VDFS::FileView view = {};
+	fileIndex.getFileView(fileName, view, &storage);
 
 	try
 	{
-		// Create parser from memory
-		// FIXME: There is an internal copy of the data here. Optimize!
-		ZenConvert::ZenParser parser(data.data(), data.size());
+		// Create parser from memory. It reads straight from the view, which stays valid for this scope.
+		ZenConvert::ZenParser parser(view.data, view.size);
 		
 		readObjectData(parser);
 	}
@@ -67,7 +68,7 @@ zCProgMeshProto::zCProgMeshProto(const std::string& fileName, const VDFS::FileIn
 /**
 * @brief Reads the mesh-object from the given binary stream
 */
-void zCProgMeshProto::readObjectData(ZenParser& parser)
+void zCProgMeshProto::readObjectData(ZenParser& parser, bool materialsOnly)
 {
 	// Information about a single chunk 
 	BinaryChunkInfo chunkInfo;
@@ -92,8 +93,15 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
 				// Read data-pool
 				uint32_t dataSize = parser.readBinaryDWord();
 				std::vector<uint8_t> dataPool;
-				dataPool.resize(dataSize);
-				parser.readBinaryRaw(dataPool.data(), dataSize);
+				if(materialsOnly)
+				{
+					parser.setSeek(parser.getSeek() + dataSize);
+				}
+				else
+				{
+					dataPool.resize(dataSize);
+					parser.readBinaryRaw(dataPool.data(), dataSize);
+				}
 
 				// Read how many submeshes we got
 				uint8_t numSubmeshes = parser.readBinaryByte();
@@ -114,13 +122,14 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
 					//  - String - Name
 					//  - zCMaterial-Chunk
 
-					ZenParser p2(&parser.getData()[parser.getSeek()], parser.getData().size() - parser.getSeek());
+					// Shares the data of this parser. Size of the list isn't known up front, so it may use the rest of the file.
+					ZenParser p2(parser, parser.getSeek(), parser.getFileSize() - parser.getSeek());
 					p2.readHeader();
 
 					// Read every stored material
 					for(uint32_t i = 0; i < numSubmeshes; i++)
 					{
-						p2.readLine(false); // Read unused material name (Stored a second time later)
+						p2.readLineView(false); // Read unused material name (Stored a second time later)
 
 						// Skip chunk headers - we know these are zCMaterial
 						uint32_t chunksize = p2.readBinaryDWord();
@@ -130,8 +139,8 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
 						p2.skipSpaces();
 
 						// Skip chunk-header
-						std::string name = p2.readLine();
-						std::string classname = p2.readLine();
+						p2.readLineView();
+						p2.readLineView();
 
 						// Save into vector
 						m_Materials.emplace_back(zCMaterial::readObjectData(p2));
@@ -140,6 +149,12 @@ void zCProgMeshProto::readObjectData(ZenParser& parser)
 
 				parser.setSeek(p2.getSeek() + parser.getSeek());
 
+				if(materialsOnly)
+				{
+					parser.setSeek(chunkEnd);
+					break;
+				}
+
 				// Read whether we want to have alphatesting
 				m_IsUsingAlphaTest = parser.readBinaryByte() != 0;
 				
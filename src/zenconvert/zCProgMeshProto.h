@@ -38,8 +38,9 @@ namespace ZenConvert
 
 		/**
 		 * @brief Reads the mesh-object from the given binary stream
+		 * @param materialsOnly Only read the materials and skip over the geometry, for looking at what a mesh needs
 		 */
-		void readObjectData(ZenParser& parser);
+		void readObjectData(ZenParser& parser, bool materialsOnly = false);
 
 		/**
 		@ brief returns the vector of vertex-positions
@@ -41,6 +41,28 @@ namespace ZenConvert
 #pragma pack (pop)
 
 	public:
+		/**
+		* Properties of a zCVob which isn't packed, in the order they are stored
+		*/
+		static constexpr auto PROPERTIES = std::make_tuple(
+			Field("PresetName", "presetName", &zCVobData::presetName),
+			Raw("BBox", "bbox3DWS", &zCVobData::bbox, ParserImpl::ZVT_RAW_FLOAT),
+			Raw("RotationMatrix", "trafoOSToWSRot", &zCVobData::rotationMatrix3x3, ParserImpl::ZVT_RAW),
+			Field("Position", "trafoOSToWSPos", &zCVobData::position),
+			Field("VobName", "vobName", &zCVobData::vobName),
+			Field("VisualName", "visual", &zCVobData::visual),
+			Field("ShowVisual", "showVisual", &zCVobData::showVisual),
+			Field("VisualCamAlign", "visualCamAlign", &zCVobData::visualCamAlign),
+			Field("VisualAniMode", "visualAniMode", &zCVobData::visualAniMode),
+			Field("VisualAniModeStrength", "visualAniModeStrength", &zCVobData::visualAniModeStrength),
+			Field("VobFarClipScale", "vobFarClipZScale", &zCVobData::vobFarClipScale),
+			Field("CollisionDetectionStatic", "cdStatic", &zCVobData::cdStatic),
+			Field("CollisionDetectionDyn", "cdDyn", &zCVobData::cdDyn),
+			Field("StaticVob", "staticVob", &zCVobData::staticVob),
+			Field("DynamicShadow", "dynShadow", &zCVobData::dynamicShadow),
+			Field("zBias", "zbias", &zCVobData::zBias),
+			Field("IsAmbient", "isAmbient", &zCVobData::isAmbient));
+
 		/**
 		* Reads this object from an internal zen
 		*/
@@ -87,48 +109,19 @@ namespace ZenConvert
 				if(pd.bitfield.hasVisualName)
 					parser.getImpl()->readEntry("", &info.visual, 0, ZenConvert::ParserImpl::ZVT_STRING);
 	
-				info.properties.insert(std::make_pair("PresetName", info.presetName));
-				info.properties.insert(std::make_pair("BBoxMin", info.bbox[0].toString()));
-				info.properties.insert(std::make_pair("BBoxMax", info.bbox[1].toString()));
-				info.properties.insert(std::make_pair("RotationMatrix", info.rotationMatrix.toString()));
-				info.properties.insert(std::make_pair("Position", info.position.toString()));
-				info.properties.insert(std::make_pair("VobName", info.vobName));
-				info.properties.insert(std::make_pair("VisualName", info.visual));
-				info.properties.insert(std::make_pair("ShowVisual", std::to_string(info.showVisual ? 1 : 0)));
-				info.properties.insert(std::make_pair("VisualCamAlign", std::to_string(info.visualCamAlign)));
-				info.properties.insert(std::make_pair("VisualAniMode", std::to_string(info.visualAniMode)));
-				info.properties.insert(std::make_pair("VisualAniModeStrength", std::to_string(info.visualAniModeStrength)));
-				info.properties.insert(std::make_pair("VobFarClipScale", std::to_string(info.vobFarClipScale)));
-				info.properties.insert(std::make_pair("CollisionDetectionStatic", std::to_string(info.cdStatic ? 1 : 0)));
-				info.properties.insert(std::make_pair("CollisionDetectionDyn", std::to_string(info.cdDyn ? 1 : 0)));
-				info.properties.insert(std::make_pair("StaticVob", std::to_string(info.staticVob ? 1 : 0)));
-				info.properties.insert(std::make_pair("DynamicShadow", std::to_string(info.dynamicShadow ? 1 : 0)));
-				info.properties.insert(std::make_pair("zBias", std::to_string(info.zBias)));
-				info.properties.insert(std::make_pair("IsAmbient", std::to_string(info.isAmbient ? 1 : 0)));
+				if(parser.getReadPropertyStrings())
+				{
+					WriteObjectSchemaStrings(info, PROPERTIES, info.properties);
+
+					// The packed layout stores these in a form the schema doesn't have
+					info.properties.insert(std::make_pair("BBoxMin", info.bbox[0].toString()));
+					info.properties.insert(std::make_pair("BBoxMax", info.bbox[1].toString()));
+					info.properties.insert(std::make_pair("RotationMatrix", info.rotationMatrix.toString()));
+				}
 			}
 			else
 			{
-				ReadObjectProperties(parser, info.properties,
-					Prop("PresetName", info.presetName));
-
-				parser.getImpl()->readEntry("", info.bbox, sizeof(info.bbox), ZenConvert::ParserImpl::ZVT_RAW_FLOAT);
-				parser.getImpl()->readEntry("", &info.rotationMatrix3x3, sizeof(info.rotationMatrix3x3), ZenConvert::ParserImpl::ZVT_RAW);
-				
-				ReadObjectProperties(parser, info.properties,
-					Prop("Position", info.position),
-					Prop("VobName", info.vobName),
-					Prop("VisualName", info.visual),
-					Prop("ShowVisual", info.showVisual),
-					Prop("VisualCamAlign", info.visualCamAlign),
-					Prop("VisualAniMode", info.visualAniMode),
-					Prop("VisualAniModeStrength", info.visualAniModeStrength),
-					Prop("VobFarClipScale", info.vobFarClipScale),
-					Prop("CollisionDetectionStatic", info.cdStatic),
-					Prop("CollisionDetectionDyn", info.cdDyn),
-					Prop("StaticVob", info.staticVob),
-					Prop("DynamicShadow", info.dynamicShadow),
-					Prop("zBias", info.zBias),
-					Prop("IsAmbient", info.isAmbient)); // TODO: References!
+				ReadObjectSchema(parser, info, PROPERTIES); // TODO: References!
 			}
 			parser.skipChunk();
 
@@ -0,0 +1,383 @@
+#include "zenChunkIndex.h"
+#include "zenParser.h"
+#include "parserImpl.h"
+#include "zCVob.h"
+#include "zenTokenizer.h"
+#include "utils/logger.h"
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+
+using namespace ZenConvert;
+
+namespace
+{
+	const uint32_t INDEX_MAGIC = 0x5844495A; // "ZIDX"
+	const uint32_t INDEX_VERSION = 2;
+
+	/**
+	 * @brief FNV-1a over the data, continuing the given hash
+	 */
+	uint64_t fnv1a(const uint8_t* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		for(size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	template<typename T>
+	void put(std::vector<uint8_t>& out, const T& value)
+	{
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+
+	/**
+	 * @brief Reads values from a loaded index-file, without going past its end
+	 */
+	struct IndexReader
+	{
+		const std::vector<uint8_t>& data;
+		size_t seek;
+
+		template<typename T>
+		bool get(T& value)
+		{
+			if(data.size() - seek < sizeof(T))
+				return false;
+
+			memcpy(&value, &data[seek], sizeof(T));
+			seek += sizeof(T);
+			return true;
+		}
+
+		bool getString(std::string& value, size_t size)
+		{
+			if(data.size() - seek < size)
+				return false;
+
+			value.assign(reinterpret_cast<const char*>(&data[seek]), size);
+			seek += size;
+			return true;
+		}
+	};
+}
+
+/**
+ * @brief Records all vobs of the world the given parser holds
+ */
+void ChunkIndex::build(ZenParser& parser)
+{
+	size_t seek = parser.getSeek();
+
+	m_Vobs.clear();
+	m_DataSize = parser.getFileSize();
+	m_HeaderSize = seek;
+	m_VobTreeStart = m_VobTreeEnd = seek;
+
+	ZenParser::ChunkHeader header;
+	parser.readChunkStart(header);
+
+	if(header.classname != "oCWorld:zCWorld")
+		throw std::runtime_error("Expected oCWorld:zCWorld-Chunk not found!");
+
+	// Same walk as oCWorld::readObjectData, skipping everything but the vob-tree
+	while(!parser.readChunkEnd())
+	{
+		size_t chunkStart = parser.getSeek();
+		parser.readChunkStart(header);
+
+		if(header.name == "MeshAndBsp")
+		{
+			parser.skipWorldMesh();
+			parser.readChunkEnd();
+		}
+		else if(header.name == "VobTree")
+		{
+			uint32_t numChildren;
+			parser.getImpl()->readEntry("", &numChildren, sizeof(numChildren), ParserImpl::ZVT_INT);
+
+			for(uint32_t i = 0; i < numChildren; i++)
+			{
+				indexVobTree(parser, NO_PARENT);
+			}
+			parser.readChunkEnd();
+
+			m_VobTreeStart = chunkStart;
+			m_VobTreeEnd = parser.getSeek();
+		}
+		else
+		{
+			parser.skipChunk();
+		}
+	}
+
+	m_DataHash = hashData(parser.getData());
+	parser.setSeek(seek);
+}
+
+/**
+ * @brief Records the vob the parser is at and its children
+ */
+void ChunkIndex::indexVobTree(ZenParser& parser, uint32_t parent)
+{
+	uint32_t numChildren;
+	size_t start = parser.getSeek();
+
+	ZenParser::ChunkHeader header;
+	parser.readChunkStart(header);
+
+	if(header.classname == "\xA7")
+	{
+		parser.skipChunk();
+		parser.getImpl()->readEntry("", &numChildren, sizeof(numChildren), ParserImpl::ZVT_INT);
+		return;
+	}
+
+	VobEntry entry;
+	entry.classname = std::string(header.classname);
+	entry.objectID = header.objectID;
+	entry.start = start;
+	entry.parent = parent;
+
+	// The bounding-box is only known after reading the vob, which also moves past the chunk
+	zCVobData vob = zCVob::readObjectData(parser);
+	entry.end = parser.getSeek();
+	entry.bbox[0] = vob.bbox[0];
+	entry.bbox[1] = vob.bbox[1];
+
+	uint32_t index = static_cast<uint32_t>(m_Vobs.size());
+	m_Vobs.push_back(entry);
+
+	parser.getImpl()->readEntry("", &numChildren, sizeof(numChildren), ParserImpl::ZVT_INT);
+	for(uint32_t i = 0; i < numChildren; i++)
+	{
+		indexVobTree(parser, index);
+	}
+}
+
+/**
+ * @brief Writes the index to the given file
+ */
+bool ChunkIndex::save(const std::string& file) const
+{
+	std::vector<uint8_t> out;
+	put(out, INDEX_MAGIC);
+	put(out, INDEX_VERSION);
+	put(out, m_DataSize);
+	put(out, m_DataHash);
+	put(out, m_HeaderSize);
+	put(out, m_VobTreeStart);
+	put(out, m_VobTreeEnd);
+	put(out, static_cast<uint32_t>(m_Vobs.size()));
+
+	for(const VobEntry& e : m_Vobs)
+	{
+		put(out, static_cast<uint16_t>(e.classname.size()));
+		out.insert(out.end(), e.classname.begin(), e.classname.end());
+		put(out, e.objectID);
+		put(out, e.start);
+		put(out, e.end);
+		put(out, e.parent);
+
+		for(size_t i = 0; i < 2; i++)
+		{
+			put(out, e.bbox[i].x);
+			put(out, e.bbox[i].y);
+			put(out, e.bbox[i].z);
+		}
+	}
+
+	// Write to a temporary file first, so a crash never leaves a broken index behind
+	std::string tmpFile = file + ".tmp";
+	std::ofstream f(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!f.good())
+	{
+		LogError() << "Failed to open file for writing: " << tmpFile;
+		return false;
+	}
+
+	f.write(reinterpret_cast<const char*>(out.data()), out.size());
+	f.close();
+
+	bool ok = f.good();
+	if(ok)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		// Rename doesn't replace existing files here
+		remove(file.c_str());
+#endif
+		ok = rename(tmpFile.c_str(), file.c_str()) == 0;
+	}
+
+	if(!ok)
+	{
+		LogError() << "Failed to write chunk-index: " << file;
+		remove(tmpFile.c_str());
+	}
+
+	return ok;
+}
+
+/**
+ * @brief Reads an index written by save
+ */
+bool ChunkIndex::load(const std::string& file, const ZenParser& parser)
+{
+	std::ifstream f(file, std::ios::in | std::ios::ate | std::ios::binary);
+	if(!f.good())
+		return false;
+
+	std::vector<uint8_t> data(static_cast<size_t>(f.tellg()));
+	f.seekg(0, std::ios::beg);
+	f.read(reinterpret_cast<char*>(data.data()), data.size());
+	if(!f.good())
+		return false;
+
+	IndexReader r{data, 0};
+
+	uint32_t magic, version, numVobs;
+	uint64_t dataSize, dataHash, headerSize, vobTreeStart, vobTreeEnd;
+	if(!r.get(magic) || !r.get(version) || !r.get(dataSize) || !r.get(dataHash)
+		|| !r.get(headerSize) || !r.get(vobTreeStart) || !r.get(vobTreeEnd) || !r.get(numVobs))
+		return false;
+
+	if(magic != INDEX_MAGIC || version != INDEX_VERSION)
+		return false;
+
+	// Index of an other, or changed, file?
+	if(dataSize != parser.getFileSize())
+		return false;
+
+	if(headerSize > dataSize || vobTreeStart > vobTreeEnd || vobTreeEnd > dataSize)
+	{
+		LogWarn() << "Broken chunk-index: " << file;
+		return false;
+	}
+
+	ChunkIndex loaded;
+	loaded.m_DataSize = dataSize;
+	loaded.m_HeaderSize = headerSize;
+	loaded.m_VobTreeStart = vobTreeStart;
+	loaded.m_VobTreeEnd = vobTreeEnd;
+	loaded.m_DataHash = dataHash;
+	if(dataHash != loaded.hashData(parser.getData()))
+		return false;
+
+	// Smallest possible entry has an empty classname
+	const size_t minEntrySize = sizeof(uint16_t) + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2 + sizeof(float) * 6;
+	if(numVobs > (data.size() - r.seek) / minEntrySize)
+		return false;
+
+	loaded.m_Vobs.resize(numVobs);
+	for(uint32_t index = 0; index < numVobs; index++)
+	{
+		VobEntry& e = loaded.m_Vobs[index];
+
+		uint16_t classLen;
+		if(!r.get(classLen) || !r.getString(e.classname, classLen)
+			|| !r.get(e.objectID) || !r.get(e.start) || !r.get(e.end) || !r.get(e.parent))
+			return false;
+
+		for(size_t i = 0; i < 2; i++)
+		{
+			if(!r.get(e.bbox[i].x) || !r.get(e.bbox[i].y) || !r.get(e.bbox[i].z))
+				return false;
+		}
+
+		// Parents are always written before their children
+		if(e.start >= e.end || e.end > dataSize || (e.parent != NO_PARENT && e.parent >= index))
+		{
+			LogWarn() << "Broken chunk-index: " << file;
+			return false;
+		}
+	}
+
+	*this = std::move(loaded);
+
+	return true;
+}
+
+/**
+ * @brief Returns the indices of all vobs of the given class, including derived ones
+ */
+std::vector<size_t> ChunkIndex::findByClass(const std::string& classname) const
+{
+	std::vector<size_t> result;
+	for(size_t i = 0; i < m_Vobs.size(); i++)
+	{
+		// Classnames list the whole hierarchy, like "oCItem:zCVob"
+		std::string_view hierarchy = m_Vobs[i].classname;
+		while(!hierarchy.empty())
+		{
+			if(Tokenizer::nextToken(hierarchy, ':') == classname)
+			{
+				result.push_back(i);
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Returns the indices of all vobs whose bounding-box touches the given one
+ */
+std::vector<size_t> ChunkIndex::findInBox(const Math::float3& min, const Math::float3& max) const
+{
+	std::vector<size_t> result;
+	for(size_t i = 0; i < m_Vobs.size(); i++)
+	{
+		const Math::float3* b = m_Vobs[i].bbox;
+		if(b[0].x <= max.x && b[1].x >= min.x
+			&& b[0].y <= max.y && b[1].y >= min.y
+			&& b[0].z <= max.z && b[1].z >= min.z)
+		{
+			result.push_back(i);
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Reads the given vobs from the parser the index was built with
+ */
+std::vector<zCVobData> ChunkIndex::readVobs(ZenParser& parser, const std::vector<size_t>& indices) const
+{
+	size_t seek = parser.getSeek();
+
+	std::vector<zCVobData> result;
+	result.reserve(indices.size());
+
+	for(size_t i : indices)
+	{
+		if(i >= m_Vobs.size())
+			throw std::runtime_error("Vob-index out of range");
+
+		parser.setSeek(m_Vobs[i].start);
+
+		ZenParser::ChunkHeader header;
+		if(!parser.readChunkStart(header) || header.objectID != m_Vobs[i].objectID)
+			throw std::runtime_error("No matching vob-chunk where the chunk-index says");
+
+		result.push_back(zCVob::readObjectData(parser));
+	}
+
+	parser.setSeek(seek);
+	return result;
+}
+
+/**
+ * @brief Hash of the header and the vob-tree of the given data
+ */
+uint64_t ChunkIndex::hashData(const uint8_t* data) const
+{
+	uint64_t hash = fnv1a(data, m_HeaderSize);
+	return fnv1a(data + m_VobTreeStart, m_VobTreeEnd - m_VobTreeStart, hash);
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "utils/mathlib.h"
+#include "zTypes.h"
+
+namespace ZenConvert
+{
+	class ZenParser;
+
+	/**
+	 * @brief Index of where the vobs of a world-ZEN are stored, so a part of the world can be read without going
+	 *		  through the whole file. Building it reads the world once. It can be saved next to the ZEN and loaded
+	 *		  again, as long as the header and the vob-tree of the ZEN don't change.
+	 */
+	class ChunkIndex
+	{
+	public:
+
+		/**
+		 * @brief Parent of the vobs directly in the vob-tree of the world
+		 */
+		static const uint32_t NO_PARENT = 0xFFFFFFFF;
+
+		/**
+		 * @brief One vob-chunk of the world. References to other vobs are not listed.
+		 */
+		struct VobEntry
+		{
+			std::string classname;
+			uint32_t objectID;
+			uint64_t start; // Seek of the chunk-header
+			uint64_t end; // Seek right after the chunk, where the count of its children follows
+			uint32_t parent; // Index of the parent-entry or NO_PARENT
+			Math::float3 bbox[2];
+		};
+
+		/**
+		 * @brief Records all vobs of the world the given parser holds. readHeader has to be done already.
+		 *		  The seek of the parser is restored afterwards. Throws if the world is broken.
+		 */
+		void build(ZenParser& parser);
+
+		/**
+		 * @brief Writes the index to the given file
+		 * @return False, if the file could not be written
+		 */
+		bool save(const std::string& file) const;
+
+		/**
+		 * @brief Reads an index written by save. The index is only taken if the size, the header and the vob-tree
+		 *		  of the data the given parser holds are still the ones it was built from.
+		 * @return False, if the file could not be read, is broken or belongs to different data
+		 */
+		bool load(const std::string& file, const ZenParser& parser);
+
+		/**
+		 * @brief Returns the indices of all vobs of the given class, including derived ones.
+		 *		  "oCMobInter" finds "oCMobContainer:oCMobInter:oCMOB:zCVob" as well.
+		 */
+		std::vector<size_t> findByClass(const std::string& classname) const;
+
+		/**
+		 * @brief Returns the indices of all vobs whose bounding-box touches the given one
+		 */
+		std::vector<size_t> findInBox(const Math::float3& min, const Math::float3& max) const;
+
+		/**
+		 * @brief Reads the given vobs from the parser the index was built with. Only the vobs themselves are read,
+		 *		  their childVobs stay empty. The seek of the parser is restored afterwards.
+		 */
+		std::vector<zCVobData> readVobs(ZenParser& parser, const std::vector<size_t>& indices) const;
+
+		/**
+		 * @brief Returns all recorded vobs, in the order of the file
+		 */
+		const std::vector<VobEntry>& getVobs() const { return m_Vobs; }
+
+	private:
+
+		/**
+		 * @brief Records the vob the parser is at and its children
+		 */
+		void indexVobTree(ZenParser& parser, uint32_t parent);
+
+		/**
+		 * @brief Hash of the header and the vob-tree of the given data, to tell whether an index belongs to it.
+		 *		  Hashing only these keeps loading an index cheap, the world-mesh is most of a ZEN.
+		 */
+		uint64_t hashData(const uint8_t* data) const;
+
+		/**
+		 * @brief All vobs, parents before their children
+		 */
+		std::vector<VobEntry> m_Vobs;
+
+		/**
+		 * @brief Size and hash of the data the index was built from. The header ends at m_HeaderSize,
+		 *		  the vob-tree chunk spans m_VobTreeStart to m_VobTreeEnd.
+		 */
+		uint64_t m_DataSize = 0;
+		uint64_t m_DataHash = 0;
+		uint64_t m_HeaderSize = 0;
+		uint64_t m_VobTreeStart = 0;
+		uint64_t m_VobTreeEnd = 0;
+	};
+}
@@ -8,6 +8,7 @@
 #include "utils/logger.h"
 #include "oCWorld.h"
 #include "zCMesh.h"
+#include "zenTokenizer.h"
 
 using namespace ZenConvert;
 
@@ -20,26 +21,54 @@ using namespace ZenConvert;
 * @brief reads a zen from a file
 */
 ZenParser::ZenParser(const std::string& file) :
+	m_pParserImpl(nullptr),
+	m_pData(nullptr),
+	m_DataSize(0),
 	m_Seek(0),
-	m_pWorldMesh(0)
+	m_pWorldMesh(0),
+	m_ReadPropertyStrings(false)
 {
 	// Get data from zenfile
-	readFile(file, m_Data);
+	readFile(file, m_DataStorage);
+
+	m_pData = m_DataStorage.data();
+	m_DataSize = m_DataStorage.size();
 }
 
 /**
  * @brief reads a zen from memory
  */
 ZenParser::ZenParser(const void* data, size_t size) :
+	m_pParserImpl(nullptr),
+	m_pData(reinterpret_cast<const uint8_t*>(data)),
+	m_DataSize(size),
+	m_Seek(0),
+	m_pWorldMesh(0),
+	m_ReadPropertyStrings(false)
+{
+}
+
+/**
+ * @brief Creates a parser over a part of the given parsers data
+ */
+ZenParser::ZenParser(const ZenParser& parent, size_t offset, size_t size) :
+	m_pParserImpl(nullptr),
+	m_pData(nullptr),
+	m_DataSize(size),
 	m_Seek(0),
-	m_pWorldMesh(0)
+	m_pWorldMesh(0),
+	m_ReadPropertyStrings(parent.m_ReadPropertyStrings)
 {
-	m_Data.resize(size);
-	memcpy(m_Data.data(), data, size);
+	// Always throw, callers would go on reading from a null-pointer otherwise
+	if(offset > parent.m_DataSize || size > parent.m_DataSize - offset)
+		throw std::runtime_error("Sub-parser out of range");
+
+	m_pData = parent.m_pData + offset;
 }
 
 ZenConvert::ZenParser::~ZenParser()
 {
+	delete m_pParserImpl;
 	delete m_pWorldMesh;
 }
 
@@ -70,9 +99,9 @@ bool ZenParser::readFile(const std::string& fileName, std::vector<uint8_t>& data
 /**
 * @brief returns whether the given string is a number
 */
-bool ZenParser::isNumber(const std::string &expr)
+bool ZenParser::isNumber(std::string_view expr)
 {
-	return !expr.empty() && std::find_if(expr.begin(), expr.end(), [](char c){return !std::isdigit(c); }) == expr.end();
+	return Tokenizer::isNumber(expr);
 }
 
 /**
@@ -139,6 +168,29 @@ void ZenParser::readHeader()
 	m_pParserImpl->readImplHeader();
 }
 
+/**
+* @brief Takes over the header the given parser has read
+*/
+void ZenParser::copyHeader(const ZenParser& other)
+{
+	if(!other.m_pParserImpl)
+	{
+		ERROR("Header not read yet");
+		return;
+	}
+
+	if(m_pData != other.m_pData)
+	{
+		ERROR("Parsers work on different data");
+		return;
+	}
+
+	m_Header = other.m_Header;
+
+	delete m_pParserImpl;
+	m_pParserImpl = other.m_pParserImpl->clone(this);
+}
+
 /**
 * @brief reads the main oCWorld-Object, found in the level-zens
 */
@@ -172,6 +224,15 @@ void ZenParser::readWorldMesh()
 	}
 }
 
+/**
+* @brief moves past the worldmesh-chunk without reading it
+*/
+void ZenParser::skipWorldMesh()
+{
+	readBinaryDWord(); // Version
+	m_Seek += readBinaryDWord();
+}
+
 /**
 * @brief reads a full chunk (TESTING ONLY)
 */
@@ -244,6 +305,10 @@ bool ZenParser::readChunkEnd()
  */
 void ZenParser::skipChunk()
 {
+	// Most formats can find the end without reading the entries
+	if(m_pParserImpl->skipChunk())
+		return;
+
 	size_t level = 1;
 
 	do
@@ -287,13 +352,12 @@ void ZenParser::skipEntry()
 int32_t ZenParser::readIntASCII()
 {
 	skipSpaces();
-	std::string number;
-	while(m_Data[m_Seek] >= '0' && m_Data[m_Seek] <= '9')
-	{
-		number += m_Data[m_Seek];
+
+	size_t start = m_Seek;
+	while(m_Seek < m_DataSize && m_pData[m_Seek] >= '0' && m_pData[m_Seek] <= '9')
 		++m_Seek;
-	}
-	return std::stoi(number);
+
+	return Tokenizer::toNumber<int32_t>(std::string_view(reinterpret_cast<const char*>(&m_pData[start]), m_Seek - start));
 }
 
 /**
@@ -302,11 +366,17 @@ int32_t ZenParser::readIntASCII()
 bool ZenParser::readBoolASCII()
 {
 	skipSpaces();
-	bool retVal;
-	if(m_Data[m_Seek] != '0' && m_Data[m_Seek] != '1')
+	if(m_Seek >= m_DataSize)
+	{
+		ERROR("Expected a bool, found the end of the data");
+		return false;
+	}
+
+	bool retVal = false;
+	if(m_pData[m_Seek] != '0' && m_pData[m_Seek] != '1')
 		ERROR("Value is not a bool");
 	else
-		retVal = m_Data[m_Seek] == '0' ? false : true;
+		retVal = m_pData[m_Seek] == '1';
 
 	++m_Seek;
 	return retVal;
@@ -316,38 +386,47 @@ bool ZenParser::readBoolASCII()
  * @brief Reads a string until \r, \n or a space is found
  */
 std::string ZenParser::readString(bool skip)
+{
+	return std::string(readStringView(skip));
+}
+
+/**
+ * @brief Reads a string until \r, \n or a space is found, without copying it
+ */
+std::string_view ZenParser::readStringView(bool skip)
 {
 	if(skip)
 		skipSpaces();
 
-	std::string str;
-	while(m_Data[m_Seek] != '\r' && m_Data[m_Seek] != '\n' && m_Data[m_Seek] != ' ')
-	{
-		str += m_Data[m_Seek];
+	size_t start = m_Seek;
+	while(m_Seek < m_DataSize && m_pData[m_Seek] != '\r' && m_pData[m_Seek] != '\n' && m_pData[m_Seek] != ' ')
 		++m_Seek;
-	}
-	return str;
+
+	return std::string_view(reinterpret_cast<const char*>(&m_pData[start]), m_Seek - start);
 }
 
 /**
  * @brief skips a string and checks if it matches the given expected one
  */
-bool ZenParser::skipString(const std::string &pattern)
+bool ZenParser::skipString(std::string_view pattern)
 {
 	skipSpaces();
 	bool retVal = true;
 	if(pattern.empty())
 	{
-		while(!(m_Data[m_Seek] == '\n' || m_Data[m_Seek] == ' '))
+		while(m_Seek < m_DataSize && m_pData[m_Seek] != '\n' && m_pData[m_Seek] != ' ')
+			++m_Seek;
+
+		// Also skip the separator, if the data didn't end before it
+		if(m_Seek < m_DataSize)
 			++m_Seek;
-		++m_Seek;
 	}
 	else
 	{
 		size_t lineSeek = 0;
 		while(lineSeek < pattern.size())
 		{
-			if(m_Data[m_Seek] != pattern[lineSeek])
+			if(m_Seek >= m_DataSize || m_pData[m_Seek] != pattern[lineSeek])
 			{
 				retVal = false;
 				break;
@@ -367,9 +446,9 @@ bool ZenParser::skipString(const std::string &pattern)
 void ZenParser::skipSpaces()
 {
 	bool search = true;
-	while(search && m_Seek < m_Data.size())
+	while(search && m_Seek < m_DataSize)
 	{
-		switch(m_Data[m_Seek])
+		switch(m_pData[m_Seek])
 		{
 		case ' ':
 		case '\r':
@@ -389,7 +468,7 @@ void ZenParser::skipSpaces()
 */
 void ZenParser::checkArraySize()
 {
-	if(m_Seek >= m_Data.size())
+	if(m_Seek >= m_DataSize)
 		throw std::logic_error("Out of range");
 }
 
@@ -398,35 +477,35 @@ void ZenParser::checkArraySize()
 */
 uint32_t ZenParser::readBinaryDWord()
 {
-	uint32_t retVal = *reinterpret_cast<uint32_t *>(&m_Data[m_Seek]);
+	uint32_t retVal = *reinterpret_cast<const uint32_t *>(&m_pData[m_Seek]);
 	m_Seek += sizeof(uint32_t);
 	return retVal;
 }
 
 uint16_t ZenParser::readBinaryWord()
 {
-	uint16_t retVal = *reinterpret_cast<uint16_t *>(&m_Data[m_Seek]);
+	uint16_t retVal = *reinterpret_cast<const uint16_t *>(&m_pData[m_Seek]);
 	m_Seek += sizeof(uint16_t);
 	return retVal;
 }
 
 uint8_t ZenParser::readBinaryByte()
 {
-	uint8_t retVal = *reinterpret_cast<uint8_t *>(&m_Data[m_Seek]);
+	uint8_t retVal = *reinterpret_cast<const uint8_t *>(&m_pData[m_Seek]);
 	m_Seek += sizeof(uint8_t);
 	return retVal;
 }
 
 float ZenParser::readBinaryFloat()
 {
-	float retVal = *reinterpret_cast<float *>(&m_Data[m_Seek]);
+	float retVal = *reinterpret_cast<const float *>(&m_pData[m_Seek]);
 	m_Seek += sizeof(float);
 	return retVal;
 }
 
 void ZenParser::readBinaryRaw(void* target, size_t numBytes)
 {
-	memcpy(target, &m_Data[m_Seek], numBytes);
+	memcpy(target, &m_pData[m_Seek], numBytes);
 	m_Seek += numBytes;
 }
 
@@ -436,18 +515,28 @@ void ZenParser::readBinaryRaw(void* target, size_t numBytes)
 */
 std::string ZenParser::readLine(bool skip)
 {
-	std::string retVal;
-	while(m_Data[m_Seek] != '\r' && m_Data[m_Seek] != '\n' && m_Data[m_Seek] != '\0')
-	{
-		checkArraySize();
-		retVal += m_Data[m_Seek++];
-	}
+	return std::string(readLineView(skip));
+}
+
+/**
+* @brief Reads a line to \r or \n, without copying it
+*/
+std::string_view ZenParser::readLineView(bool skip)
+{
+	size_t start = m_Seek;
+	while(m_Seek < m_DataSize && m_pData[m_Seek] != '\r' && m_pData[m_Seek] != '\n' && m_pData[m_Seek] != '\0')
+		++m_Seek;
+
+	// Line has to end before the file does
+	checkArraySize();
+
+	std::string_view line(reinterpret_cast<const char*>(&m_pData[start]), m_Seek - start);
 
 	// Skip trailing \n\r\0
-	//if(m_Header.fileType == FT_BINARY)
 	m_Seek++;
 
 	if(skip)
 		skipSpaces();
-	return retVal;
+
+	return line;
 }
\ No newline at end of file
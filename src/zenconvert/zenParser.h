@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include "utils/mathlib.h"
@@ -32,7 +33,8 @@ namespace ZenConvert
 		};
 
 		/**
-		 * @brief Information about one of the chunks in a zen-file
+		 * @brief Information about one of the chunks in a zen-file. name and classname point into the data
+		 *		  of the parser, so they are only valid as long as the parser is.
 		 */
 		struct ChunkHeader
 		{
@@ -40,8 +42,8 @@ namespace ZenConvert
 			uint32_t size;
 			uint16_t version;
 			uint32_t objectID;
-			std::string name;
-			std::string classname;
+			std::string_view name;
+			std::string_view classname;
 			bool createObject;
 		};
 
@@ -69,11 +71,25 @@ namespace ZenConvert
 		ZenParser(const std::string& file);
 
 		/**
-		* @brief reads a zen from memory
+		* @brief reads a zen from memory. The data is not copied, so it has to stay alive
+		*		 and unchanged for as long as this parser is used.
 		*/
 		ZenParser(const void* data, size_t size);
+
+		/**
+		* @brief Creates a parser over size bytes of the given parsers data, starting at offset, without copying anything.
+		*		 Seeks of the new parser are relative to offset. The parent has to stay alive while this is used.
+		*/
+		ZenParser(const ZenParser& parent, size_t offset, size_t size);
 		~ZenParser();
 
+		/**
+		* @brief Not copyable, the parser owns its implementation and m_pData may point into its own storage.
+		*		 Use the sub-parser constructor or copyHeader to share data and format instead.
+		*/
+		ZenParser(const ZenParser&) = delete;
+		ZenParser& operator=(const ZenParser&) = delete;
+
 		/**
 		* @brief Reads the given type as binary data and returns it
 		*/
@@ -88,10 +104,15 @@ namespace ZenConvert
 		 */
 		std::string readLine(bool skipSpaces = true);
 
+		/**
+		 * @brief Same as readLine, but returns a view into the loaded data instead of a copy
+		 */
+		std::string_view readLineView(bool skipSpaces = true);
+
 		/**
 		 * @brief skips a string and checks if it matches the given expected one
 		 */
-		bool skipString(const std::string &pattern = std::string());
+		bool skipString(std::string_view pattern = std::string_view());
 
 		/**
 		 * @brief Skips all whitespace-characters until it hits a non-whitespace one
@@ -108,6 +129,11 @@ namespace ZenConvert
 		 */
 		std::string readString(bool skipSpaces = true);
 
+		/**
+		 * @brief Same as readString, but returns a view into the loaded data instead of a copy
+		 */
+		std::string_view readStringView(bool skipSpaces = true);
+
 		/**
 		 * @brief reads an ASCII datatype from the loaded file
 		 */
@@ -117,7 +143,7 @@ namespace ZenConvert
 		/**
 		 * @brief returns whether the given string is a number
 		 */
-		bool isNumber(const std::string &expr);
+		bool isNumber(std::string_view expr);
 
 		/**
 		 * @brief returns the current implementatio
@@ -140,9 +166,17 @@ namespace ZenConvert
 		void setSeek(size_t seek) { m_Seek = seek; }
 
 		/**
-		 * @brief Returns the data-array
+		 * @brief Returns the data-array, see getFileSize
 		 */
-		const std::vector<uint8_t> getData(){ return m_Data; }
+		const uint8_t* getData() const { return m_pData; }
+
+		/**
+		 * @brief Whether the object-readers should also put every property they read into the text-map of the
+		 *		  object (ParsedZenObject::properties). Off by default, so only the typed fields are filled.
+		 *		  Tools and exporters which want to list all properties need to turn this on.
+		 */
+		void setReadPropertyStrings(bool enable) { m_ReadPropertyStrings = enable; }
+		bool getReadPropertyStrings() const { return m_ReadPropertyStrings; }
 
 		/**
 		* @brief Returns the parsed world-mesh
@@ -152,7 +186,7 @@ namespace ZenConvert
 		/**
 		* @brief returns the total size of the loaded file
 		*/
-		size_t getFileSize(){ return m_Data.size(); }
+		size_t getFileSize() const { return m_DataSize; }
 
 		/**
 		* @brief Reads one structure of type T. Watch for alignment!
@@ -160,7 +194,7 @@ namespace ZenConvert
 		template<typename T>
 		void readStructure(T& s) 
 		{
-			s = *reinterpret_cast<T*>(&m_Data[m_Seek]);
+			s = *reinterpret_cast<const T*>(&m_pData[m_Seek]);
 			m_Seek += sizeof(T);
 		}
 
@@ -191,6 +225,12 @@ namespace ZenConvert
 		*/
 		void readHeader();
 
+		/**
+		* @brief Takes over the header the given parser has read, instead of reading it again. Both parsers have to
+		*		 work on the same data. Tables read with the header are shared, not copied.
+		*/
+		void copyHeader(const ZenParser& other);
+
 		/**
 		 * @brief reads the main oCWorld-Object, found in the level-zens
 		 */
@@ -200,6 +240,11 @@ namespace ZenConvert
 		* @brief reads the worldmesh-chunk
 		*/
 		void readWorldMesh();
+
+		/**
+		* @brief moves past the worldmesh-chunk without reading it
+		*/
+		void skipWorldMesh();
 	private:	
 
 		
@@ -215,11 +260,18 @@ namespace ZenConvert
 		ParserImpl* m_pParserImpl;
 
 		/**
-		 * @brief Data currently loaded and the current stream position
+		 * @brief Data currently loaded and the current stream position. m_pData either points into m_DataStorage,
+		 *		  when this parser read the file itself, or to the memory given by the creator.
 		 */
-		std::vector<uint8_t> m_Data;
+		const uint8_t* m_pData;
+		size_t m_DataSize;
 		size_t m_Seek;
 
+		/**
+		 * @brief Holds the file-data, if this parser loaded it
+		 */
+		std::vector<uint8_t> m_DataStorage;
+
 		/**
 		 * @brief ZEN-Header of the loaded file
 		 */
@@ -230,6 +282,11 @@ namespace ZenConvert
 		*/
 		zCMesh* m_pWorldMesh;
 
+		/**
+		 * @brief See setReadPropertyStrings
+		 */
+		bool m_ReadPropertyStrings;
+
     };
 
 
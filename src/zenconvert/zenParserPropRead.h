@@ -1,133 +1,250 @@
 #pragma once
 #include "zenParser.h"
 #include "parserImpl.h"
+#include <stdexcept>
 
 namespace ZenConvert
 {
 	/**
-	* @brief Templated function-calls to read the right type of data 
-	*		  and convert it to a string for the given type
+	* @brief Templated function-calls to read the right type of data
 	*/
 	template<typename T> 
-	static void read(ZenParser& p, std::string& outStr, T& outData){return "INVALID DATATYPE";}
+	static void read(ZenParser& p, T& outData){static_assert(sizeof(T) == 0, "INVALID DATATYPE");}
 
 	template<> 
-    inline void read<float>(ZenParser& p, std::string& outStr, float& outData)
+    inline void read<float>(ZenParser& p, float& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(float), ParserImpl::ZVT_FLOAT);
-		outStr = std::to_string(outData);
     }
 
 	template<> 
-    inline void read<bool>(ZenParser& p, std::string& outStr, bool& outData)
+    inline void read<bool>(ZenParser& p, bool& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(bool), ParserImpl::ZVT_BOOL);
-		outStr = std::to_string(outData ? 1 : 0);
     }
 
 	template<> 
-    inline void read<uint32_t>(ZenParser& p, std::string& outStr, uint32_t& outData)
+    inline void read<uint32_t>(ZenParser& p, uint32_t& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(uint32_t), ParserImpl::ZVT_INT);
-		outStr = std::to_string(outData);
     }
 
 	template<> 
-    inline void read<int32_t>(ZenParser& p, std::string& outStr, int32_t& outData)
+    inline void read<int32_t>(ZenParser& p, int32_t& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(int32_t), ParserImpl::ZVT_INT);
-		outStr = std::to_string(outData);
     }
 
 	template<> 
-    inline void read<uint16_t>(ZenParser& p, std::string& outStr, uint16_t& outData)
+    inline void read<uint16_t>(ZenParser& p, uint16_t& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(uint16_t), ParserImpl::ZVT_WORD);
-		outStr = std::to_string(outData);
     }
 
 	template<> 
-    inline void read<uint8_t>(ZenParser& p, std::string& outStr, uint8_t& outData)
+    inline void read<uint8_t>(ZenParser& p, uint8_t& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(uint16_t), ParserImpl::ZVT_BYTE);
-		outStr = std::to_string(outData);
     }
 
 	template<> 
-    inline void read<Math::float2>(ZenParser& p, std::string& outStr, Math::float2& outData)
+    inline void read<Math::float2>(ZenParser& p, Math::float2& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData.x, sizeof(float), ParserImpl::ZVT_FLOAT);
 		p.getImpl()->readEntry("", &outData.y, sizeof(float), ParserImpl::ZVT_FLOAT);
-		outStr = "[" + std::to_string(outData.x) + ", " + std::to_string(outData.y) + "]";
     }
 
 	template<> 
-    inline void read<Math::float3>(ZenParser& p, std::string& outStr, Math::float3& outData)
+    inline void read<Math::float3>(ZenParser& p, Math::float3& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData, sizeof(float) * 3, ParserImpl::ZVT_VEC3);
-		outStr = "[" + std::to_string(outData.x) 
-			+ ", " + std::to_string(outData.y)
-			+ ", " + std::to_string(outData.z) + "]";
     }
 
 	template<> 
-    inline void read<Math::float4>(ZenParser& p, std::string& outStr, Math::float4& outData)
+    inline void read<Math::float4>(ZenParser& p, Math::float4& outData)
 	{ 
 		p.getImpl()->readEntry("", &outData.x, sizeof(float), ParserImpl::ZVT_FLOAT);
 		p.getImpl()->readEntry("", &outData.y, sizeof(float), ParserImpl::ZVT_FLOAT);
 		p.getImpl()->readEntry("", &outData.z, sizeof(float), ParserImpl::ZVT_FLOAT);
 		p.getImpl()->readEntry("", &outData.w, sizeof(float), ParserImpl::ZVT_FLOAT);
-		outStr = "[" + std::to_string(outData.x) 
-			+ ", " + std::to_string(outData.y)
-			+ ", " + std::to_string(outData.z)
-			+ ", " + std::to_string(outData.w) + "]";
     }
 
 	template<> 
-    inline void read<Math::Matrix>(ZenParser& p, std::string& outStr, Math::Matrix& outData)
+    inline void read<Math::Matrix>(ZenParser& p, Math::Matrix& outData)
 	{ 
 		float m[16];
 		p.getImpl()->readEntry("", m, sizeof(float) * 16, ParserImpl::ZVT_RAW_FLOAT);
 		outData = m;
+    }
+
+	template<> 
+    inline void read<std::string>(ZenParser& p, std::string& outData)
+	{ 
+		p.getImpl()->readEntry("", &outData, 0, ParserImpl::ZVT_STRING);
+    }
+
+	/**
+	* @brief Converts an already read value to the text stored in the property-map
+	*/
+	inline std::string propertyToString(float v) { return std::to_string(v); }
+	inline std::string propertyToString(bool v) { return std::to_string(v ? 1 : 0); }
+	inline std::string propertyToString(uint32_t v) { return std::to_string(v); }
+	inline std::string propertyToString(int32_t v) { return std::to_string(v); }
+	inline std::string propertyToString(uint16_t v) { return std::to_string(v); }
+	inline std::string propertyToString(uint8_t v) { return std::to_string(v); }
+	inline std::string propertyToString(const std::string& v) { return v; }
+
+	inline std::string propertyToString(const Math::float2& v)
+	{
+		return "[" + std::to_string(v.x) + ", " + std::to_string(v.y) + "]";
+	}
+
+	inline std::string propertyToString(const Math::float3& v)
+	{
+		return "[" + std::to_string(v.x) 
+			+ ", " + std::to_string(v.y)
+			+ ", " + std::to_string(v.z) + "]";
+	}
+
+	inline std::string propertyToString(const Math::float4& v)
+	{
+		return "[" + std::to_string(v.x) 
+			+ ", " + std::to_string(v.y)
+			+ ", " + std::to_string(v.z)
+			+ ", " + std::to_string(v.w) + "]";
+	}
 
-		outStr = "[";
+	inline std::string propertyToString(const Math::Matrix& v)
+	{
+		std::string outStr = "[";
 		for(size_t i = 0; i < 16; i++)
 		{
-			outStr += std::to_string(m[i]);
+			outStr += std::to_string(v.mv[i]);
 
 			// Only add "," when not at the last value
 			if(i != 15)
 				outStr += ", ";
 		}
 		outStr += "]";
-    }
 
-	template<> 
-    inline void read<std::string>(ZenParser& p, std::string& outStr, std::string& outData)
-	{ 
-		p.getImpl()->readEntry("", &outData, 0, ParserImpl::ZVT_STRING);
-		outStr = outData;
-    }
+		return outStr;
+	}
 
-	template<typename... T>
-	static void ReadObjectProperties(ZenParser& ZenParser, std::unordered_map<std::string, std::string>& rval, std::pair<const char*, T*>... d)
+	/**
+	* @brief Entry of a property-schema: A property stored as its own entry, read into member of the object-data C.
+	*		 Its type follows from the member, see read<T>. name is used in the property-map, key is the name
+	*		 of the entry in the archive.
+	*/
+	template<typename C, typename T>
+	struct PropertyField
 	{
-		auto values = std::make_tuple(d...);
-		Utils::for_each_in_tuple(values, [&](auto pair)
-		{
-			std::string outStr;
+		const char* name;
+		const char* key;
+		T C::* member;
+	};
 
-			// Read the given datatype from the file
-            read<typename std::remove_pointer<decltype(pair.second)>::type>(ZenParser, outStr, *pair.second);
+	/**
+	* @brief Entry of a property-schema: Fixed-size data stored as one raw entry of the given type, copied into
+	*		 member as it is. Not put into the property-map.
+	*/
+	template<typename C, typename T>
+	struct RawField
+	{
+		const char* name;
+		const char* key;
+		T C::* member;
+		ParserImpl::EZenValueType type;
+	};
+
+	template<typename C, typename T>
+	constexpr PropertyField<C, T> Field(const char* name, const char* key, T C::* member)
+	{
+		return PropertyField<C, T>{name, key, member};
+	}
+
+	template<typename C, typename T>
+	constexpr RawField<C, T> Raw(const char* name, const char* key, T C::* member, ParserImpl::EZenValueType type)
+	{
+		return RawField<C, T>{name, key, member, type};
+	}
+
+	template<typename C, typename T>
+	inline void readField(ZenParser& p, C& obj, const PropertyField<C, T>& field)
+	{
+		read<T>(p, obj.*field.member);
+	}
 
-			// Save the read value as string
-			rval[pair.first] = outStr; 
+	template<typename C, typename T>
+	inline void readField(ZenParser& p, C& obj, const RawField<C, T>& field)
+	{
+		p.getImpl()->readEntry("", &(obj.*field.member), sizeof(T), field.type);
+	}
+
+	template<typename C, typename T>
+	inline void writeFieldString(const C& obj, const PropertyField<C, T>& field, std::unordered_map<std::string, std::string>& rval)
+	{
+		rval[field.name] = propertyToString(obj.*field.member);
+	}
+
+	template<typename C, typename T>
+	inline void writeFieldString(const C&, const RawField<C, T>&, std::unordered_map<std::string, std::string>&)
+	{
+		// Raw data has no text-form
+	}
+
+	/**
+	* @brief Reads all properties of the given schema, in its order, into the typed fields of obj.
+	*		 A schema is a constexpr tuple of Field and Raw, see zCVob::PROPERTIES for an example.
+	*		 Only if the parser was asked to, see ZenParser::setReadPropertyStrings, the properties are also
+	*		 converted to text and put into obj.properties.
+	*		 Formats which store the names of their entries as IDs (see ParserImpl::getNextKeyId) get each entry
+	*		 checked against the field it is read into. The IDs of the field-names are only looked up once per parser.
+	*/
+	template<typename C, typename... F>
+	static void ReadObjectSchema(ZenParser& parser, C& obj, const std::tuple<F...>& schema)
+	{
+		ParserImpl* impl = parser.getImpl();
+
+		std::vector<uint32_t>& keyIds = impl->getSchemaKeyIds(&schema);
+		if(keyIds.empty())
+		{
+			keyIds.reserve(sizeof...(F));
+			Utils::for_each_in_tuple(schema, [&](const auto& field)
+			{
+				keyIds.push_back(impl->findKeyId(field.key));
+			});
+		}
+
+		bool storeStrings = parser.getReadPropertyStrings();
+		size_t i = 0;
+		Utils::for_each_in_tuple(schema, [&](const auto& field)
+		{
+			// Unnamed entries and names the archive doesn't know can't be checked
+			uint32_t nextId = impl->getNextKeyId();
+			if(keyIds[i] != ParserImpl::INVALID_KEY && nextId != ParserImpl::INVALID_KEY && nextId != keyIds[i])
+			{
+				throw std::runtime_error(std::string("Expected property ") + field.key
+					+ ", found " + std::string(impl->getKeyName(nextId)));
+			}
+			i++;
+
+			readField(parser, obj, field);
+
+			if(storeStrings)
+				writeFieldString(obj, field, obj.properties);
 		});
 	}
 
-	template<typename S>
-	static std::pair<const char*, S*> Prop(const std::string& t, S& s)
+	/**
+	* @brief Converts the already read properties of the given schema to text and puts them into rval. For objects
+	*		 whose data came in some other way, like packed vobs, or tools wanting the property-map later on.
+	*/
+	template<typename C, typename... F>
+	static void WriteObjectSchemaStrings(const C& obj, const std::tuple<F...>& schema, std::unordered_map<std::string, std::string>& rval)
 	{
-		return std::make_pair(t.c_str(), &s);
+		Utils::for_each_in_tuple(schema, [&](const auto& field)
+		{
+			writeFieldString(obj, field, rval);
+		});
 	}
 }
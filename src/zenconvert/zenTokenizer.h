@@ -0,0 +1,101 @@
+#pragma once
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace ZenConvert
+{
+	/**
+	 * @brief Allocation-free helpers for taking apart the text found in ZEN-files. All views point into the
+	 *		  input, which usually is the data of the parser.
+	 */
+	namespace Tokenizer
+	{
+		/**
+		 * @brief Cuts the next token up to the given delimiter off the front of s. Empty tokens are skipped.
+		 * @return Empty view, if there are no tokens left
+		 */
+		inline std::string_view nextToken(std::string_view& s, char delim)
+		{
+			size_t start = s.find_first_not_of(delim);
+			if(start == std::string_view::npos)
+			{
+				s = std::string_view();
+				return s;
+			}
+
+			size_t end = s.find(delim, start);
+			std::string_view token = s.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+			s = end == std::string_view::npos ? std::string_view() : s.substr(end + 1);
+
+			return token;
+		}
+
+		/**
+		 * @brief Returns the last token of s, separated by the given delimiter
+		 */
+		inline std::string_view lastToken(std::string_view s, char delim)
+		{
+			size_t end = s.find_last_not_of(delim);
+			if(end == std::string_view::npos)
+				return std::string_view();
+
+			s = s.substr(0, end + 1);
+
+			size_t start = s.find_last_of(delim);
+			return start == std::string_view::npos ? s : s.substr(start + 1);
+		}
+
+		/**
+		 * @brief Returns whether s consists of digits only
+		 */
+		inline bool isNumber(std::string_view s)
+		{
+			if(s.empty())
+				return false;
+
+			for(char c : s)
+			{
+				if(c < '0' || c > '9')
+					return false;
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Parses the number at the start of s, like atoi/atof would
+		 * @return False, if s doesn't start with a number. out is left untouched then.
+		 */
+		template<typename T>
+		inline bool parseNumber(std::string_view s, T& out, int base = 10)
+		{
+			const char* end = s.data() + s.size();
+			if(!s.empty() && s.front() == '+')
+				s.remove_prefix(1);
+
+			std::from_chars_result r;
+			if constexpr(std::is_floating_point<T>::value)
+				r = std::from_chars(s.data(), end, out);
+			else
+				r = std::from_chars(s.data(), end, out, base);
+
+			return r.ec == std::errc();
+		}
+
+		/**
+		 * @brief Same as parseNumber, but throws if s doesn't start with a number
+		 */
+		template<typename T>
+		inline T toNumber(std::string_view s, int base = 10)
+		{
+			T out = T();
+			if(!parseNumber(s, out, base))
+				throw std::runtime_error("Not a number: " + std::string(s));
+
+			return out;
+		}
+	}
+}